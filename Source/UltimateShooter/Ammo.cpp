@@ -8,7 +8,9 @@
 
 #include "ShooterCharacter.h"
 
-AAmmo::AAmmo()
+// Ammo uses a static mesh, don't create the skeletal ItemMesh at all
+AAmmo::AAmmo(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.DoNotCreateDefaultSubobject(AItem::ItemMeshName))
 {
 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	//PrimaryActorTick.bCanEverTick = true;
@@ -37,68 +39,24 @@ void AAmmo::SetItemsProperties(EItemState State)
 {
 	Super::SetItemsProperties(State);
 
-	switch (State)
-	{
-		case EItemState::EIS_Pickup:
-		{
-			// Set Mesh properties
-			AmmoMesh->SetSimulatePhysics(false);
-			AmmoMesh->SetEnableGravity(false);
-			AmmoMesh->SetVisibility(true);
-			AmmoMesh->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-			AmmoMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-			break;
-		}
-		case EItemState::EIS_EquipInterping:
-		{
-			// Set Mesh properties
-			AmmoMesh->SetSimulatePhysics(false);
-			AmmoMesh->SetEnableGravity(false);
-			AmmoMesh->SetVisibility(true);
-			AmmoMesh->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-			AmmoMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-			break;
-		}
-		case EItemState::EIS_PickedUp:
-		{
-			break;
-		}
-		case EItemState::EIS_Equipped:
-		{
-			//if (PickupWidget) { PickupWidget->SetVisibility(false); }
-			// Set Mesh properties
-			AmmoMesh->SetSimulatePhysics(false);
-			AmmoMesh->SetEnableGravity(false);
-			AmmoMesh->SetVisibility(true);
-			AmmoMesh->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-			AmmoMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-			break;
-		}
-		case EItemState::EIS_Falling:
-		{
-			// Set Mesh properties
-			AmmoMesh->SetSimulatePhysics(true);
-			AmmoMesh->SetEnableGravity(true);
-			AmmoMesh->SetVisibility(true);
-			AmmoMesh->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-			AmmoMesh->SetCollisionResponseToChannel(ECollisionChannel::ECC_WorldDynamic, ECollisionResponse::ECR_Block);
-			AmmoMesh->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
-			break;
-		}
-	}
+	SetMeshProperties(AmmoMesh, State);
 }
 
 void AAmmo::OnAmmoSphereOverlap(UPrimitiveComponent* OverlappedComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
 {
 	if (!OtherActor) return;
+	// Already collected by another pickup this frame
+	if (IsActorBeingDestroyed() || GetItemState() != EItemState::EIS_Pickup) return;
 	
 	AShooterCharacter* OverlappedCharacter = Cast<AShooterCharacter>(OtherActor);
 	if (OverlappedCharacter)
 	{
-		StartItemCurve(OverlappedCharacter);
 		AmmoCollisionSphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+		if (OverlappedCharacter->GetBatchAmmoPickup()) { OverlappedCharacter->VacuumAmmo(this); }
+		else { StartItemCurve(OverlappedCharacter); }
 	}
-	
+
 }
 
 void AAmmo::Tick(float DeltaTime)
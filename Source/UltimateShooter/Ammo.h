@@ -16,7 +16,7 @@ class ULTIMATESHOOTER_API AAmmo : public AItem
 	GENERATED_BODY()
 
 public:
-	AAmmo();
+	AAmmo(const FObjectInitializer& ObjectInitializer);
 
 protected:
 	// Called when the game starts or when spawned
@@ -48,7 +48,14 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Ammo, meta = (AllowPrivateAccess = "true"))
 	class USphereComponent* AmmoCollisionSphere;
 
+	/** Ammo of every pickup collected together with this one, by type */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Ammo, meta = (AllowPrivateAccess = "true"))
+	TMap<EAmmoType, int32> BatchedAmmo;
+
 public:
 	FORCEINLINE UStaticMeshComponent* GetAmmoMesh() const { return AmmoMesh; }
 	FORCEINLINE EAmmoType GetAmmoType() const { return AmmoType; }
+
+	FORCEINLINE const TMap<EAmmoType, int32>& GetBatchedAmmo() const { return BatchedAmmo; }
+	FORCEINLINE void SetBatchedAmmo(TMap<EAmmoType, int32>&& Ammo) { BatchedAmmo = MoveTemp(Ammo); }
 };
@@ -10,21 +10,29 @@
 #include "Sound/SoundCue.h"
 
 #include "ShooterCharacter.h"
+#include "ItemBudgetSubsystem.h"
+#include "ShooterAudioSubsystem.h"
+#include "ShooterFrameGovernorSubsystem.h"
+
+#include "UltimateShooter.h"
+
+const FName AItem::ItemMeshName(TEXT("ItemMesh"));
 
 // Sets default values
-AItem::AItem()
-	: ItemName(FString("Default")), ItemCount(0), ItemRarity(EItemRarity::EIR_Common), ItemState(EItemState::EIS_Pickup),
-	ItemIterpStartLocation(FVector(0.f)), CameraTargetLocation(FVector(0.f)), bInterping(false), ZCurveTime(0.7f),
+AItem::AItem(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer), ItemName(FString("Default")), ItemCount(0), ItemRarity(EItemRarity::EIR_Common), ItemState(EItemState::EIS_Pickup),
+	ItemIterpStartLocation(FVector(0.f)), CameraTargetLocation(FVector(0.f)), bInterping(false), PendingInterpTime(0.f), ZCurveTime(0.7f),
 	ItemInterpX(0.f), ItemInterpY(0.f), InterpInitialYawOffset(0.f), ItemType(EItemType::EIT_MAX), InterpLocationIndex(0)
 {
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
 
-	ItemMesh = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("ItemMesh"));
-	SetRootComponent(ItemMesh);
+	// Subclasses with their own mesh skip this one and set their own root
+	ItemMesh = CreateOptionalDefaultSubobject<USkeletalMeshComponent>(ItemMeshName);
+	if (ItemMesh) { SetRootComponent(ItemMesh); }
 
 	CollisionBox = CreateDefaultSubobject<UBoxComponent>(TEXT("CollisionBox"));
-	CollisionBox->SetupAttachment(ItemMesh);
+	CollisionBox->SetupAttachment(GetRootComponent());
 
 	PickupWidget = CreateDefaultSubobject<UWidgetComponent>(TEXT("PickupWidget")); 
 	PickupWidget->SetupAttachment(GetRootComponent());
@@ -50,6 +58,32 @@ void AItem::BeginPlay()
 
 	// Set Items properties based on ItemState
 	SetItemsProperties(ItemState);
+
+	// Lying in the world counts against the item budget
+	if (UItemBudgetSubsystem* ItemBudget = GetWorld()->GetSubsystem<UItemBudgetSubsystem>()) { ItemBudget->UpdateItem(this); }
+}
+
+void AItem::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Destroyed or evicted mid interp, give the slot back to the character
+	if (bInterping && IsValid(Character))
+	{
+		Character->IncrementInterpLocationCount(InterpLocationIndex, -1);
+		bInterping = false;
+	}
+
+	if (UItemBudgetSubsystem* ItemBudget = GetWorld()->GetSubsystem<UItemBudgetSubsystem>()) { ItemBudget->RemoveItem(this); }
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AItem::SetItemState(EItemState State)
+{
+	ItemState = State;
+	SetItemsProperties(State);
+
+	if (!HasActorBegunPlay()) return;
+	if (UItemBudgetSubsystem* ItemBudget = GetWorld()->GetSubsystem<UItemBudgetSubsystem>()) { ItemBudget->UpdateItem(this); }
 }
 
 void AItem::OnSphereOverlap(UPrimitiveComponent* OverlappedComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
@@ -120,18 +154,23 @@ void AItem::SetActiveStars()
 	}
 }
 
+void AItem::SetItemRarity(EItemRarity Rarity)
+{
+	if (Rarity == ItemRarity) return;
+	ItemRarity = Rarity;
+
+	ActiveStars.Reset();
+	SetActiveStars();
+}
+
 void AItem::SetItemsProperties(EItemState State)
 {
+	SetMeshProperties(ItemMesh, State);
+
 	switch (State)
 	{
 		case EItemState::EIS_Pickup:
 		{
-			// Set Mesh properties
-			ItemMesh->SetSimulatePhysics(false);
-			ItemMesh->SetEnableGravity(false);
-			ItemMesh->SetVisibility(true);
-			ItemMesh->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-			ItemMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 			// Set Area Sphere properties
 			AreaSphere->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Overlap);
 			AreaSphere->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
@@ -142,13 +181,9 @@ void AItem::SetItemsProperties(EItemState State)
 			break;
 		}
 		case EItemState::EIS_EquipInterping:
+		case EItemState::EIS_Equipped:
+		case EItemState::EIS_Falling:
 		{
-			// Set Mesh properties
-			ItemMesh->SetSimulatePhysics(false);
-			ItemMesh->SetEnableGravity(false);
-			ItemMesh->SetVisibility(true);
-			ItemMesh->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-			ItemMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 			// Set Area Sphere properties
 			AreaSphere->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
 			AreaSphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
@@ -161,47 +196,48 @@ void AItem::SetItemsProperties(EItemState State)
 		{
 			break;
 		}
+	}
+
+}
+
+void AItem::SetMeshProperties(UPrimitiveComponent* Mesh, EItemState State)
+{
+	if (!Mesh) return;
+
+	switch (State)
+	{
+		case EItemState::EIS_Pickup:
+		case EItemState::EIS_EquipInterping:
 		case EItemState::EIS_Equipped:
 		{
-			//if (PickupWidget) { PickupWidget->SetVisibility(false); }
-			// Set Mesh properties
-			ItemMesh->SetSimulatePhysics(false);
-			ItemMesh->SetEnableGravity(false);
-			ItemMesh->SetVisibility(true);
-			ItemMesh->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-			ItemMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-			// Set Area Sphere properties
-			AreaSphere->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-			AreaSphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-			// Set Collision Box properties
-			CollisionBox->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-			CollisionBox->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+			Mesh->SetSimulatePhysics(false);
+			Mesh->SetEnableGravity(false);
+			Mesh->SetVisibility(true);
+			Mesh->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
+			Mesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+			break;
+		}
+		case EItemState::EIS_PickedUp:
+		{
 			break;
 		}
 		case EItemState::EIS_Falling:
 		{
-			// Set Mesh properties
-			ItemMesh->SetSimulatePhysics(true);
-			ItemMesh->SetEnableGravity(true);
-			ItemMesh->SetVisibility(true);
-			ItemMesh->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-			ItemMesh->SetCollisionResponseToChannel(ECollisionChannel::ECC_WorldDynamic, ECollisionResponse::ECR_Block);
-			ItemMesh->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
-			// Set Area Sphere properties
-			AreaSphere->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-			AreaSphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-			// Set Collision Box properties
-			CollisionBox->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-			CollisionBox->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+			Mesh->SetSimulatePhysics(true);
+			Mesh->SetEnableGravity(true);
+			Mesh->SetVisibility(true);
+			Mesh->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
+			Mesh->SetCollisionResponseToChannel(ECollisionChannel::ECC_WorldDynamic, ECollisionResponse::ECR_Block);
+			Mesh->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
 			break;
 		}
 	}
-
 }
 
 void AItem::FinishInterping()
 {
 	bInterping = false;
+	CSV_CUSTOM_STAT(ShooterGameplay, PickupsCompleted, 1, ECsvCustomStatOp::Accumulate);
 	if (Character)
 	{
 		Character->IncrementInterpLocationCount(InterpLocationIndex, -1);
@@ -264,30 +300,17 @@ FVector AItem::GetInterpLocation()
 {
 	if (!Character) return FVector(0.f);
 
-	switch (ItemType)
-	{
-		case EItemType::EIT_Ammo:
-		{
-			return Character->GetInterpLocation(InterpLocationIndex).SceneComponent->GetComponentLocation();
-			break;
-		}
-		case EItemType::EIT_Weapon:
-		{
-			return Character->GetInterpLocation(0).SceneComponent->GetComponentLocation();
-			break;
-		}
-	}
-	return FVector(0.f);
+	return Character->GetInterpLocation(InterpLocationIndex);
 }
 
 void AItem::PlayPickupSound()
 {
 	if (!Character) return;
 	
-	if (Character->GetShouldPlayPickupSound())
+	// Spam is limited by the pickup category retrigger interval
+	if (UShooterAudioSubsystem* CombatAudio = UShooterAudioSubsystem::Get(this))
 	{
-		Character->StartPickupSoundTimer();
-		if (PickupSound) { UGameplayStatics::PlaySound2D(this, PickupSound); }
+		CombatAudio->PlayCombatSound(ECombatSoundCategory::ECSC_Pickup, PickupSound, Character, GetActorLocation());
 	}
 }
 
@@ -295,10 +318,9 @@ void AItem::PlayEquipSound()
 {
 	if (!Character) return;
 
-	if (Character->GetShouldPlayEquipSound())
+	if (UShooterAudioSubsystem* CombatAudio = UShooterAudioSubsystem::Get(this))
 	{
-		Character->StartEquipSoundTimer();
-		if (PickupSound) { UGameplayStatics::PlaySound2D(this, PickupSound); }
+		CombatAudio->PlayCombatSound(ECombatSoundCategory::ECSC_Equip, EquipSound, Character, GetActorLocation());
 	}
 }
 
@@ -307,16 +329,29 @@ void AItem::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
-	ItemInterp(DeltaTime);
+	if (!bInterping) return;
+	// Counted before the throttle, an item skipping this frame is still interping
+	CSV_CUSTOM_STAT(ShooterGameplay, ItemsInterping, 1, ECsvCustomStatOp::Accumulate);
+
+	// Throttled under load, the skipped time is caught up on the next update
+	PendingInterpTime += DeltaTime;
+	// Offset per item so the throttled pickups don't all update on the same frame
+	if ((GFrameCounter + GetUniqueID()) % UShooterFrameGovernorSubsystem::GetPickupInterpInterval(this) != 0) return;
+
+	ItemInterp(PendingInterpTime);
+	PendingInterpTime = 0.f;
 }
 
 void AItem::StartItemCurve(AShooterCharacter* ShooterCharacter)
 {
 	bInterping = true;
+	PendingInterpTime = 0.f;
+	CSV_CUSTOM_STAT(ShooterGameplay, PickupsStarted, 1, ECsvCustomStatOp::Accumulate);
 	SetItemState(EItemState::EIS_EquipInterping);
 	// Store a ref to Character
 	Character = ShooterCharacter;
-	InterpLocationIndex = Character->GetInterpLocationIndex();
+	// Weapons always go to slot 0, other items take a free slot
+	InterpLocationIndex = (ItemType == EItemType::EIT_Weapon) ? 0 : Character->GetInterpLocationIndex();
 	// Add one to the item Count for this interp Location struct
 	Character->IncrementInterpLocationCount(InterpLocationIndex, 1);
 
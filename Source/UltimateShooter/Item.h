@@ -47,11 +47,15 @@ class ULTIMATESHOOTER_API AItem : public AActor
 	
 public:	
 	// Sets default values for this actor's properties
-	AItem();
+	AItem(const FObjectInitializer& ObjectInitializer);
+
+	// Name of the optional skeletal ItemMesh, subclasses with their own mesh skip it with DoNotCreateDefaultSubobject
+	static const FName ItemMeshName;
 
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 	// We need all this parameters when we are using functions with AddDynamic
 	UFUNCTION()
@@ -63,6 +67,8 @@ protected:
 	void SetActiveStars();
 	// Sets properties of the item's component  based on state
 	virtual void SetItemsProperties(EItemState State);
+	// Sets mesh physics, visibility and collision based on state
+	static void SetMeshProperties(UPrimitiveComponent* Mesh, EItemState State);
 	// Called when ItemInterpTimer is finished
 	void FinishInterping();
 
@@ -79,7 +85,7 @@ public:
 	virtual void Tick(float DeltaTime) override;
 
 private:
-	/** Skeletal Mesh for the item */
+	/** Skeletal Mesh for the item (null for items using another mesh type) */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Item Properties", meta = (AllowPrivateAccess = "true"))
 	USkeletalMeshComponent* ItemMesh;
 	/** Line Trace collides with box to show HUD widgets */
@@ -119,6 +125,8 @@ private:
 	FVector CameraTargetLocation;
 	// True when interping
 	bool bInterping;
+	// Delta time of the interp updates skipped by the frame governor
+	float PendingInterpTime;
 	// PLays when we start interping
 	FTimerHandle ItemInterpTimer;
 	// Duration of the curve and timer
@@ -158,7 +166,7 @@ public:
 	FORCEINLINE UBoxComponent* GetCollisionBox() const { return CollisionBox; }
 
 	FORCEINLINE EItemState GetItemState() const { return ItemState; }
-	void SetItemState(EItemState State) { ItemState = State; SetItemsProperties(State); }
+	void SetItemState(EItemState State);
 
 	FORCEINLINE USkeletalMeshComponent* GetItemMesh() const { return ItemMesh; }
 
@@ -169,6 +177,11 @@ public:
 	FORCEINLINE USoundCue* GetEquipSound() const { return EquipSound; }
 
 	FORCEINLINE int32 GetItemCount() const { return ItemCount; }
+	FORCEINLINE void SetItemCount(int32 Count) { ItemCount = Count; }
+
+	FORCEINLINE EItemRarity GetItemRarity() const { return ItemRarity; }
+	// Sets the rarity and the active stars that show it
+	void SetItemRarity(EItemRarity Rarity);
 
 	void PlayEquipSound();
 };
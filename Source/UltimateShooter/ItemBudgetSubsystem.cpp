@@ -0,0 +1,218 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ItemBudgetSubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "TimerManager.h"
+#include "EngineUtils.h"
+
+#include "UltimateShooter.h"
+#include "Item.h"
+#include "Weapon.h"
+
+static TAutoConsoleVariable<int32> CVarMaxSimulatingWeapons(
+	TEXT("Shooter.Weapon.MaxSimulating"),
+	8,
+	TEXT("Maximum number of dropped weapons simulating physics at once, the oldest ones are frozen in place"));
+
+static FAutoConsoleCommandWithWorld GItemBudgetCommand(
+	TEXT("Shooter.Items.Budget"),
+	TEXT("Logs the world item budget and eviction counters"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UItemBudgetSubsystem* Budget = World ? World->GetSubsystem<UItemBudgetSubsystem>() : nullptr) { Budget->LogBudget(); }
+	}));
+
+static FAutoConsoleCommandWithWorld GItemMemoryReportCommand(
+	TEXT("Shooter.Items.MemoryReport"),
+	TEXT("Logs instance count, components and estimated bytes of every item class in the world"),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&UItemBudgetSubsystem::LogItemMemoryReport));
+
+bool UItemBudgetSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UItemBudgetSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	InWorld.GetTimerManager().SetTimer(BudgetTimer, this, &UItemBudgetSubsystem::EnforceBudget, FMath::Max(BudgetCheckInterval, 0.1f), true);
+}
+
+void UItemBudgetSubsystem::Deinitialize()
+{
+	if (UWorld* World = GetWorld()) { World->GetTimerManager().ClearTimer(BudgetTimer); }
+
+	TrackedItems.Empty();
+	TrackedBytes = 0;
+	SimulatingWeapons.Empty();
+
+	Super::Deinitialize();
+}
+
+void UItemBudgetSubsystem::UpdateItem(AItem* Item)
+{
+	if (!Item) return;
+
+	const EItemState State{ Item->GetItemState() };
+	if (State != EItemState::EIS_Pickup && State != EItemState::EIS_Falling)
+	{
+		RemoveItem(Item);
+		return;
+	}
+
+	FTrackedItem* Tracked = TrackedItems.Find(Item);
+	if (!Tracked)
+	{
+		// Pickups placed in the level are there on purpose, they only count once a player has dropped them
+		if (Item->IsNetStartupActor() && State == EItemState::EIS_Pickup) return;
+
+		Tracked = &TrackedItems.Add(Item);
+		Tracked->Item = Item;
+		Tracked->EstimatedBytes = EstimateActorBytes(Item);
+		TrackedBytes += Tracked->EstimatedBytes;
+	}
+	Tracked->LastInteractionTime = GetWorld()->GetTimeSeconds();
+}
+
+void UItemBudgetSubsystem::TouchItem(AItem* Item)
+{
+	if (FTrackedItem* Tracked = TrackedItems.Find(Item))
+	{
+		Tracked->LastInteractionTime = GetWorld()->GetTimeSeconds();
+	}
+}
+
+void UItemBudgetSubsystem::RemoveItem(AItem* Item)
+{
+	FTrackedItem Removed;
+	if (TrackedItems.RemoveAndCopyValue(Item, Removed))
+	{
+		TrackedBytes -= Removed.EstimatedBytes;
+	}
+}
+
+void UItemBudgetSubsystem::AddSimulatingWeapon(AWeapon* Weapon)
+{
+	SimulatingWeapons.RemoveAll([](const TWeakObjectPtr<AWeapon>& Simulating) { return !Simulating.IsValid() || !Simulating->IsFalling(); });
+	SimulatingWeapons.AddUnique(Weapon);
+
+	const int32 MaxSimulating{ FMath::Max(CVarMaxSimulatingWeapons.GetValueOnGameThread(), 1) };
+	while (SimulatingWeapons.Num() > MaxSimulating)
+	{
+		// Removes it from SimulatingWeapons
+		SimulatingWeapons[0]->StopFalling();
+	}
+}
+
+void UItemBudgetSubsystem::RemoveSimulatingWeapon(AWeapon* Weapon)
+{
+	SimulatingWeapons.Remove(Weapon);
+}
+
+int64 UItemBudgetSubsystem::EstimateActorBytes(const AActor* Actor, int32* OutNumComponents)
+{
+	if (!Actor) return 0;
+
+	int64 Bytes{ Actor->GetClass()->GetStructureSize() };
+	int32 NumComponents{ 0 };
+
+	Actor->ForEachComponent(false, [&Bytes, &NumComponents](UActorComponent* Component)
+	{
+		Bytes += Component->GetClass()->GetStructureSize();
+		Bytes += Component->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+		NumComponents++;
+	});
+
+	if (OutNumComponents) { *OutNumComponents = NumComponents; }
+	return Bytes;
+}
+
+void UItemBudgetSubsystem::EnforceBudget()
+{
+	const int64 MaxBytes{ static_cast<int64>(MaxWorldItemMemoryMB * 1024.f * 1024.f) };
+	if (TrackedItems.Num() <= MaxWorldItems && TrackedBytes <= MaxBytes) return;
+
+	// Least recently interacted first
+	TArray<FTrackedItem> Candidates;
+	TrackedItems.GenerateValueArray(Candidates);
+	Candidates.Sort([](const FTrackedItem& A, const FTrackedItem& B) { return A.LastInteractionTime < B.LastInteractionTime; });
+
+	for (const FTrackedItem& Candidate : Candidates)
+	{
+		const bool bOverCount{ TrackedItems.Num() > MaxWorldItems };
+		const bool bOverMemory{ TrackedBytes > MaxBytes };
+		if (!bOverCount && !bOverMemory) break;
+
+		AItem* Item = Candidate.Item.Get();
+		if (!Item || !IsOutOfView(Item)) continue;
+
+		if (bOverCount) { NumEvictedForCount++; }
+		else { NumEvictedForMemory++; }
+
+		RemoveItem(Item);
+		Item->Destroy();
+	}
+}
+
+bool UItemBudgetSubsystem::IsOutOfView(const AItem* Item) const
+{
+	if (Item->WasRecentlyRendered(EvictRenderTolerance)) return false;
+
+	const FVector ItemLocation{ Item->GetActorLocation() };
+	const float MinDistanceSquared{ FMath::Square(MinEvictDistance) };
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (!PlayerController) continue;
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+		if (FVector::DistSquared(ViewLocation, ItemLocation) < MinDistanceSquared) return false;
+	}
+
+	return true;
+}
+
+void UItemBudgetSubsystem::GatherItemMemoryStats(UWorld* World, TMap<UClass*, FItemClassMemoryStats>& OutStats)
+{
+	if (!World) return;
+
+	for (TActorIterator<AItem> It(World); It; ++It)
+	{
+		int32 NumComponents{ 0 };
+		const int64 Bytes{ EstimateActorBytes(*It, &NumComponents) };
+
+		FItemClassMemoryStats& Stats = OutStats.FindOrAdd(It->GetClass());
+		Stats.NumInstances++;
+		Stats.NumComponents += NumComponents;
+		Stats.Bytes += Bytes;
+	}
+}
+
+void UItemBudgetSubsystem::LogItemMemoryReport(UWorld* World)
+{
+	TMap<UClass*, FItemClassMemoryStats> Stats;
+	GatherItemMemoryStats(World, Stats);
+
+	UE_LOG(LogUltimateShooter, Log, TEXT("%-40s %10s %12s %14s %12s"), TEXT("Class"), TEXT("Instances"), TEXT("Components"), TEXT("Bytes"), TEXT("Bytes/Item"));
+	for (const TPair<UClass*, FItemClassMemoryStats>& Pair : Stats)
+	{
+		const FItemClassMemoryStats& ClassStats = Pair.Value;
+		UE_LOG(LogUltimateShooter, Log, TEXT("%-40s %10d %12d %14lld %12lld"), *Pair.Key->GetName(), ClassStats.NumInstances, ClassStats.NumComponents,
+			ClassStats.Bytes, ClassStats.NumInstances > 0 ? ClassStats.Bytes / ClassStats.NumInstances : 0);
+	}
+}
+
+void UItemBudgetSubsystem::LogBudget() const
+{
+	UE_LOG(LogUltimateShooter, Log, TEXT("Item budget: %d / %d items, %.2f / %.2f MB, evicted %d (count %d, memory %d)"),
+		TrackedItems.Num(), MaxWorldItems, TrackedBytes / (1024.0 * 1024.0), MaxWorldItemMemoryMB,
+		GetNumEvicted(), NumEvictedForCount, NumEvictedForMemory);
+}
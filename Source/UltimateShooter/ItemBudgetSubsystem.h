@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ItemBudgetSubsystem.generated.h"
+
+// Memory used by all the items of one class
+struct FItemClassMemoryStats
+{
+	int32 NumInstances{ 0 };
+	int32 NumComponents{ 0 };
+	int64 Bytes{ 0 };
+};
+
+/**
+ * Keeps the number and memory of items lying in the world (EIS_Pickup / EIS_Falling) under a budget.
+ * Only items spawned or dropped at runtime count, pickups loaded with the level are left alone.
+ * When the budget is exceeded the least recently interacted items out of every player's view are destroyed.
+ */
+UCLASS(Config = Game)
+class ULTIMATESHOOTER_API UItemBudgetSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	// Called when an item changes state, tracks it while it is lying in the world
+	void UpdateItem(class AItem* Item);
+	// Called when a player interacts with the item (looks at it, drops it...)
+	void TouchItem(class AItem* Item);
+	// Called when the item leaves the world
+	void RemoveItem(class AItem* Item);
+
+	// Thrown weapons simulating physics, over Shooter.Weapon.MaxSimulating the oldest ones are frozen in place
+	void AddSimulatingWeapon(class AWeapon* Weapon);
+	void RemoveSimulatingWeapon(class AWeapon* Weapon);
+
+	// Rough instance memory of an actor and its components (shared assets not included)
+	static int64 EstimateActorBytes(const AActor* Actor, int32* OutNumComponents = nullptr);
+	// Instances, components and bytes of every item class in the world
+	static void GatherItemMemoryStats(UWorld* World, TMap<UClass*, FItemClassMemoryStats>& OutStats);
+	static void LogItemMemoryReport(UWorld* World);
+
+	UFUNCTION(BlueprintCallable, Category = "Item Budget")
+	int32 GetNumTrackedItems() const { return TrackedItems.Num(); }
+	UFUNCTION(BlueprintCallable, Category = "Item Budget")
+	int64 GetTrackedBytes() const { return TrackedBytes; }
+	UFUNCTION(BlueprintCallable, Category = "Item Budget")
+	int32 GetNumEvicted() const { return NumEvictedForCount + NumEvictedForMemory; }
+	UFUNCTION(BlueprintCallable, Category = "Item Budget")
+	int32 GetNumEvictedForCount() const { return NumEvictedForCount; }
+	UFUNCTION(BlueprintCallable, Category = "Item Budget")
+	int32 GetNumEvictedForMemory() const { return NumEvictedForMemory; }
+
+	void LogBudget() const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	// Evicts items until the world is back under budget
+	void EnforceBudget();
+	// True if no player can see the item
+	bool IsOutOfView(const class AItem* Item) const;
+
+private:
+	struct FTrackedItem
+	{
+		TWeakObjectPtr<class AItem> Item;
+		double LastInteractionTime{ 0.0 };
+		int64 EstimatedBytes{ 0 };
+	};
+
+	TMap<const class AItem*, FTrackedItem> TrackedItems;
+	int64 TrackedBytes{ 0 };
+
+	// Thrown weapons still simulating, oldest first
+	TArray<TWeakObjectPtr<class AWeapon>> SimulatingWeapons;
+
+	int32 NumEvictedForCount{ 0 };
+	int32 NumEvictedForMemory{ 0 };
+
+	FTimerHandle BudgetTimer;
+
+	// Maximum number of items lying in the world
+	UPROPERTY(Config)
+	int32 MaxWorldItems{ 256 };
+	// Maximum memory used by items lying in the world
+	UPROPERTY(Config)
+	float MaxWorldItemMemoryMB{ 32.f };
+	// Seconds between budget checks
+	UPROPERTY(Config)
+	float BudgetCheckInterval{ 1.f };
+	// Items closer than this to a player are never evicted
+	UPROPERTY(Config)
+	float MinEvictDistance{ 2500.f };
+	// Items rendered in the last seconds are never evicted
+	UPROPERTY(Config)
+	float EvictRenderTolerance{ 2.f };
+};
@@ -11,7 +11,8 @@ UShooterAnimInstance::UShooterAnimInstance()
 	: Speed(0.f), bIsInAir(false), bIsAccelerating(false), MovementOffsetYaw(0.f), LastMovementOffsetYaw(0.f), bAiming(false),
 	CharacterYaw(0.f), CharacterYawLastFrame(0.f), RootYawOffset(0.f), RotationCurveLastFrame(0.0f), RotationCurve(0.0f), Pitch(0.0f),
 	bReloading(false), OffsetState(EOffsetState::EOS_Hip), CharacterRotation(FRotator(0.f)), CharacterRotationLastFrame(FRotator(0.f)), YawDelta(0.f),
-	RecoilWeight(1.f), bTurningInPlace(false)
+	RecoilWeight(1.f), bTurningInPlace(false), PendingShotImpulse(0.f), ShotImpulse(0.f), RecoilVelocity(0.f), RecoilAlpha(0.f), RecoilPitch(0.f),
+	RecoilStiffness(400.f), RecoilDampingRatio(0.6f), RecoilShotImpulse(12.f), RecoilMaxPitch(4.f)
 {
 }
 
@@ -180,4 +181,44 @@ void UShooterAnimInstance::NativeInitializeAnimation()
 	ShooterCharacter = Cast<AShooterCharacter>(TryGetPawnOwner());
 }
 
+void UShooterAnimInstance::AddShotImpulse(float Scale)
+{
+	PendingShotImpulse += Scale;
+}
+
+void UShooterAnimInstance::NativeUpdateAnimation(float DeltaSeconds)
+{
+	Super::NativeUpdateAnimation(DeltaSeconds);
+
+	// Hand the shots over, the thread safe update can run while the game thread fires again
+	ShotImpulse = PendingShotImpulse;
+	PendingShotImpulse = 0.f;
+}
+
+void UShooterAnimInstance::NativeThreadSafeUpdateAnimation(float DeltaSeconds)
+{
+	Super::NativeThreadSafeUpdateAnimation(DeltaSeconds);
 
+	RecoilVelocity += ShotImpulse * RecoilShotImpulse;
+	ShotImpulse = 0.f;
+
+	// Damped spring, sub stepped so it stays stable at low frame rates
+	const float Damping{ 2.f * RecoilDampingRatio * FMath::Sqrt(RecoilStiffness) };
+	const int32 NumSteps{ FMath::Clamp(FMath::CeilToInt(DeltaSeconds * 120.f), 1, 8) };
+	const float StepTime{ DeltaSeconds / NumSteps };
+	for (int32 Step = 0; Step < NumSteps; ++Step)
+	{
+		RecoilVelocity += (-RecoilStiffness * RecoilAlpha - Damping * RecoilVelocity) * StepTime;
+		RecoilAlpha += RecoilVelocity * StepTime;
+	}
+
+	// Settled, keep the additive at exactly zero
+	if (FMath::Abs(RecoilAlpha) < KINDA_SMALL_NUMBER && FMath::Abs(RecoilVelocity) < KINDA_SMALL_NUMBER)
+	{
+		RecoilAlpha = 0.f;
+		RecoilVelocity = 0.f;
+	}
+
+	RecoilAlpha = FMath::Clamp(RecoilAlpha, -1.f, 1.f);
+	RecoilPitch = RecoilAlpha * RecoilMaxPitch * RecoilWeight;
+}
@@ -42,12 +42,15 @@ public:
 
 	virtual void NativeInitializeAnimation() override;    // override this function
 
+	// Kicks the recoil spring, called by the character for every shot
+	void AddShotImpulse(float Scale = 1.f);
+
 	// Native update override point. It is usually a good idea to simply gather data in this step and 
 	// for the bulk of the work to be done in NativeThreadSafeUpdateAnimation.
-	//virtual void NativeUpdateAnimation(float DeltaSeconds) override;
+	virtual void NativeUpdateAnimation(float DeltaSeconds) override;
 	// Native thread safe update override point. Executed on a worker thread just prior to graph update 
 	// for linked anim instances, only called when the hosting node(s) are relevant
-	//virtual void NativeThreadSafeUpdateAnimation(float DeltaSeconds) override;
+	virtual void NativeThreadSafeUpdateAnimation(float DeltaSeconds) override;
 	// Native Post Evaluate override point
 	//virtual void NativePostEvaluateAnimation() override;
 
@@ -119,4 +122,30 @@ private:
 	
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Combat", meta = (AllowPrivateAccess = "true"))
 	bool bTurningInPlace;
+
+	/**  Recoil */
+	// Shot impulses since the last update, written on the game thread
+	float PendingShotImpulse;
+	// Impulses handed to the thread safe update this frame
+	float ShotImpulse;
+	// Spring velocity
+	float RecoilVelocity;
+	// Recoil spring position, 0 at rest. Drives the additive fire pose in the anim graph, scaled by RecoilWeight
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Combat|Recoil", meta = (AllowPrivateAccess = "true"))
+	float RecoilAlpha;
+	// Upward kick of the weapon arm, degrees
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Combat|Recoil", meta = (AllowPrivateAccess = "true"))
+	float RecoilPitch;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Combat|Recoil", meta = (AllowPrivateAccess = "true"))
+	float RecoilStiffness;
+	// 1 returns to rest without overshoot, lower values bounce
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Combat|Recoil", meta = (AllowPrivateAccess = "true"))
+	float RecoilDampingRatio;
+	// Spring velocity added per shot
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Combat|Recoil", meta = (AllowPrivateAccess = "true"))
+	float RecoilShotImpulse;
+	// RecoilPitch at RecoilAlpha 1
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Combat|Recoil", meta = (AllowPrivateAccess = "true"))
+	float RecoilMaxPitch;
 };
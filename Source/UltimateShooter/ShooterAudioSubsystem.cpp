@@ -0,0 +1,177 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterAudioSubsystem.h"
+#include "Components/AudioComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "Kismet/GameplayStatics.h"
+#include "Sound/SoundAttenuation.h"
+#include "Sound/SoundBase.h"
+
+#include "ShooterSimulationSubsystem.h"
+#include "UltimateShooter.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Combat Audio Active Voices"), STAT_CombatAudioActiveVoices, STATGROUP_UltimateShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Combat Audio Culled Plays"), STAT_CombatAudioCulledPlays, STATGROUP_UltimateShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Combat Audio Stolen Voices"), STAT_CombatAudioStolenVoices, STATGROUP_UltimateShooter);
+
+void UShooterAudioSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	RemoteAttenuations.SetNum((uint8)ECombatSoundCategory::ECSC_MAX);
+	for (uint8 i = 0; i < (uint8)ECombatSoundCategory::ECSC_MAX; i++)
+	{
+		const FCombatSoundBudget& Budget = GetBudget((ECombatSoundCategory)i);
+		USoundAttenuation* Attenuation = Budget.RemoteAttenuation.LoadSynchronous();
+		if (!Attenuation)
+		{
+			// Simple spherical falloff up to the category cull distance
+			Attenuation = NewObject<USoundAttenuation>(this);
+			Attenuation->Attenuation.bAttenuate = true;
+			Attenuation->Attenuation.bSpatialize = true;
+			Attenuation->Attenuation.AttenuationShapeExtents = FVector(400.f, 0.f, 0.f);
+			Attenuation->Attenuation.FalloffDistance = Budget.CullDistance;
+		}
+		RemoteAttenuations[i] = Attenuation;
+	}
+}
+
+bool UShooterAudioSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+UShooterAudioSubsystem* UShooterAudioSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UShooterAudioSubsystem>() : nullptr;
+}
+
+TStatId UShooterAudioSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterAudioSubsystem, STATGROUP_Tickables);
+}
+
+void UShooterAudioSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const double Now{ GetWorld()->GetTimeSeconds() };
+	int32 ActiveVoices{ 0 };
+
+	for (uint8 i = 0; i < (uint8)ECombatSoundCategory::ECSC_MAX; i++)
+	{
+		FCategoryVoices& Category = CategoryVoices[i];
+		Category.Voices.RemoveAll([](const TWeakObjectPtr<UAudioComponent>& Voice) { return !Voice.IsValid() || !Voice->IsPlaying(); });
+		ActiveVoices += Category.Voices.Num();
+
+		// Forget sources that can play again
+		const float RetriggerInterval{ GetBudget((ECombatSoundCategory)i).RetriggerInterval };
+		for (auto It = Category.LastPlayTimes.CreateIterator(); It; ++It)
+		{
+			if (Now - It.Value() >= RetriggerInterval) { It.RemoveCurrent(); }
+		}
+	}
+
+	LastFrameActiveVoices = ActiveVoices;
+	LastFrameCulledPlays = CulledPlays;
+	LastFrameStolenVoices = StolenVoices;
+	CulledPlays = 0;
+	StolenVoices = 0;
+
+	SET_DWORD_STAT(STAT_CombatAudioActiveVoices, LastFrameActiveVoices);
+	SET_DWORD_STAT(STAT_CombatAudioCulledPlays, LastFrameCulledPlays);
+	SET_DWORD_STAT(STAT_CombatAudioStolenVoices, LastFrameStolenVoices);
+}
+
+bool UShooterAudioSubsystem::PlayCombatSound(ECombatSoundCategory Category, USoundBase* Sound, const AActor* Source, const FVector& Location)
+{
+	if (!Sound || Category == ECombatSoundCategory::ECSC_MAX) return false;
+	if (UShooterSimulationSubsystem::IsFastForwarding(this)) return false;
+
+	const FCombatSoundBudget& Budget = GetBudget(Category);
+	FCategoryVoices& Voices = CategoryVoices[(uint8)Category];
+	const double Now{ GetWorld()->GetTimeSeconds() };
+
+	// Same source played this category too recently
+	if (Budget.RetriggerInterval > 0.f && Source)
+	{
+		const double* LastPlayTime = Voices.LastPlayTimes.Find(FObjectKey(Source));
+		if (LastPlayTime && Now - *LastPlayTime < Budget.RetriggerInterval)
+		{
+			CulledPlays++;
+			return false;
+		}
+	}
+
+	const bool bLocalSource{ IsLocalSource(Source) };
+	if (!bLocalSource && !IsWithinCullDistance(Location, Budget.CullDistance))
+	{
+		CulledPlays++;
+		return false;
+	}
+
+	// Budget full, steal the oldest voice or drop this one
+	Voices.Voices.RemoveAll([](const TWeakObjectPtr<UAudioComponent>& Voice) { return !Voice.IsValid() || !Voice->IsPlaying(); });
+	if (Voices.Voices.Num() >= FMath::Max(Budget.MaxVoices, 1))
+	{
+		if (!Budget.bStealOldest)
+		{
+			CulledPlays++;
+			return false;
+		}
+
+		Voices.Voices[0]->Stop();
+		Voices.Voices.RemoveAt(0, 1, false);
+		StolenVoices++;
+	}
+
+	UAudioComponent* Voice = bLocalSource
+		? UGameplayStatics::SpawnSound2D(this, Sound)
+		: UGameplayStatics::SpawnSoundAtLocation(this, Sound, Location, FRotator::ZeroRotator, 1.f, 1.f, 0.f, RemoteAttenuations[(uint8)Category]);
+	if (!Voice) return false;
+
+	Voices.Voices.Add(Voice);
+	if (Budget.RetriggerInterval > 0.f && Source) { Voices.LastPlayTimes.Add(FObjectKey(Source), Now); }
+
+	return true;
+}
+
+const FCombatSoundBudget& UShooterAudioSubsystem::GetBudget(ECombatSoundCategory Category) const
+{
+	switch (Category)
+	{
+		case ECombatSoundCategory::ECSC_Pickup: return PickupBudget;
+		case ECombatSoundCategory::ECSC_Equip: return EquipBudget;
+		default: return FireBudget;
+	}
+}
+
+bool UShooterAudioSubsystem::IsLocalSource(const AActor* Source)
+{
+	if (!Source) return false;
+
+	const APawn* Pawn = Cast<APawn>(Source);
+	if (!Pawn) { Pawn = Cast<APawn>(Source->GetOwner()); }
+
+	return Pawn && Pawn->IsLocallyControlled() && Pawn->IsPlayerControlled();
+}
+
+bool UShooterAudioSubsystem::IsWithinCullDistance(const FVector& Location, float CullDistance) const
+{
+	// Split screen players and a listen server each hear from their own view
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (!PlayerController || !PlayerController->IsLocalController()) continue;
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+		if (FVector::DistSquared(ViewLocation, Location) <= FMath::Square(CullDistance)) return true;
+	}
+	return false;
+}
@@ -0,0 +1,106 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterAudioSubsystem.generated.h"
+
+UENUM(BlueprintType)
+enum class ECombatSoundCategory : uint8
+{
+	ECSC_Fire UMETA(DisplayName = "Fire"),
+	ECSC_Pickup UMETA(DisplayName = "Pickup"),
+	ECSC_Equip UMETA(DisplayName = "Equip"),
+
+	ECSC_MAX UMETA(DisplayName = "DefaultMAX")
+};
+
+USTRUCT(BlueprintType)
+struct FCombatSoundBudget
+{
+	GENERATED_BODY()
+
+	// Voices of this category playing at the same time
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	int32 MaxVoices{ 8 };
+
+	// Sounds from remote sources farther than this from every local view are not played
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	float CullDistance{ 5000.f };
+
+	// Attenuation of remote sounds of this category, a sphere falling off at CullDistance when not set
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	TSoftObjectPtr<class USoundAttenuation> RemoteAttenuation;
+
+	// Minimum time between two sounds of this category from the same source
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	float RetriggerInterval{ 0.f };
+
+	// When the budget is full, stop the oldest voice (true) or drop the new sound (false)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	bool bStealOldest{ true };
+};
+
+/**
+ * Every combat sound goes through here. Applies per category voice budgets, voice stealing,
+ * distance culling and retrigger limits, and spatializes sounds of remote pawns.
+ */
+UCLASS(Config = Game)
+class ULTIMATESHOOTER_API UShooterAudioSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	static UShooterAudioSubsystem* Get(const UObject* WorldContextObject);
+
+	// Plays Sound for Source, 2D when Source is the local player and spatialized at Location otherwise. False if culled
+	bool PlayCombatSound(ECombatSoundCategory Category, class USoundBase* Sound, const AActor* Source, const FVector& Location);
+
+	FORCEINLINE int32 GetActiveVoices() const { return LastFrameActiveVoices; }
+	FORCEINLINE int32 GetCulledPlays() const { return LastFrameCulledPlays; }
+	FORCEINLINE int32 GetStolenVoices() const { return LastFrameStolenVoices; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	const FCombatSoundBudget& GetBudget(ECombatSoundCategory Category) const;
+	// True when Source is controlled by a local player
+	static bool IsLocalSource(const AActor* Source);
+	// Distance from the view point of any local player
+	bool IsWithinCullDistance(const FVector& Location, float CullDistance) const;
+
+private:
+	struct FCategoryVoices
+	{
+		// Playing voices, oldest first
+		TArray<TWeakObjectPtr<class UAudioComponent>> Voices;
+		// Last time each source played a sound of this category
+		TMap<FObjectKey, double> LastPlayTimes;
+	};
+
+	FCategoryVoices CategoryVoices[(uint8)ECombatSoundCategory::ECSC_MAX];
+
+	UPROPERTY(Config)
+	FCombatSoundBudget FireBudget;
+	UPROPERTY(Config)
+	FCombatSoundBudget PickupBudget;
+	UPROPERTY(Config)
+	FCombatSoundBudget EquipBudget;
+
+	// Attenuation of remote pawn sounds by category
+	UPROPERTY(Transient)
+	TArray<class USoundAttenuation*> RemoteAttenuations;
+
+	int32 CulledPlays{ 0 };
+	int32 StolenVoices{ 0 };
+
+	int32 LastFrameActiveVoices{ 0 };
+	int32 LastFrameCulledPlays{ 0 };
+	int32 LastFrameStolenVoices{ 0 };
+};
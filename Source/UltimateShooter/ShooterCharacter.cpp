@@ -19,22 +19,44 @@
 #include "Components/SphereComponent.h"
 #include "Components/BoxComponent.h"
 #include "Components/CapsuleComponent.h"
+#include "WorldCollision.h"           // Overlap queries
 #include "Item.h"
 #include "Weapon.h"
 #include "Ammo.h"
+#include "ItemBudgetSubsystem.h"
+#include "ShooterHUDViewModel.h"
+#include "ShooterAudioSubsystem.h"
+#include "ShooterHitboxComponent.h"
+#include "ShooterHealthComponent.h"
+#include "ShooterShotSubsystem.h"
+#include "ShooterAnimInstance.h"
+#include "ShooterCharacterMovementComponent.h"
+#include "ShooterInputReplaySubsystem.h"
+#include "ShooterSimulationSubsystem.h"
+#include "ShooterFrameGovernorSubsystem.h"
+#include "HAL/IConsoleManager.h"
+
+#include "UltimateShooter.h"
+
+static TAutoConsoleVariable<bool> CVarProceduralRecoil(
+	TEXT("Shooter.Anim.ProceduralRecoil"),
+	false,
+	TEXT("Drive fire recoil from the anim instance spring (true) or restart HipFireMontage on every shot (false). Needs an anim BP reading RecoilAlpha/RecoilPitch"));
 
 // Sets default values
-AShooterCharacter::AShooterCharacter()
-	: BaseTurnRate(45.f), BaseLookUpRate(45.f), bAiming(false),
+AShooterCharacter::AShooterCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UShooterCharacterMovementComponent>(ACharacter::CharacterMovementComponentName)),
+	BaseTurnRate(45.f), BaseLookUpRate(45.f), bAiming(false),
 	CameraDefaultFOV(0.f), CameraZoomedFOV(25.f), CameraCurrentFOV(0.f), ZoomInterpSpeed(30.f),
 	HipTurnRate(90.f), HipLookUpRate(90.f), AimingTurnRate(20.f), AimingLookUpRate(20.f),
 	MouseHipTurnRate(1.0f), MouseHipLookUpRate(1.0f), MouseAimingTurnRate(0.4f), MouseAimingLookUpRate(0.4f),
 	CrosshairSpreadMultiplier(0.f), CrosshairVelocityFactor(0.f), CrosshairInAirFactor(0.f), CrosshairAimFactor(0.f), CrosshairShootingFactor(0.f),
 	ShootTimeDuration(0.05f), bFiringBullet(false), bFireButtonPressed(false), bShouldFire(true), AutomaticFireRate(0.1f),
 	bShouldTraceForItem(false), CameraInterpDistance(250.f), CameraInterpElevation(65.f), Starting9mmAmmo(85), StartingARAmmo(120),
+	bBatchAmmoPickup(false), AmmoVacuumRadius(300.f),
 	CombatState(ECombatState::ECS_Unoccupied), bCrouching(false), BaseMovementSpeed(650.f), CrouchMovementSpeed(300.f),
 	StandingCapsuleHeight(88.f), CrouchingCapsuleHeight(44.f), BaseGroundFriction(2.f), CrouchingGroundFriction(100.f),
-	bShouldPlayPickupSound(true), bShouldPlayEquipSound(true), PickupSoundResetTime(0.2f), EquipSoundResetTime(0.2f)
+	ItemInterpSlotCount(6), ItemInterpSlotSpacing(60.f), NextSharedInterpSlot(0)
 {
  	// Set this character to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
@@ -65,21 +87,10 @@ AShooterCharacter::AShooterCharacter()
 	// Create Hand Scene Component and not need SetupAttachment 
 	HandSceneComponent = CreateDefaultSubobject<USceneComponent>(TEXT("HandSceneComponent"));
 
-	WeaponInterpComp = CreateDefaultSubobject<USceneComponent>(TEXT("WeaponInterpComp"));
-	WeaponInterpComp->SetupAttachment(GetFollowCamera());
+	HUDViewModel = CreateDefaultSubobject<UShooterHUDViewModel>(TEXT("HUDViewModel"));
 
-	InterpComp1 = CreateDefaultSubobject<USceneComponent>(TEXT("InterpolationComponent1"));
-	InterpComp1->SetupAttachment(GetFollowCamera());
-	InterpComp2 = CreateDefaultSubobject<USceneComponent>(TEXT("InterpolationComponent2"));
-	InterpComp2->SetupAttachment(GetFollowCamera());
-	InterpComp3 = CreateDefaultSubobject<USceneComponent>(TEXT("InterpolationComponent3"));
-	InterpComp3->SetupAttachment(GetFollowCamera());
-	InterpComp4 = CreateDefaultSubobject<USceneComponent>(TEXT("InterpolationComponent4"));
-	InterpComp4->SetupAttachment(GetFollowCamera());
-	InterpComp5 = CreateDefaultSubobject<USceneComponent>(TEXT("InterpolationComponent5"));
-	InterpComp5->SetupAttachment(GetFollowCamera());
-	InterpComp6 = CreateDefaultSubobject<USceneComponent>(TEXT("InterpolationComponent6"));
-	InterpComp6->SetupAttachment(GetFollowCamera());
+	HitboxComponent = CreateDefaultSubobject<UShooterHitboxComponent>(TEXT("HitboxComponent"));
+	HealthComponent = CreateDefaultSubobject<UShooterHealthComponent>(TEXT("HealthComponent"));
 }
 
 // Called when the game starts or when spawned
@@ -106,6 +117,7 @@ void AShooterCharacter::BeginPlay()
 	EquipWeapon(SpawnDefaultWeapon());
 
 	InitializeAmmoMap();
+	UpdateHUDAmmo();
 
 	GetCharacterMovement()->MaxWalkSpeed = BaseMovementSpeed;
 
@@ -180,6 +192,7 @@ void AShooterCharacter::FireWeapon()
 
 		StartCrosshairBulletFire();        // Start bullet fire timer for crosshairs
 		EquippedWeapon->DecrementAmmo();
+		UpdateHUDAmmo();
 
 		StartFireTimer();
 	}
@@ -196,48 +209,32 @@ void AShooterCharacter::StopFiring()
 	bFireButtonPressed = false;  // No necesario
 }
 
+bool AShooterCharacter::PullTrigger()
+{
+	if (!EquippedWeapon || CombatState != ECombatState::ECS_Unoccupied) return false;
+	if (!WeaponHasAmmo())
+	{
+		ReloadWeapon();
+		return false;
+	}
+
+	FireWeapon();
+	return true;
+}
+
 void AShooterCharacter::StartFireTimer()
 {
-	CombatState = ECombatState::ECS_FireTimerInProgress;
+	SetCombatState(ECombatState::ECS_FireTimerInProgress);
 	GetWorldTimerManager().SetTimer(AutoFireTimer, this, &AShooterCharacter::AutoFireReset, AutomaticFireRate);
 }
 
 void AShooterCharacter::AutoFireReset()
 {
-	CombatState = ECombatState::ECS_Unoccupied;
+	SetCombatState(ECombatState::ECS_Unoccupied);
 	if (!WeaponHasAmmo()) ReloadWeapon();
 }
 
 
-bool AShooterCharacter::GetBeamEndLocation(const FVector& MuzzleSocketLocation, FVector& OutBeamLocation)
-{
-	// Check for crosshair trace hit
-	FHitResult CrosshairHitResult;
-	bool bCrosshairHit = TraceUnderCrosshairs(CrosshairHitResult, OutBeamLocation, 50'000.f);
-
-	if (bCrosshairHit)
-	{
-		OutBeamLocation = CrosshairHitResult.Location;
-	}
-	// if no hit - OutBeamLocation is the End location for the line trace
-
-	// Perform a second trace, this time from the gun barrel
-	const FVector WeaponTraceStart{ MuzzleSocketLocation };
-	const FVector StartToEnd{ OutBeamLocation - MuzzleSocketLocation };           //fix
-	const FVector WeaponTraceEnd{ MuzzleSocketLocation + StartToEnd * 1.25f };
-
-	FHitResult WeaponTraceHit;
-	GetWorld()->LineTraceSingleByChannel(WeaponTraceHit, WeaponTraceStart, WeaponTraceEnd, ECollisionChannel::ECC_Visibility);
-
-	if (WeaponTraceHit.bBlockingHit)  // object between barrel and EndPoint
-	{
-		OutBeamLocation = WeaponTraceHit.Location;
-		return true;  // true if hit
-	}
-	
-	return false;
-}
-
 void AShooterCharacter::Aim()
 {
 	if (CombatState == ECombatState::ECS_Reloading) return;
@@ -321,6 +318,19 @@ void AShooterCharacter::CalculateCrosshairSpread(float DeltaTime)
 
 }
 
+float AShooterCharacter::GetShotSpreadMultiplier() const
+{
+	// Targets of the crosshair factors, without the frame rate dependent interps or the cosmetic shooting kick
+	FVector Velocity{ GetVelocity() };
+	Velocity.Z = 0.f;
+	// Quantized to 1/16 so a quantized replicated velocity lands on the same step
+	const float VelocityFactor{ FMath::RoundToFloat(FMath::GetMappedRangeValueClamped(FVector2D{ 0.f, 600.f }, FVector2D{ 0.f, 1.f }, Velocity.Size()) * 16.f) / 16.f };
+	const float InAirFactor{ GetCharacterMovement()->IsFalling() ? 2.25f : 0.f };
+	const float AimFactor{ bAiming ? 0.6f : 0.f };
+
+	return 0.5f + VelocityFactor + InAirFactor - AimFactor;
+}
+
 void AShooterCharacter::StartCrosshairBulletFire()
 {
 	bFiringBullet = true;
@@ -349,6 +359,15 @@ bool AShooterCharacter::TraceUnderCrosshairs(FHitResult& OutHitResult, FVector&
 		CrosshairWorldPosition,
 		CrosshairWorldDirection);
 
+	// No viewport when fast forwarding, and AI aims with its control rotation, aim from the view point instead
+	if (!IsPlayerControlled() || UShooterSimulationSubsystem::IsFastForwarding(this))
+	{
+		FRotator ViewRotation;
+		GetActorEyesViewPoint(CrosshairWorldPosition, ViewRotation);
+		CrosshairWorldDirection = ViewRotation.Vector();
+		bScreenToWorld = true;
+	}
+
 	if (bScreenToWorld)
 	{
 		// Trace from crosshair world location outward
@@ -358,6 +377,7 @@ bool AShooterCharacter::TraceUnderCrosshairs(FHitResult& OutHitResult, FVector&
 
 		// Trace outward from crosshairs world location
 		GetWorld()->LineTraceSingleByChannel(OutHitResult, Start, End, ECollisionChannel::ECC_Visibility);
+		CSV_CUSTOM_STAT(ShooterGameplay, Traces, 1, ECsvCustomStatOp::Accumulate);
 
 		if (OutHitResult.bBlockingHit) 
 		{ 
@@ -384,6 +404,11 @@ void AShooterCharacter::TraceForItemsInformation()
 			{
 				TraceHitItem->GetPickupWidget()->SetVisibility(true);
 			}
+			// Looking at an item keeps it from being evicted
+			if (TraceHitItem && TraceHitItem != ItemHitLastFrame)
+			{
+				if (UItemBudgetSubsystem* ItemBudget = GetWorld()->GetSubsystem<UItemBudgetSubsystem>()) { ItemBudget->TouchItem(TraceHitItem); }
+			}
 
 			if (ItemHitLastFrame && (TraceHitItem != ItemHitLastFrame))  // we are hitting a different AItem this frame from the last frame or HitItem is null
 			{
@@ -429,6 +454,9 @@ void AShooterCharacter::EquipWeapon(AWeapon* WeaponToEquip)
 
 		EquippedWeapon = WeaponToEquip;
 		EquippedWeapon->SetItemState(EItemState::EIS_Equipped);
+
+		HUDViewModel->SetWeapon(EquippedWeapon);
+		UpdateHUDAmmo();
 	}
 }
 
@@ -443,6 +471,9 @@ void AShooterCharacter::DropWeapon()
 		EquippedWeapon->ThrowWeapon();
 		
 		EquippedWeapon = nullptr;
+
+		HUDViewModel->SetWeapon(nullptr);
+		UpdateHUDAmmo();
 	}
 }
 
@@ -476,7 +507,10 @@ bool AShooterCharacter::WeaponHasAmmo()
 
 void AShooterCharacter::PlayFireSound()
 {
-	if (FireSound) { UGameplayStatics::PlaySound2D(this, FireSound); }
+	if (UShooterAudioSubsystem* CombatAudio = UShooterAudioSubsystem::Get(this))
+	{
+		CombatAudio->PlayCombatSound(ECombatSoundCategory::ECSC_Fire, FireSound, this, GetActorLocation());
+	}
 }
 
 void AShooterCharacter::SendBullet()
@@ -486,25 +520,44 @@ void AShooterCharacter::SendBullet()
 	{
 		const FTransform SocketTransform = BarrelSocket->GetSocketTransform(EquippedWeapon->GetItemMesh());
 
-		if (MuzzleFlash) { UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), MuzzleFlash, SocketTransform); }
+		CSV_CUSTOM_STAT(ShooterGameplay, ShotsFired, 1, ECsvCustomStatOp::Accumulate);
 
-		FVector BeamEnd;
-		bool bBeamEnd = GetBeamEndLocation(SocketTransform.GetLocation(), BeamEnd);
-
-		if (bBeamEnd)
+		if (MuzzleFlash && !UShooterSimulationSubsystem::IsFastForwarding(this))
 		{
-			if (ImpactParticles) { UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), ImpactParticles, BeamEnd); }
+			UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), MuzzleFlash, SocketTransform, true, EPSCPoolMethod::AutoRelease);
+			CSV_CUSTOM_STAT(ShooterGameplay, EmittersSpawned, 1, ECsvCustomStatOp::Accumulate);
 		}
 
-		UParticleSystemComponent* Beam = UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), BeamParticles, SocketTransform);
-		if (Beam) { Beam->SetVectorParameter(FName("Target"), BeamEnd); }
+		const FShotShape& ShotShape = EquippedWeapon->GetShotShape();
+
+		// Rays leave the barrel towards whatever is under the crosshairs
+		FHitResult CrosshairHitResult;
+		FVector AimLocation;
+		TraceUnderCrosshairs(CrosshairHitResult, AimLocation, ShotShape.Range);
+		const FVector AimDirection{ (AimLocation - SocketTransform.GetLocation()).GetSafeNormal() };
+
+		// Traced with the other shots of the frame, impacts and hits come next frame
+		if (UShooterShotSubsystem* Shots = UShooterShotSubsystem::Get(this))
+		{
+			// Pellet directions only depend on the weapon shot counter, the spread on movement and aim state
+			const float SpreadHalfAngle{ EquippedWeapon->GetSpreadAngle() * GetShotSpreadMultiplier() };
+			Shots->FireShot(this, SocketTransform.GetLocation(), AimDirection, ShotShape, EquippedWeapon->ConsumeShotIndex(), SpreadHalfAngle,
+				ImpactParticles, BeamParticles);
+		}
 	}
 }
 
 void AShooterCharacter::PlayGunFireMontage()
 {
-	// PLay Shoot anim Montage
 	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
+	if (CVarProceduralRecoil.GetValueOnGameThread())
+	{
+		// No montage instance, the spring is evaluated in the thread safe anim update
+		if (UShooterAnimInstance* ShooterAnimInstance = Cast<UShooterAnimInstance>(AnimInstance)) { ShooterAnimInstance->AddShotImpulse(); }
+		return;
+	}
+
+	// PLay Shoot anim Montage
 	if (AnimInstance && HipFireMontage)
 	{
 		AnimInstance->Montage_Play(HipFireMontage);
@@ -526,7 +579,7 @@ void AShooterCharacter::ReloadWeapon()
 	if (CarryingAmmo() && !EquippedWeapon->GetClipIsFull())  
 	{
 		if (bAiming) { StopAiming(); }
-		CombatState = ECombatState::ECS_Reloading;
+		SetCombatState(ECombatState::ECS_Reloading);
 
 		UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
 		if (!ReloadMontage || !AnimInstance) return;
@@ -537,8 +590,10 @@ void AShooterCharacter::ReloadWeapon()
 
 void AShooterCharacter::FinishReloading()
 {
+	CSV_CUSTOM_STAT(ShooterGameplay, Reloads, 1, ECsvCustomStatOp::Accumulate);
+
 	// Update the combat state
-	CombatState = ECombatState::ECS_Unoccupied;
+	SetCombatState(ECombatState::ECS_Unoccupied);
 
 	// Update the ammo Map
 	if (!EquippedWeapon) return;
@@ -566,6 +621,8 @@ void AShooterCharacter::FinishReloading()
 			AmmoMap.Add(AmmoType, CarriedAmmo);
 		}
 	}
+
+	UpdateHUDAmmo();
 }
 
 bool AShooterCharacter::CarryingAmmo()
@@ -603,6 +660,95 @@ void AShooterCharacter::ReleaseClip()
 	EquippedWeapon->SetMovingClip(false);
 }
 
+void AShooterCharacter::ResetForReuse()
+{
+	GetWorldTimerManager().ClearAllTimersForObject(this);
+	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance()) { AnimInstance->StopAllMontages(0.f); }
+
+	// Ammo
+	InitializeAmmoMap();
+
+	// Weapon, a new one if it was dropped, else a full magazine
+	if (!EquippedWeapon)
+	{
+		EquipWeapon(SpawnDefaultWeapon());
+	}
+	else
+	{
+		EquippedWeapon->ReloadAmmo(EquippedWeapon->GetMagazineCapacity() - EquippedWeapon->GetAmmo());
+		EquippedWeapon->SetMovingClip(false);
+	}
+	UpdateHUDAmmo();
+
+	// Combat state
+	SetCombatState(ECombatState::ECS_Unoccupied);
+	bFireButtonPressed = false;
+	bShouldFire = true;
+	bFiringBullet = false;
+	bAiming = false;
+	CameraCurrentFOV = CameraDefaultFOV;
+
+	// Capsule and movement
+	bCrouching = false;
+	GetCapsuleComponent()->SetCapsuleHalfHeight(StandingCapsuleHeight);
+	// Undo the mesh offset InterpCapsuleHeight built up while crouched
+	GetMesh()->SetRelativeLocation(GetClass()->GetDefaultObject<AShooterCharacter>()->GetMesh()->GetRelativeLocation());
+	GetCharacterMovement()->MaxWalkSpeed = BaseMovementSpeed;
+	GetCharacterMovement()->GroundFriction = BaseGroundFriction;
+	GetCharacterMovement()->StopMovementImmediately();
+	GetCharacterMovement()->SetMovementMode(EMovementMode::MOVE_Walking);
+
+	HealthComponent->ResetHealth();
+}
+
+void AShooterCharacter::SetPooled(bool bInPool)
+{
+	SetActorHiddenInGame(bInPool);
+	SetActorEnableCollision(!bInPool);
+	SetActorTickEnabled(!bInPool);
+	GetMesh()->SetComponentTickEnabled(!bInPool);
+	GetCharacterMovement()->SetComponentTickEnabled(!bInPool);
+	HitboxComponent->SetHitboxEnabled(!bInPool);
+
+	if (EquippedWeapon) { EquippedWeapon->SetActorHiddenInGame(bInPool); }
+}
+
+void AShooterCharacter::RestoreSnapshotState(const FTransform& Transform, const TArray<TPair<EAmmoType, int32>>& Ammo, ECombatState SavedCombatState, bool bSavedCrouching, AWeapon* Weapon)
+{
+	GetWorldTimerManager().ClearAllTimersForObject(this);
+	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance()) { AnimInstance->StopAllMontages(0.f); }
+
+	SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+	if (Controller) { Controller->SetControlRotation(Transform.Rotator()); }
+	GetCharacterMovement()->StopMovementImmediately();
+
+	// Ammo
+	AmmoMap.Reset();
+	for (const TPair<EAmmoType, int32>& AmmoPair : Ammo) { AmmoMap.Add(AmmoPair.Key, AmmoPair.Value); }
+
+	// Weapon, the one held now stays where it is
+	if (Weapon != EquippedWeapon)
+	{
+		if (EquippedWeapon) { EquippedWeapon->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform); }
+		EquippedWeapon = nullptr;
+		EquipWeapon(Weapon);
+	}
+	if (!EquippedWeapon) { HUDViewModel->SetWeapon(nullptr); }
+	UpdateHUDAmmo();
+
+	// Crouch
+	bCrouching = bSavedCrouching;
+	GetCharacterMovement()->MaxWalkSpeed = bCrouching ? CrouchMovementSpeed : BaseMovementSpeed;
+	GetCharacterMovement()->GroundFriction = bCrouching ? CrouchingGroundFriction : BaseGroundFriction;
+
+	// Combat state
+	SetCombatState(ECombatState::ECS_Unoccupied);
+	bFireButtonPressed = false;
+	bShouldFire = true;
+	bFiringBullet = false;
+	if (SavedCombatState == ECombatState::ECS_Reloading) { ReloadWeapon(); }
+}
+
 void AShooterCharacter::Crouch()
 {
 	if (GetCharacterMovement()->IsFalling()) return;
@@ -654,17 +800,26 @@ void AShooterCharacter::InterpCapsuleHeight(float DeltaTime)
 
 void AShooterCharacter::PickupAmmo(AAmmo* Ammo)
 {
-	// Check to see if Ammo Map contains Ammo's AmmoType
-	if (AmmoMap.Find(Ammo->GetAmmoType()))
+	bool bPickedEquippedAmmoType{ false };
+
+	if (Ammo->GetBatchedAmmo().Num() > 0)
 	{
-		// Get Amount of ammo in our AmmoMap for Ammo's Type
-		int32 AmmoCount{ AmmoMap[Ammo->GetAmmoType()] };
-		AmmoCount += Ammo->GetItemCount();
-		// Set the Amount of ammo in the map for this type
-		AmmoMap[Ammo->GetAmmoType()] = AmmoCount;
+		// Batched pickup, add all the collected ammo in one go
+		for (const TPair<EAmmoType, int32>& Batched : Ammo->GetBatchedAmmo())
+		{
+			AddAmmo(Batched.Key, Batched.Value);
+			if (EquippedWeapon && EquippedWeapon->GetAmmoType() == Batched.Key) { bPickedEquippedAmmoType = true; }
+		}
+	}
+	else
+	{
+		AddAmmo(Ammo->GetAmmoType(), Ammo->GetItemCount());
+		bPickedEquippedAmmoType = EquippedWeapon && EquippedWeapon->GetAmmoType() == Ammo->GetAmmoType();
 	}
 
-	if (EquippedWeapon->GetAmmoType() == Ammo->GetAmmoType())
+	UpdateHUDAmmo();
+
+	if (bPickedEquippedAmmoType)
 	{
 		if (EquippedWeapon->GetAmmo() == 0)
 		{
@@ -675,70 +830,113 @@ void AShooterCharacter::PickupAmmo(AAmmo* Ammo)
 	Ammo->Destroy();
 }
 
-void AShooterCharacter::InitializeInterpLocations()
+void AShooterCharacter::AddAmmo(EAmmoType AmmoType, int32 Amount)
 {
-	FInterpLocation WeaponLocation{ WeaponInterpComp, 0 };
-	InterpLocations.Add(WeaponLocation);
-	FInterpLocation InterpLocation1{ InterpComp1, 0 };
-	InterpLocations.Add(InterpLocation1);
-	FInterpLocation InterpLocation2{ InterpComp2, 0 };
-	InterpLocations.Add(InterpLocation2);
-	FInterpLocation InterpLocation3{ InterpComp3, 0 };
-	InterpLocations.Add(InterpLocation3);
-	FInterpLocation InterpLocation4{ InterpComp4, 0 };
-	InterpLocations.Add(InterpLocation4);
-	FInterpLocation InterpLocation5{ InterpComp5, 0 };
-	InterpLocations.Add(InterpLocation5);
-	FInterpLocation InterpLocation6{ InterpComp6, 0 };
-	InterpLocations.Add(InterpLocation6);
+	// Check to see if Ammo Map contains Ammo's AmmoType
+	if (int32* AmmoCount = AmmoMap.Find(AmmoType))
+	{
+		*AmmoCount += Amount;
+	}
 }
 
-void AShooterCharacter::ResetPickupSoundTimer()
+void AShooterCharacter::VacuumAmmo(AAmmo* TriggerAmmo)
 {
-	bShouldPlayPickupSound = true;
+	if (!TriggerAmmo) return;
+
+	// One query for every ammo pickup around the character
+	TArray<FOverlapResult> Overlaps;
+	const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(VacuumAmmo), false, this);
+	GetWorld()->OverlapMultiByObjectType(Overlaps, GetActorLocation(), FQuat::Identity,
+		FCollisionObjectQueryParams(ECollisionChannel::ECC_WorldDynamic), FCollisionShape::MakeSphere(AmmoVacuumRadius), QueryParams);
+
+	// Merge the counts per ammo type
+	TMap<EAmmoType, int32> CollectedAmmo;
+	CollectedAmmo.Add(TriggerAmmo->GetAmmoType(), TriggerAmmo->GetItemCount());
+
+	TSet<AAmmo*> CollectedPickups;
+	CollectedPickups.Add(TriggerAmmo);
+
+	for (const FOverlapResult& Overlap : Overlaps)
+	{
+		AAmmo* Ammo = Cast<AAmmo>(Overlap.GetActor());
+		if (!Ammo || Ammo->IsActorBeingDestroyed() || Ammo->GetItemState() != EItemState::EIS_Pickup) continue;
+
+		bool bAlreadyCollected{ false };
+		CollectedPickups.Add(Ammo, &bAlreadyCollected);
+		if (bAlreadyCollected) continue;  // Several components of the same pickup can overlap
+
+		CollectedAmmo.FindOrAdd(Ammo->GetAmmoType()) += Ammo->GetItemCount();
+		Ammo->Destroy();
+	}
+
+	// The trigger ammo carries the whole pile: one interp, one sound, one inventory update
+	TriggerAmmo->SetBatchedAmmo(MoveTemp(CollectedAmmo));
+	TriggerAmmo->StartItemCurve(this);
 }
 
-void AShooterCharacter::ResetEquipSoundTimer()
+void AShooterCharacter::InitializeInterpLocations()
 {
-	bShouldPlayEquipSound = true;
+	InterpLocations.Reset(ItemInterpSlotCount + 1);
+	FreeInterpSlots.Reset(ItemInterpSlotCount);
+
+	// Slot 0 is the weapon, straight in front of the camera
+	const FVector SlotRowOffset{ CameraInterpDistance, 0.f, CameraInterpElevation };
+	InterpLocations.Add(FInterpLocation{ SlotRowOffset, 0 });
+
+	// Item slots in a row centered on the weapon slot
+	const float FirstSlotY{ -0.5f * (ItemInterpSlotCount - 1) * ItemInterpSlotSpacing };
+	for (int32 i = 0; i < ItemInterpSlotCount; i++)
+	{
+		InterpLocations.Add(FInterpLocation{ SlotRowOffset + FVector(0.f, FirstSlotY + i * ItemInterpSlotSpacing, 0.f), 0 });
+	}
+
+	// Reverse order so the first slot is handed out first
+	for (int32 i = ItemInterpSlotCount; i >= 1; i--)
+	{
+		FreeInterpSlots.Add(i);
+	}
 }
 
 int32 AShooterCharacter::GetInterpLocationIndex()
 {
-	int32 LowestIndex = 1;
-	int32 LowestCount = INT_MAX;
-	for (int32 i = 1; i < InterpLocations.Num(); i++) // loop 1-6  0 is the weapon Location for interp
-	{
-		if (InterpLocations[i].ItemCount < LowestCount) 
-		{
-			LowestIndex = i;
-			LowestCount = InterpLocations[i].ItemCount;
-		}
-	}
+	// Take an empty slot if there is one
+	if (FreeInterpSlots.Num() > 0) { return FreeInterpSlots.Pop(false); }
 
-	return LowestIndex;
+	// Every slot is busy, share them round robin (0 is the weapon Location for interp)
+	const int32 NumItemSlots{ InterpLocations.Num() - 1 };
+	if (NumItemSlots <= 0) return 0;
+
+	NextSharedInterpSlot = NextSharedInterpSlot % NumItemSlots + 1;
+	return NextSharedInterpSlot;
 }
 
 void AShooterCharacter::IncrementInterpLocationCount(int32 Index, int32 Amount)
 {
 	if (Amount < -1 || Amount > 1) return;
-	
-	if (InterpLocations.Num() >= Index)
-	{
-		InterpLocations[Index].ItemCount += Amount;
-	}
+	if (!InterpLocations.IsValidIndex(Index)) return;
+
+	InterpLocations[Index].ItemCount += Amount;
+
+	// Slot is empty again, give it back
+	if (Index > 0 && Amount < 0 && InterpLocations[Index].ItemCount == 0) { FreeInterpSlots.Add(Index); }
 }
 
-void AShooterCharacter::StartPickupSoundTimer()
+void AShooterCharacter::SetCombatState(ECombatState State)
 {
-	bShouldPlayPickupSound = false;
-	GetWorldTimerManager().SetTimer(PickupSoundTimer, this, &AShooterCharacter::ResetPickupSoundTimer, PickupSoundResetTime);
+	CombatState = State;
+	HUDViewModel->SetCombatState(CombatState);
 }
 
-void AShooterCharacter::StartEquipSoundTimer()
+void AShooterCharacter::UpdateHUDAmmo()
 {
-	bShouldPlayEquipSound = false;
-	GetWorldTimerManager().SetTimer(EquipSoundTimer, this, &AShooterCharacter::ResetEquipSoundTimer, EquipSoundResetTime);
+	if (!EquippedWeapon)
+	{
+		HUDViewModel->SetAmmo(0, 0);
+		return;
+	}
+
+	const int32* CarriedAmmo = AmmoMap.Find(EquippedWeapon->GetAmmoType());
+	HUDViewModel->SetAmmo(EquippedWeapon->GetAmmo(), CarriedAmmo ? *CarriedAmmo : 0);
 }
 
 
@@ -754,42 +952,79 @@ void AShooterCharacter::Tick(float DeltaTime)
 
 	CalculateCrosshairSpread(DeltaTime);
 
-	TraceForItemsInformation();
+	// Every few frames under load, the pickup widget can lag a little
+	if (GFrameCounter % UShooterFrameGovernorSubsystem::GetItemTraceInterval(this) == 0) { TraceForItemsInformation(); }
 
 	// Interpolate the capsule height based on crouching / standing
 	InterpCapsuleHeight(DeltaTime);
 }
 
+const AShooterCharacter::FInputBinding AShooterCharacter::InputBindings[]
+{
+	// Move, Look
+	{ TEXT("Move"), &AShooterCharacter::MoveAction, ETriggerEvent::Triggered, &AShooterCharacter::Move, nullptr },
+	{ TEXT("Look"), &AShooterCharacter::LookAction, ETriggerEvent::Triggered, &AShooterCharacter::Look, nullptr },
+	// Jump
+	{ TEXT("Jump"), &AShooterCharacter::JumpAction, ETriggerEvent::Triggered, nullptr, &AShooterCharacter::Jump },
+	{ TEXT("StopJumping"), &AShooterCharacter::JumpAction, ETriggerEvent::Completed, nullptr, &ACharacter::StopJumping },
+	// Fire Weapon
+	{ TEXT("StartFiring"), &AShooterCharacter::FireAction, ETriggerEvent::Triggered, nullptr, &AShooterCharacter::StartFiring },
+	{ TEXT("StopFiring"), &AShooterCharacter::FireAction, ETriggerEvent::Completed, nullptr, &AShooterCharacter::StopFiring },
+	// Aiming
+	{ TEXT("Aim"), &AShooterCharacter::AimingAction, ETriggerEvent::Triggered, nullptr, &AShooterCharacter::Aim },
+	{ TEXT("StopAiming"), &AShooterCharacter::AimingAction, ETriggerEvent::Completed, nullptr, &AShooterCharacter::StopAiming },
+	// Select, for test
+	{ TEXT("SelectWeapon"), &AShooterCharacter::SelectAction, ETriggerEvent::Triggered, nullptr, &AShooterCharacter::SelectWeapon },
+	// Reload
+	{ TEXT("StartReloading"), &AShooterCharacter::ReloadAction, ETriggerEvent::Triggered, nullptr, &AShooterCharacter::StartReloading },
+	// Crouch
+	{ TEXT("Crouch"), &AShooterCharacter::CrouchAction, ETriggerEvent::Triggered, nullptr, &AShooterCharacter::Crouch },
+};
+
 // Called to bind functionality to input
 void AShooterCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
 {
 	Super::SetupPlayerInputComponent(PlayerInputComponent);
 
-	// Set up action bindings
+	// Set up action bindings, one per row of the table
 	if (UEnhancedInputComponent* EnhancedInputComponent = CastChecked<UEnhancedInputComponent>(PlayerInputComponent))
 	{
-		// Move
-		EnhancedInputComponent->BindAction(MoveAction, ETriggerEvent::Triggered, this, &AShooterCharacter::Move);
-		// Look 
-		EnhancedInputComponent->BindAction(LookAction, ETriggerEvent::Triggered, this, &AShooterCharacter::Look);
-		// Jump
-		EnhancedInputComponent->BindAction(JumpAction, ETriggerEvent::Triggered, this, &AShooterCharacter::Jump);
-		EnhancedInputComponent->BindAction(JumpAction, ETriggerEvent::Completed, this, &ACharacter::StopJumping);
-		// Fire Weapon
-		EnhancedInputComponent->BindAction(FireAction, ETriggerEvent::Triggered, this, &AShooterCharacter::StartFiring);
-		EnhancedInputComponent->BindAction(FireAction, ETriggerEvent::Completed, this, &AShooterCharacter::StopFiring);
-		// Aiming 
-		EnhancedInputComponent->BindAction(AimingAction, ETriggerEvent::Triggered, this, &AShooterCharacter::Aim);
-		EnhancedInputComponent->BindAction(AimingAction, ETriggerEvent::Completed, this, &AShooterCharacter::StopAiming);
-		// Select 
-		EnhancedInputComponent->BindAction(SelectAction, ETriggerEvent::Triggered, this, &AShooterCharacter::SelectWeapon); // for test
-		// Reload
-		EnhancedInputComponent->BindAction(ReloadAction, ETriggerEvent::Triggered, this, &AShooterCharacter::StartReloading);
-		// Crouch
-		EnhancedInputComponent->BindAction(CrouchAction, ETriggerEvent::Triggered, this, &AShooterCharacter::Crouch);
+		for (int32 BindingIndex = 0; BindingIndex < static_cast<int32>(UE_ARRAY_COUNT(InputBindings)); ++BindingIndex)
+		{
+			const FInputBinding& Binding = InputBindings[BindingIndex];
+			EnhancedInputComponent->BindAction(this->*Binding.Action, Binding.TriggerEvent, this, &AShooterCharacter::DispatchInput, BindingIndex);
+		}
 	}
 }
 
+void AShooterCharacter::DispatchInput(const FInputActionValue& Value, int32 BindingIndex)
+{
+	if (UShooterInputReplaySubsystem* InputReplay = UShooterInputReplaySubsystem::Get(this))
+	{
+		// The recording drives the character, live input would desync it
+		if (InputReplay->IsReplaying()) return;
+		InputReplay->RecordInput(BindingIndex, Value);
+	}
+
+	HandleInput(BindingIndex, Value);
+}
+
+void AShooterCharacter::HandleInput(int32 BindingIndex, const FInputActionValue& Value)
+{
+	if (BindingIndex < 0 || BindingIndex >= static_cast<int32>(UE_ARRAY_COUNT(InputBindings))) return;
+
+	const FInputBinding& Binding = InputBindings[BindingIndex];
+	if (Binding.ValueHandler) { (this->*Binding.ValueHandler)(Value); }
+	else { (this->*Binding.Handler)(); }
+}
+
+TArray<FName> AShooterCharacter::GetInputBindingNames()
+{
+	TArray<FName> Names;
+	for (const FInputBinding& Binding : InputBindings) { Names.Add(Binding.Name); }
+	return Names;
+}
+
 void AShooterCharacter::SetOverlappedItemCount(int8 Amount)
 {
 	if (OverlappedItemCount + Amount <= 0)
@@ -831,12 +1066,9 @@ void AShooterCharacter::GetPickupItem(AItem* Item)
 	}
 }
 
-FInterpLocation AShooterCharacter::GetInterpLocation(int32 index)
+FVector AShooterCharacter::GetInterpLocation(int32 Index) const
 {
-	if (index <= InterpLocations.Num())
-	{
-		return InterpLocations[index];
-	}
-	return FInterpLocation();
-}
+	if (!FollowCamera || !InterpLocations.IsValidIndex(Index)) return FVector(0.f);
 
+	return FollowCamera->GetComponentTransform().TransformPosition(InterpLocations[Index].CameraOffset);
+}
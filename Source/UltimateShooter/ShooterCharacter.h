@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
 #include "InputActionValue.h"              //EnhancedInput
+#include "InputTriggers.h"                 //EnhancedInput
 #include "AmmoType.h"
 #include "ShooterCharacter.generated.h"
 
@@ -26,13 +27,13 @@ struct FInterpLocation
 {
 	GENERATED_BODY()
 
-	// Scene Component to use for its location for interping
+	// Offset from the follow camera used as the interp destination
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
-	USceneComponent* SceneComponent;
+	FVector CameraOffset{ 0.f };
 
-	// Number of items interping to/ at this scene comp location
+	// Number of items interping to/ at this location
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
-	int32 ItemCount;
+	int32 ItemCount{ 0 };
 };
 
 
@@ -42,8 +43,8 @@ class ULTIMATESHOOTER_API AShooterCharacter : public ACharacter
 	GENERATED_BODY()
 
 public:
-	// Sets default values for this character's properties
-	AShooterCharacter();
+	// Sets default values for this character's properties, movement is a UShooterCharacterMovementComponent
+	AShooterCharacter(const FObjectInitializer& ObjectInitializer);
 
 protected:
 	// Called when the game starts or when spawned
@@ -63,8 +64,6 @@ protected:
 	UFUNCTION()
 	void AutoFireReset();
 
-	bool GetBeamEndLocation(const FVector& MuzzleSocketLocation, FVector& OutBeamLocation);
-
 	/** Set bAiming to true or false with button press */
 	void Aim();
 	void StopAiming();
@@ -74,6 +73,8 @@ protected:
 	void SetLookRates();   
 
 	void CalculateCrosshairSpread(float DeltaTime);
+	// Shot spread from the movement and aim state alone, so a shot can be rebuilt from its index without the local crosshair interp
+	float GetShotSpreadMultiplier() const;
 
 	void StartCrosshairBulletFire();
 	UFUNCTION()
@@ -104,6 +105,7 @@ protected:
 	// Fire Weapon functions
 	void PlayFireSound();
 	void SendBullet();
+	// HipFireMontage, or the recoil spring in the anim instance with Shooter.Anim.ProceduralRecoil 1
 	void PlayGunFireMontage();
 
 	// Reload Weapons functions
@@ -130,11 +132,15 @@ protected:
 	void InterpCapsuleHeight(float DeltaTime);
 
 	void PickupAmmo(class AAmmo* Ammo);
+	// Adds ammo of the given type to the AmmoMap
+	void AddAmmo(EAmmoType AmmoType, int32 Amount);
 	
 	void InitializeInterpLocations();
 
-	void ResetPickupSoundTimer();
-	void ResetEquipSoundTimer();
+	// Sets the combat state and pushes it to the HUD
+	void SetCombatState(ECombatState State);
+	// Pushes magazine and carried ammo of the equipped weapon to the HUD
+	void UpdateHUDAmmo();
 
 public:	
 	// Called every frame
@@ -275,6 +281,13 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Items, meta = (AllowPrivateAccess = "true"))
 	int32 StartingARAmmo;
 
+	// When true, touching an ammo pickup collects every ammo pickup around the character at once. Off by default, enabled per Blueprint
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Items, meta = (AllowPrivateAccess = "true"))
+	bool bBatchAmmoPickup;
+	// Radius of the batched ammo pickup query
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Items, meta = (AllowPrivateAccess = "true"))
+	float AmmoVacuumRadius;
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Combat, meta = (AllowPrivateAccess = "true"))
 	ECombatState CombatState;
 
@@ -311,35 +324,30 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Movement, meta = (AllowPrivateAccess = "true"))
 	float CrouchingGroundFriction;
 
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
-	USceneComponent* WeaponInterpComp;
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
-	USceneComponent* InterpComp1;
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
-	USceneComponent* InterpComp2;
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
-	USceneComponent* InterpComp3;
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
-	USceneComponent* InterpComp4;
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
-	USceneComponent* InterpComp5;
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
-	USceneComponent* InterpComp6;
-	// Array of interp location structs
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+	// Number of interp slots for non weapon items (ammo), the weapon always uses slot 0
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Items, meta = (AllowPrivateAccess = "true", ClampMin = "1"))
+	int32 ItemInterpSlotCount;
+	// Side distance between two item interp slots in front of the camera
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Items, meta = (AllowPrivateAccess = "true"))
+	float ItemInterpSlotSpacing;
+	// Array of interp location structs, computed from the camera transform on demand
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Items, meta = (AllowPrivateAccess = "true"))
 	TArray<FInterpLocation> InterpLocations;
+	// Item slots with nothing interping to them
+	TArray<int32> FreeInterpSlots;
+	// Last slot handed out when every slot is busy
+	int32 NextSharedInterpSlot;
 
-	FTimerHandle PickupSoundTimer;
-	FTimerHandle EquipSoundTimer;
-
-	bool bShouldPlayPickupSound;
-	bool bShouldPlayEquipSound;
+	// HUD state pushed on change, read by the overlay widget
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Widgets, meta = (AllowPrivateAccess = "true"))
+	class UShooterHUDViewModel* HUDViewModel;
 
-	// Time to wait before we can play another sound
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Items, meta = (AllowPrivateAccess = "true"))
-	float PickupSoundResetTime;
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Items, meta = (AllowPrivateAccess = "true"))
-	float EquipSoundResetTime;
+	// Bone capsules used for hit registration
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Combat, meta = (AllowPrivateAccess = "true"))
+	class UShooterHitboxComponent* HitboxComponent;
+	// Health record in the damage subsystem
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Combat, meta = (AllowPrivateAccess = "true"))
+	class UShooterHealthComponent* HealthComponent;
 
 	/** Configuration to handle Inputs */
 	// Mapping Context
@@ -370,6 +378,21 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Input, meta = (AllowPrivateAccess = "true"))
 	class UInputAction* CrouchAction;
 
+	// One row per bound action and trigger event, input recordings store the row index
+	struct FInputBinding
+	{
+		const TCHAR* Name;
+		UInputAction* AShooterCharacter::* Action;
+		ETriggerEvent TriggerEvent;
+		// One of the two is set
+		void (AShooterCharacter::* ValueHandler)(const FInputActionValue&);
+		void (AShooterCharacter::* Handler)();
+	};
+	static const FInputBinding InputBindings[];
+
+	// Every live input goes through here, recorded or dropped while a replay drives the character
+	void DispatchInput(const FInputActionValue& Value, int32 BindingIndex);
+
 public:
 	/** Returns CameraBoom subobject */
 	FORCEINLINE USpringArmComponent* GetCameraBoom() const { return CameraBoom; } 
@@ -392,17 +415,37 @@ public:
 	void GetPickupItem(class AItem* Item);
 
 	FORCEINLINE ECombatState GetCombatState() const { return CombatState; }
+	FORCEINLINE class UShooterHealthComponent* GetHealthComponent() const { return HealthComponent; }
+
+	// One shot for AI controllers, false when the weapon can't fire now. An empty magazine starts a reload.
+	bool PullTrigger();
+	FORCEINLINE class AWeapon* GetEquippedWeapon() const { return EquippedWeapon; }
+
+	// Runs the handler of an input binding, used by the live input and the input replay
+	void HandleInput(int32 BindingIndex, const FInputActionValue& Value);
+	static TArray<FName> GetInputBindingNames();
+
+	// Puts a pooled character back in its starting state: ammo, weapon, combat state, capsule and health
+	void ResetForReuse();
+	// Hides and freezes the character while it waits in a pool
+	void SetPooled(bool bInPool);
 	FORCEINLINE bool GetCrouching() const { return bCrouching;  }
 
-	FInterpLocation GetInterpLocation(int32 index);
+	FORCEINLINE const TMap<EAmmoType, int32>& GetAmmoMap() const { return AmmoMap; }
+	// Puts the character in a saved state. Timers and montages aren't saved, a reload in progress starts over
+	void RestoreSnapshotState(const FTransform& Transform, const TArray<TPair<EAmmoType, int32>>& Ammo, ECombatState SavedCombatState, bool bSavedCrouching, class AWeapon* Weapon);
+
+	// World location of the interp slot, computed from the follow camera transform
+	FVector GetInterpLocation(int32 Index) const;
 
 	int32 GetInterpLocationIndex();
 
 	void IncrementInterpLocationCount(int32 Index, int32 Amount);
 
-	FORCEINLINE bool GetShouldPlayPickupSound() const { return bShouldPlayPickupSound; }
-	FORCEINLINE bool GetShouldPlayEquipSound() const { return bShouldPlayEquipSound; }
+	FORCEINLINE UShooterHUDViewModel* GetHUDViewModel() const { return HUDViewModel; }
+
+	FORCEINLINE bool GetBatchAmmoPickup() const { return bBatchAmmoPickup; }
 
-	void StartPickupSoundTimer();
-	void StartEquipSoundTimer();
+	// Collects every ammo pickup in AmmoVacuumRadius with one query, TriggerAmmo plays the pickup for all of them
+	void VacuumAmmo(class AAmmo* TriggerAmmo);
 };
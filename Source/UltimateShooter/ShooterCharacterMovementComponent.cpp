@@ -0,0 +1,202 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterCharacterMovementComponent.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/PlayerController.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "ShooterSimulationSubsystem.h"
+
+#include "UltimateShooter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Movement LOD Full"), STAT_MovementLODFull, STATGROUP_UltimateShooter);
+DECLARE_CYCLE_STAT(TEXT("Movement LOD Reduced"), STAT_MovementLODReduced, STATGROUP_UltimateShooter);
+DECLARE_CYCLE_STAT(TEXT("Movement LOD Minimal"), STAT_MovementLODMinimal, STATGROUP_UltimateShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Movement Ticks Full"), STAT_MovementTicksFull, STATGROUP_UltimateShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Movement Ticks Reduced"), STAT_MovementTicksReduced, STATGROUP_UltimateShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Movement Ticks Minimal"), STAT_MovementTicksMinimal, STATGROUP_UltimateShooter);
+
+static TAutoConsoleVariable<bool> CVarMovementLOD(
+	TEXT("Shooter.Movement.LOD"),
+	true,
+	TEXT("Select character movement LOD by distance to the local players (true) or keep every pawn at Full (false)"));
+
+static FAutoConsoleCommand GMovementLODCostsCommand(
+	TEXT("Shooter.Movement.LODCosts"),
+	TEXT("Logs the average character movement tick cost of every LOD since the last call"),
+	FConsoleCommandDelegate::CreateStatic(&UShooterCharacterMovementComponent::LogLODCosts));
+
+// Game thread only, every component ticks there
+static uint64 GMovementLODCycles[static_cast<int32>(EShooterMovementLOD::EML_MAX)]{};
+static uint32 GMovementLODTicks[static_cast<int32>(EShooterMovementLOD::EML_MAX)]{};
+
+UShooterCharacterMovementComponent::UShooterCharacterMovementComponent()
+	: MovementLOD(EShooterMovementLOD::EML_Full), ReducedDistance(2500.f), MinimalDistance(6000.f), LODUpdateInterval(0.25f),
+	MinimalTickInterval(0.1f), ReducedFloorReuse(2), MinimalFloorReuse(4), TimeToLODUpdate(0.f), FloorReuseCount(0),
+	FullMaxSimulationIterations(8), FullMaxSimulationTimeStep(0.05f), FullNetworkSmoothingMode(ENetworkSmoothingMode::Exponential)
+{
+	bWantsInitializeComponent = true;
+}
+
+void UShooterCharacterMovementComponent::InitializeComponent()
+{
+	Super::InitializeComponent();
+
+	FullMaxSimulationIterations = MaxSimulationIterations;
+	FullMaxSimulationTimeStep = MaxSimulationTimeStep;
+	FullNetworkSmoothingMode = NetworkSmoothingMode;
+
+	// Spread the LOD selections of pawns spawned on the same frame
+	TimeToLODUpdate = LODUpdateInterval * (GetUniqueID() % 16) / 16.f;
+}
+
+void UShooterCharacterMovementComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	TimeToLODUpdate -= DeltaTime;
+	if (TimeToLODUpdate <= 0.f)
+	{
+		TimeToLODUpdate = LODUpdateInterval;
+		const EShooterMovementLOD NewLOD{ ComputeMovementLOD() };
+		if (NewLOD != MovementLOD) { SetMovementLOD(NewLOD); }
+	}
+
+	const int32 LODIndex{ static_cast<int32>(MovementLOD) };
+	const uint64 StartCycles{ FPlatformTime::Cycles64() };
+	switch (MovementLOD)
+	{
+	case EShooterMovementLOD::EML_Full:
+	{
+		SCOPE_CYCLE_COUNTER(STAT_MovementLODFull);
+		INC_DWORD_STAT(STAT_MovementTicksFull);
+		Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+		break;
+	}
+	case EShooterMovementLOD::EML_Reduced:
+	{
+		SCOPE_CYCLE_COUNTER(STAT_MovementLODReduced);
+		INC_DWORD_STAT(STAT_MovementTicksReduced);
+		Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+		break;
+	}
+	default:
+	{
+		SCOPE_CYCLE_COUNTER(STAT_MovementLODMinimal);
+		INC_DWORD_STAT(STAT_MovementTicksMinimal);
+		Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+		break;
+	}
+	}
+	GMovementLODCycles[LODIndex] += FPlatformTime::Cycles64() - StartCycles;
+	++GMovementLODTicks[LODIndex];
+}
+
+EShooterMovementLOD UShooterCharacterMovementComponent::ComputeMovementLOD() const
+{
+	if (!CVarMovementLOD.GetValueOnGameThread() || !CharacterOwner || !UpdatedComponent) return EShooterMovementLOD::EML_Full;
+	// The player always gets full movement
+	if (CharacterOwner->IsLocallyControlled() && CharacterOwner->IsPlayerControlled()) return EShooterMovementLOD::EML_Full;
+
+	// Nearest local view, or player pawn on a server
+	const FVector Location{ UpdatedComponent->GetComponentLocation() };
+	float NearestDistanceSq{ MAX_flt };
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (!PlayerController) continue;
+
+		FVector ViewLocation;
+		if (PlayerController->IsLocalController())
+		{
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+		}
+		else if (const APawn* Pawn = PlayerController->GetPawn())
+		{
+			ViewLocation = Pawn->GetActorLocation();
+		}
+		else continue;
+
+		NearestDistanceSq = FMath::Min(NearestDistanceSq, static_cast<float>(FVector::DistSquared(Location, ViewLocation)));
+	}
+
+	if (NearestDistanceSq > FMath::Square(MinimalDistance)) return EShooterMovementLOD::EML_Minimal;
+	if (NearestDistanceSq > FMath::Square(ReducedDistance))
+	{
+		// Nobody sees it, nobody notices the lower tick rate. Servers and fast forward render nothing, distance only there
+		const bool bSeen{ GetNetMode() == NM_DedicatedServer || UShooterSimulationSubsystem::IsFastForwarding(this) || CharacterOwner->WasRecentlyRendered(0.25f) };
+		return bSeen ? EShooterMovementLOD::EML_Reduced : EShooterMovementLOD::EML_Minimal;
+	}
+	return EShooterMovementLOD::EML_Full;
+}
+
+void UShooterCharacterMovementComponent::SetMovementLOD(EShooterMovementLOD NewLOD)
+{
+	MovementLOD = NewLOD;
+	FloorReuseCount = 0;
+
+	switch (MovementLOD)
+	{
+	case EShooterMovementLOD::EML_Full:
+		MaxSimulationIterations = FullMaxSimulationIterations;
+		MaxSimulationTimeStep = FullMaxSimulationTimeStep;
+		NetworkSmoothingMode = FullNetworkSmoothingMode;
+		SetComponentTickInterval(0.f);
+		break;
+
+	case EShooterMovementLOD::EML_Reduced:
+		// No sub stepping, proxies interpolated
+		MaxSimulationIterations = 1;
+		MaxSimulationTimeStep = 0.1f;
+		NetworkSmoothingMode = ENetworkSmoothingMode::Linear;
+		SetComponentTickInterval(0.f);
+		break;
+
+	default:
+		MaxSimulationIterations = 1;
+		MaxSimulationTimeStep = FMath::Max(0.1f, MinimalTickInterval * 1.5f);
+		NetworkSmoothingMode = ENetworkSmoothingMode::Linear;
+		SetComponentTickInterval(MinimalTickInterval);
+		break;
+	}
+}
+
+void UShooterCharacterMovementComponent::FindFloor(const FVector& CapsuleLocation, FFindFloorResult& OutFloorResult, bool bCanUseCachedLocation, const FHitResult* DownwardSweepResult) const
+{
+	int32 FloorReuse{ 0 };
+	if (MovementLOD == EShooterMovementLOD::EML_Reduced) { FloorReuse = ReducedFloorReuse; }
+	else if (MovementLOD == EShooterMovementLOD::EML_Minimal) { FloorReuse = MinimalFloorReuse; }
+
+	// Distant pawns keep walking on the last floor for a few moves
+	if (FloorReuseCount < FloorReuse && !DownwardSweepResult && IsMovingOnGround() && CurrentFloor.IsWalkableFloor())
+	{
+		++FloorReuseCount;
+		OutFloorResult = CurrentFloor;
+		return;
+	}
+
+	FloorReuseCount = 0;
+	Super::FindFloor(CapsuleLocation, OutFloorResult, bCanUseCachedLocation, DownwardSweepResult);
+}
+
+void UShooterCharacterMovementComponent::OnTeleported()
+{
+	// The cached floor is somewhere else now
+	FloorReuseCount = MAX_int32;
+
+	Super::OnTeleported();
+}
+
+void UShooterCharacterMovementComponent::LogLODCosts()
+{
+	static const TCHAR* LODNames[]{ TEXT("Full"), TEXT("Reduced"), TEXT("Minimal") };
+	for (int32 LODIndex = 0; LODIndex < static_cast<int32>(EShooterMovementLOD::EML_MAX); ++LODIndex)
+	{
+		const uint32 NumTicks{ GMovementLODTicks[LODIndex] };
+		const double AverageUs{ NumTicks > 0 ? FPlatformTime::ToMilliseconds64(GMovementLODCycles[LODIndex]) * 1000.0 / NumTicks : 0.0 };
+		UE_LOG(LogUltimateShooter, Log, TEXT("Movement LOD %s: %u pawn ticks, %.2f us per pawn tick"), LODNames[LODIndex], NumTicks, AverageUs);
+
+		GMovementLODCycles[LODIndex] = 0;
+		GMovementLODTicks[LODIndex] = 0;
+	}
+}
@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "ShooterCharacterMovementComponent.generated.h"
+
+UENUM(BlueprintType)
+enum class EShooterMovementLOD : uint8
+{
+	// Every frame, sub stepped, floor checked every move
+	EML_Full UMETA(DisplayName = "Full"),
+	// Every frame, one step, floor reused for a few frames
+	EML_Reduced UMETA(DisplayName = "Reduced"),
+	// Low tick rate, one step, floor reused longer
+	EML_Minimal UMETA(DisplayName = "Minimal"),
+
+	EML_MAX UMETA(DisplayName = "DefaultMAX")
+};
+
+/**
+ * Character movement with cheaper tiers for pawns far from every local player or not rendered.
+ * The locally controlled player pawn always moves at full quality.
+ */
+UCLASS(Config = Game)
+class ULTIMATESHOOTER_API UShooterCharacterMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+	UShooterCharacterMovementComponent();
+
+	virtual void InitializeComponent() override;
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	virtual void FindFloor(const FVector& CapsuleLocation, FFindFloorResult& OutFloorResult, bool bCanUseCachedLocation, const FHitResult* DownwardSweepResult = nullptr) const override;
+	virtual void OnTeleported() override;
+
+	FORCEINLINE EShooterMovementLOD GetMovementLOD() const { return MovementLOD; }
+	void SetMovementLOD(EShooterMovementLOD NewLOD);
+
+	// Logs the average tick cost per pawn of every LOD since the last call
+	static void LogLODCosts();
+
+protected:
+	EShooterMovementLOD ComputeMovementLOD() const;
+
+private:
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement LOD", meta = (AllowPrivateAccess = "true"))
+	EShooterMovementLOD MovementLOD;
+
+	// Pawns farther than this from every local player use Reduced
+	UPROPERTY(Config, EditAnywhere, Category = "Movement LOD", meta = (AllowPrivateAccess = "true"))
+	float ReducedDistance;
+
+	// Pawns farther than this, or not rendered and past ReducedDistance, use Minimal
+	UPROPERTY(Config, EditAnywhere, Category = "Movement LOD", meta = (AllowPrivateAccess = "true"))
+	float MinimalDistance;
+
+	// Time between LOD selections
+	UPROPERTY(Config, EditAnywhere, Category = "Movement LOD", meta = (AllowPrivateAccess = "true"))
+	float LODUpdateInterval;
+
+	UPROPERTY(Config, EditAnywhere, Category = "Movement LOD", meta = (AllowPrivateAccess = "true"))
+	float MinimalTickInterval;
+
+	// Moves the floor is reused for before a new floor sweep, per LOD
+	UPROPERTY(Config, EditAnywhere, Category = "Movement LOD", meta = (AllowPrivateAccess = "true"))
+	int32 ReducedFloorReuse;
+
+	UPROPERTY(Config, EditAnywhere, Category = "Movement LOD", meta = (AllowPrivateAccess = "true"))
+	int32 MinimalFloorReuse;
+
+	float TimeToLODUpdate;
+	mutable int32 FloorReuseCount;
+
+	// Full LOD settings, restored when coming back to Full
+	int32 FullMaxSimulationIterations;
+	float FullMaxSimulationTimeStep;
+	ENetworkSmoothingMode FullNetworkSmoothingMode;
+};
@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterCrosshairWidget.h"
+#include "Rendering/DrawElements.h"
+
+#include "ShooterCharacter.h"
+
+void UShooterCrosshairWidget::NativeConstruct()
+{
+	Super::NativeConstruct();
+
+	// Repainted every frame, keeps the invalidation of the rest of the HUD intact
+	ForceVolatile(true);
+}
+
+int32 UShooterCrosshairWidget::NativePaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect,
+	FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const
+{
+	LayerId = Super::NativePaint(Args, AllottedGeometry, MyCullingRect, OutDrawElements, LayerId, InWidgetStyle, bParentEnabled);
+
+	const AShooterCharacter* ShooterCharacter = Cast<AShooterCharacter>(GetOwningPlayerPawn());
+	if (!ShooterCharacter) return LayerId;
+
+	const float Spread{ ShooterCharacter->GetCrosshairSpreadMultiplier() * CrosshairSpreadDistance };
+
+	++LayerId;
+	PaintCrosshairPart(CrosshairCenter, FVector2f(0.f, 0.f), AllottedGeometry, OutDrawElements, LayerId, InWidgetStyle);
+	PaintCrosshairPart(CrosshairLeft, FVector2f(-Spread, 0.f), AllottedGeometry, OutDrawElements, LayerId, InWidgetStyle);
+	PaintCrosshairPart(CrosshairRight, FVector2f(Spread, 0.f), AllottedGeometry, OutDrawElements, LayerId, InWidgetStyle);
+	PaintCrosshairPart(CrosshairTop, FVector2f(0.f, -Spread), AllottedGeometry, OutDrawElements, LayerId, InWidgetStyle);
+	PaintCrosshairPart(CrosshairBottom, FVector2f(0.f, Spread), AllottedGeometry, OutDrawElements, LayerId, InWidgetStyle);
+
+	return LayerId;
+}
+
+void UShooterCrosshairWidget::PaintCrosshairPart(const FSlateBrush& Brush, const FVector2f& Offset, const FGeometry& AllottedGeometry,
+	FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle) const
+{
+	if (Brush.DrawAs == ESlateBrushDrawType::NoDrawType) return;
+
+	const FVector2f Size{ Brush.GetImageSize() };
+	const FVector2f LocalSize{ AllottedGeometry.GetLocalSize() };
+	const FVector2f Position{ (LocalSize - Size) * 0.5f + Offset };
+
+	FSlateDrawElement::MakeBox(OutDrawElements, LayerId, AllottedGeometry.ToPaintGeometry(Size, FSlateLayoutTransform(Position)), &Brush,
+		ESlateDrawEffect::None, InWidgetStyle.GetColorAndOpacityTint() * Brush.GetTint(InWidgetStyle));
+}
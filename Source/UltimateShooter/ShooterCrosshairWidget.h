@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "Styling/SlateBrush.h"
+#include "ShooterCrosshairWidget.generated.h"
+
+/**
+ * Crosshair painted natively from the owning character's spread.
+ * It is the only volatile part of the HUD, the rest of the overlay can be cached.
+ */
+UCLASS()
+class ULTIMATESHOOTER_API UShooterCrosshairWidget : public UUserWidget
+{
+	GENERATED_BODY()
+
+protected:
+	virtual void NativeConstruct() override;
+
+	virtual int32 NativePaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect,
+		FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const override;
+
+	// Draws Brush centered on the widget, moved by Offset
+	void PaintCrosshairPart(const FSlateBrush& Brush, const FVector2f& Offset, const FGeometry& AllottedGeometry,
+		FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle) const;
+
+private:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Crosshairs, meta = (AllowPrivateAccess = "true"))
+	FSlateBrush CrosshairCenter;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Crosshairs, meta = (AllowPrivateAccess = "true"))
+	FSlateBrush CrosshairLeft;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Crosshairs, meta = (AllowPrivateAccess = "true"))
+	FSlateBrush CrosshairRight;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Crosshairs, meta = (AllowPrivateAccess = "true"))
+	FSlateBrush CrosshairTop;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Crosshairs, meta = (AllowPrivateAccess = "true"))
+	FSlateBrush CrosshairBottom;
+
+	// Distance from the center of each crosshair part per unit of spread multiplier
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Crosshairs, meta = (AllowPrivateAccess = "true"))
+	float CrosshairSpreadDistance{ 16.f };
+};
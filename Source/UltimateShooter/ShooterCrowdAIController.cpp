@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterCrowdAIController.h"
+#include "ShooterCharacter.h"
+#include "ShooterHealthComponent.h"
+
+AShooterCrowdAIController::AShooterCrowdAIController()
+{
+	PrimaryActorTick.bCanEverTick = true;
+}
+
+void AShooterCrowdAIController::StartCombat(AActor* InTarget, float InEngageDistance, float InFireInterval, float InFireCooldown)
+{
+	Target = InTarget;
+	EngageDistance = InEngageDistance;
+	FireInterval = InFireInterval;
+	FireCooldown = InFireCooldown;
+
+	// Control rotation follows the focus, the character yaw and its aim follow the control rotation
+	if (InTarget) { SetFocus(InTarget); }
+	else { ClearFocus(EAIFocusPriority::Gameplay); }
+}
+
+void AShooterCrowdAIController::StopCombat()
+{
+	Target.Reset();
+	ClearFocus(EAIFocusPriority::Gameplay);
+}
+
+void AShooterCrowdAIController::OnUnPossess()
+{
+	StopCombat();
+
+	Super::OnUnPossess();
+}
+
+void AShooterCrowdAIController::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	AShooterCharacter* ShooterCharacter = GetPawn<AShooterCharacter>();
+	AActor* CurrentTarget = Target.Get();
+	if (!ShooterCharacter || !CurrentTarget) return;
+
+	if (ShooterCharacter->GetHealthComponent()->IsDead())
+	{
+		StopCombat();
+		return;
+	}
+
+	FireCooldown = FMath::Max(FireCooldown - DeltaTime, 0.f);
+	if (FireCooldown > 0.f || !CanShootTarget(CurrentTarget)) return;
+
+	if (ShooterCharacter->PullTrigger()) { FireCooldown = FireInterval; }
+}
+
+bool AShooterCrowdAIController::CanShootTarget(const AActor* CurrentTarget) const
+{
+	const UShooterHealthComponent* TargetHealth = CurrentTarget->FindComponentByClass<UShooterHealthComponent>();
+	if (TargetHealth && TargetHealth->IsDead()) return false;
+
+	if (FVector::DistSquared(GetPawn()->GetActorLocation(), CurrentTarget->GetActorLocation()) > FMath::Square(EngageDistance)) return false;
+
+	return LineOfSightTo(CurrentTarget);
+}
@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AIController.h"
+#include "ShooterCrowdAIController.generated.h"
+
+/**
+ * Brain of a promoted crowd combatant. Takes over the target and fire cadence of the simulated entity,
+ * keeps the character facing the target and fires its weapon every FireInterval while the target is in sight,
+ * the cadence goes back to the entity on demotion.
+ */
+UCLASS()
+class ULTIMATESHOOTER_API AShooterCrowdAIController : public AAIController
+{
+	GENERATED_BODY()
+
+public:
+	AShooterCrowdAIController();
+
+	virtual void Tick(float DeltaTime) override;
+
+	void StartCombat(AActor* InTarget, float InEngageDistance, float InFireInterval, float InFireCooldown);
+	void StopCombat();
+
+	AActor* GetTarget() const { return Target.Get(); }
+	float GetFireCooldown() const { return FireCooldown; }
+
+protected:
+	virtual void OnUnPossess() override;
+
+	// Alive, in range and in sight
+	bool CanShootTarget(const AActor* CurrentTarget) const;
+
+private:
+	TWeakObjectPtr<AActor> Target;
+	float EngageDistance{ 0.f };
+	float FireInterval{ 0.5f };
+	// Seconds until the next shot
+	float FireCooldown{ 0.f };
+};
@@ -0,0 +1,108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityTypes.h"
+#include "ShooterCrowdFragments.generated.h"
+
+class AShooterCharacter;
+
+// Every crowd combatant
+USTRUCT()
+struct FShooterCrowdTag : public FMassTag
+{
+	GENERATED_BODY()
+};
+
+// Combatant currently shown by a full AShooterCharacter, the simulation processors skip it
+USTRUCT()
+struct FShooterCrowdPromotedTag : public FMassTag
+{
+	GENERATED_BODY()
+};
+
+USTRUCT()
+struct FShooterCrowdMoveFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	// Wander area center, the spawn location
+	FVector Home{ ForceInit };
+	FVector Destination{ ForceInit };
+	FVector Velocity{ ForceInit };
+	// Random state for the wander destinations
+	uint32 Seed{ 0 };
+	bool bHasHome{ false };
+	// Where the ground was last traced, traced again once the combatant walked GroundCheckDistance away
+	FVector LastGroundCheck{ ForceInit };
+	bool bHasGround{ false };
+};
+
+USTRUCT()
+struct FShooterCrowdWeaponFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	// Negative until the first update fills the magazine
+	int32 Ammo{ INDEX_NONE };
+	float Cooldown{ 0.f };
+	float ReloadRemaining{ 0.f };
+	bool bFiredThisFrame{ false };
+};
+
+// Nearest player, written by the representation processor
+USTRUCT()
+struct FShooterCrowdTargetFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	TWeakObjectPtr<AActor> Target;
+	FVector TargetLocation{ ForceInit };
+	float DistanceSq{ MAX_flt };
+};
+
+USTRUCT()
+struct FShooterCrowdActorFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	TWeakObjectPtr<AShooterCharacter> Actor;
+};
+
+// Tuning shared by every combatant of a config
+USTRUCT()
+struct FShooterCrowdParams : public FMassSharedFragment
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category = Movement)
+	float WalkSpeed{ 300.f };
+
+	UPROPERTY(EditAnywhere, Category = Movement)
+	float WanderRadius{ 3000.f };
+
+	// Combatants closer than this to a player stop and shoot at them
+	UPROPERTY(EditAnywhere, Category = Combat)
+	float EngageDistance{ 8000.f };
+
+	UPROPERTY(EditAnywhere, Category = Combat)
+	float FireInterval{ 0.5f };
+
+	UPROPERTY(EditAnywhere, Category = Combat)
+	int32 MagazineCapacity{ 30 };
+
+	UPROPERTY(EditAnywhere, Category = Combat)
+	float ReloadTime{ 2.5f };
+
+	UPROPERTY(EditAnywhere, Category = Combat)
+	float ShotDamage{ 10.f };
+
+	// Chance a simulated shot hits at point blank, falls to zero at EngageDistance
+	UPROPERTY(EditAnywhere, Category = Combat, meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float HitChance{ 0.3f };
+
+	// Entity origin above the ground, the capsule half height of the promoted character
+	UPROPERTY(EditAnywhere, Category = Movement)
+	float HeightAboveGround{ 88.f };
+};
@@ -0,0 +1,305 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterCrowdProcessors.h"
+#include "MassCommonTypes.h"
+#include "MassCommonFragments.h"
+#include "MassExecutionContext.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/Pawn.h"
+#include "ShooterCrowdFragments.h"
+#include "ShooterCrowdSubsystem.h"
+#include "ShooterCharacter.h"
+#include "ShooterHealthComponent.h"
+
+#include "UltimateShooter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Crowd Movement"), STAT_CrowdMovement, STATGROUP_UltimateShooter);
+DECLARE_CYCLE_STAT(TEXT("Crowd Weapons"), STAT_CrowdWeapons, STATGROUP_UltimateShooter);
+DECLARE_CYCLE_STAT(TEXT("Crowd Representation"), STAT_CrowdRepresentation, STATGROUP_UltimateShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Crowd Shots"), STAT_CrowdShots, STATGROUP_UltimateShooter);
+
+// Height of the tracer start above the entity origin
+static constexpr float CrowdMuzzleHeight{ 60.f };
+
+UShooterCrowdMovementProcessor::UShooterCrowdMovementProcessor() :
+	EntityQuery(*this)
+{
+	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::All);
+	ExecutionOrder.ExecuteInGroup = UE::Mass::ProcessorGroupNames::Movement;
+	bAutoRegisterWithProcessingPhases = true;
+}
+
+void UShooterCrowdMovementProcessor::ConfigureQueries()
+{
+	EntityQuery.AddRequirement<FTransformFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddRequirement<FShooterCrowdMoveFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddRequirement<FShooterCrowdTargetFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddConstSharedRequirement<FShooterCrowdParams>();
+	EntityQuery.AddTagRequirement<FShooterCrowdTag>(EMassFragmentPresence::All);
+	EntityQuery.AddTagRequirement<FShooterCrowdPromotedTag>(EMassFragmentPresence::None);
+}
+
+void UShooterCrowdMovementProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CrowdMovement);
+
+	EntityQuery.ParallelForEachEntityChunk(EntityManager, Context, [](FMassExecutionContext& Context)
+	{
+		const FShooterCrowdParams& Params = Context.GetConstSharedFragment<FShooterCrowdParams>();
+		const TArrayView<FTransformFragment> Transforms = Context.GetMutableFragmentView<FTransformFragment>();
+		const TArrayView<FShooterCrowdMoveFragment> Moves = Context.GetMutableFragmentView<FShooterCrowdMoveFragment>();
+		const TConstArrayView<FShooterCrowdTargetFragment> Targets = Context.GetFragmentView<FShooterCrowdTargetFragment>();
+
+		const float DeltaTime{ Context.GetDeltaTimeSeconds() };
+		const float Step{ Params.WalkSpeed * DeltaTime };
+		const float EngageDistanceSq{ FMath::Square(Params.EngageDistance) };
+
+		for (int32 Index = 0; Index < Context.GetNumEntities(); ++Index)
+		{
+			FTransform& Transform = Transforms[Index].GetMutableTransform();
+			FShooterCrowdMoveFragment& Move = Moves[Index];
+			FVector Location{ Transform.GetLocation() };
+
+			if (!Move.bHasHome)
+			{
+				Move.Home = Location;
+				Move.Destination = Location;
+				Move.Seed = GetTypeHash(Context.GetEntity(Index));
+				Move.bHasHome = true;
+			}
+
+			// Engaged, stand and face the player
+			if (Targets[Index].DistanceSq < EngageDistanceSq)
+			{
+				Move.Velocity = FVector::ZeroVector;
+				const FVector ToTarget{ (Targets[Index].TargetLocation - Location).GetSafeNormal2D() };
+				if (!ToTarget.IsZero()) { Transform.SetRotation(ToTarget.ToOrientationQuat()); }
+				continue;
+			}
+
+			FVector ToDestination{ Move.Destination - Location };
+			ToDestination.Z = 0.f;
+			if (ToDestination.SizeSquared() <= FMath::Square(Step))
+			{
+				// Next wander point around home
+				FRandomStream Random{ static_cast<int32>(Move.Seed) };
+				Move.Seed = Random.GetUnsignedInt();
+				const float Angle{ Random.FRandRange(0.f, UE_TWO_PI) };
+				const float Radius{ Params.WanderRadius * FMath::Sqrt(Random.GetFraction()) };
+				Move.Destination = Move.Home + FVector{ FMath::Cos(Angle) * Radius, FMath::Sin(Angle) * Radius, 0.f };
+				continue;
+			}
+
+			Move.Velocity = ToDestination.GetUnsafeNormal() * Params.WalkSpeed;
+			Location += Move.Velocity * DeltaTime;
+			Transform.SetLocation(Location);
+			Transform.SetRotation(Move.Velocity.ToOrientationQuat());
+		}
+	});
+}
+
+UShooterCrowdWeaponProcessor::UShooterCrowdWeaponProcessor() :
+	EntityQuery(*this)
+{
+	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::All);
+	ExecutionOrder.ExecuteInGroup = UE::Mass::ProcessorGroupNames::Tasks;
+	bAutoRegisterWithProcessingPhases = true;
+}
+
+void UShooterCrowdWeaponProcessor::ConfigureQueries()
+{
+	EntityQuery.AddRequirement<FShooterCrowdWeaponFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddRequirement<FShooterCrowdTargetFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddConstSharedRequirement<FShooterCrowdParams>();
+	EntityQuery.AddTagRequirement<FShooterCrowdTag>(EMassFragmentPresence::All);
+	EntityQuery.AddTagRequirement<FShooterCrowdPromotedTag>(EMassFragmentPresence::None);
+}
+
+void UShooterCrowdWeaponProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CrowdWeapons);
+
+	EntityQuery.ParallelForEachEntityChunk(EntityManager, Context, [](FMassExecutionContext& Context)
+	{
+		const FShooterCrowdParams& Params = Context.GetConstSharedFragment<FShooterCrowdParams>();
+		const TArrayView<FShooterCrowdWeaponFragment> Weapons = Context.GetMutableFragmentView<FShooterCrowdWeaponFragment>();
+		const TConstArrayView<FShooterCrowdTargetFragment> Targets = Context.GetFragmentView<FShooterCrowdTargetFragment>();
+
+		const float DeltaTime{ Context.GetDeltaTimeSeconds() };
+		const float EngageDistanceSq{ FMath::Square(Params.EngageDistance) };
+		int32 NumShots{ 0 };
+
+		for (int32 Index = 0; Index < Context.GetNumEntities(); ++Index)
+		{
+			FShooterCrowdWeaponFragment& Weapon = Weapons[Index];
+			Weapon.bFiredThisFrame = false;
+			if (Weapon.Ammo < 0) { Weapon.Ammo = Params.MagazineCapacity; }
+
+			if (Weapon.ReloadRemaining > 0.f)
+			{
+				Weapon.ReloadRemaining -= DeltaTime;
+				if (Weapon.ReloadRemaining <= 0.f) { Weapon.Ammo = Params.MagazineCapacity; }
+				continue;
+			}
+
+			Weapon.Cooldown = FMath::Max(Weapon.Cooldown - DeltaTime, 0.f);
+			if (Weapon.Cooldown > 0.f || Targets[Index].DistanceSq >= EngageDistanceSq) continue;
+
+			--Weapon.Ammo;
+			Weapon.Cooldown = Params.FireInterval;
+			Weapon.bFiredThisFrame = true;
+			if (Weapon.Ammo <= 0) { Weapon.ReloadRemaining = Params.ReloadTime; }
+			++NumShots;
+		}
+
+		INC_DWORD_STAT_BY(STAT_CrowdShots, NumShots);
+	});
+}
+
+UShooterCrowdRepresentationProcessor::UShooterCrowdRepresentationProcessor() :
+	SimulatedQuery(*this), PromotedQuery(*this)
+{
+	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::All);
+	ExecutionOrder.ExecuteInGroup = UE::Mass::ProcessorGroupNames::Representation;
+	ExecutionOrder.ExecuteAfter.Add(UE::Mass::ProcessorGroupNames::Movement);
+	ExecutionOrder.ExecuteAfter.Add(UE::Mass::ProcessorGroupNames::Tasks);
+	bAutoRegisterWithProcessingPhases = true;
+	// Spawns, moves and pools actors
+	bRequiresGameThreadExecution = true;
+}
+
+void UShooterCrowdRepresentationProcessor::ConfigureQueries()
+{
+	SimulatedQuery.AddRequirement<FTransformFragment>(EMassFragmentAccess::ReadWrite);
+	SimulatedQuery.AddRequirement<FShooterCrowdMoveFragment>(EMassFragmentAccess::ReadWrite);
+	SimulatedQuery.AddRequirement<FShooterCrowdWeaponFragment>(EMassFragmentAccess::ReadOnly);
+	SimulatedQuery.AddRequirement<FShooterCrowdTargetFragment>(EMassFragmentAccess::ReadWrite);
+	SimulatedQuery.AddRequirement<FShooterCrowdActorFragment>(EMassFragmentAccess::ReadWrite);
+	SimulatedQuery.AddConstSharedRequirement<FShooterCrowdParams>();
+	SimulatedQuery.AddTagRequirement<FShooterCrowdTag>(EMassFragmentPresence::All);
+	SimulatedQuery.AddTagRequirement<FShooterCrowdPromotedTag>(EMassFragmentPresence::None);
+
+	PromotedQuery.AddRequirement<FTransformFragment>(EMassFragmentAccess::ReadWrite);
+	PromotedQuery.AddRequirement<FShooterCrowdWeaponFragment>(EMassFragmentAccess::ReadWrite);
+	PromotedQuery.AddRequirement<FShooterCrowdTargetFragment>(EMassFragmentAccess::ReadWrite);
+	PromotedQuery.AddRequirement<FShooterCrowdActorFragment>(EMassFragmentAccess::ReadWrite);
+	PromotedQuery.AddConstSharedRequirement<FShooterCrowdParams>();
+	PromotedQuery.AddTagRequirement<FShooterCrowdTag>(EMassFragmentPresence::All);
+	PromotedQuery.AddTagRequirement<FShooterCrowdPromotedTag>(EMassFragmentPresence::All);
+}
+
+void UShooterCrowdRepresentationProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CrowdRepresentation);
+
+	UWorld* World = EntityManager.GetWorld();
+	UShooterCrowdSubsystem* Crowd = UShooterCrowdSubsystem::Get(World);
+	if (!Crowd) return;
+
+	PlayerLocations.Reset();
+	PlayerPawns.Reset();
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		APawn* Pawn = It->Get() ? It->Get()->GetPawn() : nullptr;
+		if (!Pawn) continue;
+
+		PlayerLocations.Add(Pawn->GetActorLocation());
+		PlayerPawns.Add(Pawn);
+	}
+
+	// Nearest player into the target, MAX_flt distance without players
+	auto FindNearestPlayer = [this](const FVector& Location, FShooterCrowdTargetFragment& Target)
+	{
+		Target.DistanceSq = MAX_flt;
+		Target.Target.Reset();
+		for (int32 PlayerIndex = 0; PlayerIndex < PlayerLocations.Num(); ++PlayerIndex)
+		{
+			const float DistanceSq{ static_cast<float>(FVector::DistSquared(Location, PlayerLocations[PlayerIndex])) };
+			if (DistanceSq < Target.DistanceSq)
+			{
+				Target.DistanceSq = DistanceSq;
+				Target.TargetLocation = PlayerLocations[PlayerIndex];
+				Target.Target = PlayerPawns[PlayerIndex];
+			}
+		}
+	};
+
+	const float PromoteDistanceSq{ FMath::Square(Crowd->GetPromoteDistance()) };
+	const float DemoteDistanceSq{ FMath::Square(Crowd->GetDemoteDistance()) };
+
+	// Promoted combatants first, demotions free actors for this frame promotions
+	PromotedQuery.ForEachEntityChunk(EntityManager, Context, [&](FMassExecutionContext& Context)
+	{
+		const FShooterCrowdParams& Params = Context.GetConstSharedFragment<FShooterCrowdParams>();
+		const TArrayView<FTransformFragment> Transforms = Context.GetMutableFragmentView<FTransformFragment>();
+		const TArrayView<FShooterCrowdWeaponFragment> Weapons = Context.GetMutableFragmentView<FShooterCrowdWeaponFragment>();
+		const TArrayView<FShooterCrowdTargetFragment> Targets = Context.GetMutableFragmentView<FShooterCrowdTargetFragment>();
+		const TArrayView<FShooterCrowdActorFragment> Actors = Context.GetMutableFragmentView<FShooterCrowdActorFragment>();
+
+		for (int32 Index = 0; Index < Context.GetNumEntities(); ++Index)
+		{
+			AShooterCharacter* Actor = Actors[Index].Actor.Get();
+			if (!Actor)
+			{
+				// Actor went away without a death, back to the simulation
+				Crowd->ForgetEntity(Context.GetEntity(Index));
+				Context.Defer().RemoveTag<FShooterCrowdPromotedTag>(Context.GetEntity(Index));
+				continue;
+			}
+			// Dead ones are destroyed by the subsystem
+			if (Actor->GetHealthComponent()->IsDead()) continue;
+
+			FTransform& Transform = Transforms[Index].GetMutableTransform();
+			Transform.SetLocation(Actor->GetActorLocation());
+			Transform.SetRotation(Actor->GetActorQuat());
+			FindNearestPlayer(Transform.GetLocation(), Targets[Index]);
+
+			if (Targets[Index].DistanceSq > DemoteDistanceSq)
+			{
+				Crowd->DemoteEntity(Actor, Weapons[Index], Params);
+				Actors[Index].Actor.Reset();
+				Context.Defer().RemoveTag<FShooterCrowdPromotedTag>(Context.GetEntity(Index));
+			}
+		}
+	});
+
+	Crowd->BeginRepresentation();
+
+	SimulatedQuery.ForEachEntityChunk(EntityManager, Context, [&](FMassExecutionContext& Context)
+	{
+		const FShooterCrowdParams& Params = Context.GetConstSharedFragment<FShooterCrowdParams>();
+		const TArrayView<FTransformFragment> Transforms = Context.GetMutableFragmentView<FTransformFragment>();
+		const TArrayView<FShooterCrowdMoveFragment> Moves = Context.GetMutableFragmentView<FShooterCrowdMoveFragment>();
+		const TConstArrayView<FShooterCrowdWeaponFragment> Weapons = Context.GetFragmentView<FShooterCrowdWeaponFragment>();
+		const TArrayView<FShooterCrowdTargetFragment> Targets = Context.GetMutableFragmentView<FShooterCrowdTargetFragment>();
+		const TArrayView<FShooterCrowdActorFragment> Actors = Context.GetMutableFragmentView<FShooterCrowdActorFragment>();
+
+		for (int32 Index = 0; Index < Context.GetNumEntities(); ++Index)
+		{
+			FTransform& Transform = Transforms[Index].GetMutableTransform();
+			FShooterCrowdTargetFragment& Target = Targets[Index];
+			Crowd->FollowGround(Transform, Moves[Index], Params);
+			FindNearestPlayer(Transform.GetLocation(), Target);
+
+			if (Target.DistanceSq < PromoteDistanceSq && Crowd->CanPromote())
+			{
+				if (AShooterCharacter* Actor = Crowd->PromoteEntity(Context.GetEntity(Index), Transform, Weapons[Index], Target, Params))
+				{
+					Actors[Index].Actor = Actor;
+					Context.Defer().AddTag<FShooterCrowdPromotedTag>(Context.GetEntity(Index));
+					continue;
+				}
+			}
+
+			Crowd->AddInstance(Transform);
+			if (Weapons[Index].bFiredThisFrame)
+			{
+				Crowd->AddShot(Transform.GetLocation() + FVector{ 0.f, 0.f, CrowdMuzzleHeight }, Target, Params);
+			}
+		}
+	});
+
+	Crowd->EndRepresentation();
+}
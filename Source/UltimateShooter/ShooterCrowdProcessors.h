@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassProcessor.h"
+#include "MassEntityQuery.h"
+#include "ShooterCrowdProcessors.generated.h"
+
+/**
+ * Wander and engage movement of the simulated combatants, chunks processed in parallel
+ */
+UCLASS()
+class ULTIMATESHOOTER_API UShooterCrowdMovementProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+	UShooterCrowdMovementProcessor();
+
+protected:
+	virtual void ConfigureQueries() override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+private:
+	FMassEntityQuery EntityQuery;
+};
+
+/**
+ * Fire cadence, ammo and reloads of the simulated combatants, chunks processed in parallel
+ */
+UCLASS()
+class ULTIMATESHOOTER_API UShooterCrowdWeaponProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+	UShooterCrowdWeaponProcessor();
+
+protected:
+	virtual void ConfigureQueries() override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+private:
+	FMassEntityQuery EntityQuery;
+};
+
+/**
+ * Game thread side of the crowd: nearest player, instance transforms and tracers for the simulated combatants,
+ * promotion to a full AShooterCharacter close to a player and demotion back once far enough.
+ */
+UCLASS()
+class ULTIMATESHOOTER_API UShooterCrowdRepresentationProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+	UShooterCrowdRepresentationProcessor();
+
+protected:
+	virtual void ConfigureQueries() override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+private:
+	FMassEntityQuery SimulatedQuery;
+	FMassEntityQuery PromotedQuery;
+
+	TArray<FVector> PlayerLocations;
+	TArray<AActor*> PlayerPawns;
+};
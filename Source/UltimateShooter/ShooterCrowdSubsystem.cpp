@@ -0,0 +1,321 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterCrowdSubsystem.h"
+#include "Engine/World.h"
+#include "Engine/StaticMesh.h"
+#include "TimerManager.h"
+#include "GameFramework/PlayerController.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "MassEntitySubsystem.h"
+#include "MassSpawnerSubsystem.h"
+#include "MassEntityConfigAsset.h"
+#include "MassCommonFragments.h"
+#include "ShooterCharacter.h"
+#include "Weapon.h"
+#include "ShooterDamageSubsystem.h"
+#include "ShooterEffectsSubsystem.h"
+#include "ShooterPawnPoolSubsystem.h"
+#include "ShooterCrowdAIController.h"
+#include "ShooterSimulationSubsystem.h"
+#include "Particles/ParticleSystem.h"
+
+#include "UltimateShooter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Crowd Instances Update"), STAT_CrowdInstancesUpdate, STATGROUP_UltimateShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Crowd Instances"), STAT_CrowdInstances, STATGROUP_UltimateShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Crowd Promoted"), STAT_CrowdPromoted, STATGROUP_UltimateShooter);
+
+// Ground traces start above the combatant, so it finds the way back up a slope
+static constexpr float CrowdGroundTraceUp{ 500.f };
+static constexpr float CrowdGroundTraceDown{ 2000.f };
+
+static FAutoConsoleCommandWithWorldAndArgs GCrowdSpawnCommand(
+	TEXT("Shooter.Crowd.Spawn"),
+	TEXT("Shooter.Crowd.Spawn [Count=1000] [Radius=20000] - spawns crowd combatants around the player"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UShooterCrowdSubsystem* Crowd = UShooterCrowdSubsystem::Get(World);
+		if (!Crowd) return;
+
+		const APlayerController* PlayerController = World->GetFirstPlayerController();
+		const APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+		const FVector Origin{ Pawn ? Pawn->GetActorLocation() : FVector::ZeroVector };
+
+		const int32 Count{ Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1'000 };
+		const float Radius{ Args.Num() > 1 ? FCString::Atof(*Args[1]) : 20'000.f };
+		const int32 NumSpawned{ Crowd->SpawnCrowd(Count, Origin, Radius) };
+
+		UE_LOG(LogUltimateShooter, Log, TEXT("Spawned %d/%d crowd combatants"), NumSpawned, Count);
+	}));
+
+bool UShooterCrowdSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+UShooterCrowdSubsystem* UShooterCrowdSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UShooterCrowdSubsystem>() : nullptr;
+}
+
+void UShooterCrowdSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	if (UShooterDamageSubsystem* Damage = Collection.InitializeDependency<UShooterDamageSubsystem>())
+	{
+		KilledHandle = Damage->OnKilled().AddUObject(this, &UShooterCrowdSubsystem::OnKilled);
+	}
+}
+
+void UShooterCrowdSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	CrowdTracerSystem = CrowdTracer.LoadSynchronous();
+
+	UStaticMesh* Mesh = CrowdMesh.LoadSynchronous();
+	if (!Mesh) return;
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.ObjectFlags |= RF_Transient;
+	AActor* CrowdActor = InWorld.SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParameters);
+	if (!CrowdActor) return;
+
+	CrowdInstances = NewObject<UInstancedStaticMeshComponent>(CrowdActor, TEXT("CrowdInstances"));
+	CrowdInstances->SetMobility(EComponentMobility::Movable);
+	CrowdInstances->SetStaticMesh(Mesh);
+	CrowdInstances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	CrowdActor->SetRootComponent(CrowdInstances);
+	CrowdInstances->RegisterComponent();
+}
+
+void UShooterCrowdSubsystem::Deinitialize()
+{
+	if (UShooterDamageSubsystem* Damage = UShooterDamageSubsystem::Get(this)) { Damage->OnKilled().Remove(KilledHandle); }
+
+	if (CrowdInstances && CrowdInstances->GetOwner()) { CrowdInstances->GetOwner()->Destroy(); }
+	CrowdInstances = nullptr;
+	CrowdTracerSystem = nullptr;
+	EntityByActor.Empty();
+
+	Super::Deinitialize();
+}
+
+int32 UShooterCrowdSubsystem::SpawnCrowd(int32 Count, const FVector& Origin, float Radius)
+{
+	UWorld* World = GetWorld();
+	UMassEntityConfigAsset* Config = CrowdConfig.LoadSynchronous();
+	UMassSpawnerSubsystem* Spawner = World->GetSubsystem<UMassSpawnerSubsystem>();
+	UMassEntitySubsystem* EntitySubsystem = World->GetSubsystem<UMassEntitySubsystem>();
+	if (!Config || !Spawner || !EntitySubsystem || Count <= 0)
+	{
+		UE_LOG(LogUltimateShooter, Warning, TEXT("Crowd spawn skipped, CrowdConfig is not set or Mass is not running"));
+		return 0;
+	}
+
+	const FMassEntityTemplate& Template = Config->GetOrCreateEntityTemplate(*World);
+	if (!Template.IsValid()) return 0;
+
+	// Pool the promoted characters now, so the first promotions don't spawn
+	if (UShooterPawnPoolSubsystem* Pool = UShooterPawnPoolSubsystem::Get(this))
+	{
+		Pool->Prewarm(GetCharacterClass(), MaxPromoted - EntityByActor.Num() - GetNumFreeActors());
+	}
+
+	TArray<FMassEntityHandle> Entities;
+	Spawner->SpawnEntities(Template, Count, Entities);
+
+	// Uniform on the disk around Origin
+	FMassEntityManager& EntityManager = EntitySubsystem->GetMutableEntityManager();
+	FRandomStream Random{ Entities.Num() };
+	for (const FMassEntityHandle& Entity : Entities)
+	{
+		const float Angle{ Random.FRandRange(0.f, UE_TWO_PI) };
+		const float Distance{ Radius * FMath::Sqrt(Random.GetFraction()) };
+		const FVector Location{ Origin + FVector{ FMath::Cos(Angle) * Distance, FMath::Sin(Angle) * Distance, 0.f } };
+		EntityManager.GetFragmentDataChecked<FTransformFragment>(Entity).GetMutableTransform().SetLocation(Location);
+	}
+
+	return Entities.Num();
+}
+
+AShooterCharacter* UShooterCrowdSubsystem::PromoteEntity(FMassEntityHandle Entity, const FTransform& Transform, const FShooterCrowdWeaponFragment& Weapon,
+	const FShooterCrowdTargetFragment& Target, const FShooterCrowdParams& Params)
+{
+	UShooterPawnPoolSubsystem* Pool = UShooterPawnPoolSubsystem::Get(this);
+	AShooterCharacter* Actor = Pool ? Pool->Acquire(GetCharacterClass(), GetControllerClass()) : nullptr;
+	if (!Actor) return nullptr;
+
+	Actor->ResetForReuse();
+	if (AWeapon* CharacterWeapon = Actor->GetEquippedWeapon())
+	{
+		// The entity magazine may be larger than the weapon's, negative before its first weapon update
+		const int32 Capacity{ CharacterWeapon->GetMagazineCapacity() };
+		CharacterWeapon->SetAmmo(Weapon.Ammo < 0 ? Capacity : FMath::Min(Weapon.Ammo, Capacity));
+	}
+	Actor->SetActorLocationAndRotation(Transform.GetLocation(), Transform.GetRotation(), false, nullptr, ETeleportType::ResetPhysics);
+	Actor->SetPooled(false);
+
+	if (AShooterCrowdAIController* CrowdController = Actor->GetController<AShooterCrowdAIController>())
+	{
+		CrowdController->SetControlRotation(Transform.Rotator());
+		CrowdController->StartCombat(Target.Target.Get(), Params.EngageDistance, Params.FireInterval, Weapon.Cooldown);
+	}
+
+	EntityByActor.Add(Actor, Entity);
+	SET_DWORD_STAT(STAT_CrowdPromoted, EntityByActor.Num());
+	return Actor;
+}
+
+void UShooterCrowdSubsystem::DemoteEntity(AShooterCharacter* Actor, FShooterCrowdWeaponFragment& OutWeapon, const FShooterCrowdParams& Params)
+{
+	const AWeapon* CharacterWeapon = Actor->GetEquippedWeapon();
+	OutWeapon.Ammo = FMath::Clamp(CharacterWeapon ? CharacterWeapon->GetAmmo() : 0, 0, Params.MagazineCapacity);
+	OutWeapon.ReloadRemaining = OutWeapon.Ammo == 0 ? Params.ReloadTime : 0.f;
+	if (AShooterCrowdAIController* CrowdController = Actor->GetController<AShooterCrowdAIController>())
+	{
+		OutWeapon.Cooldown = CrowdController->GetFireCooldown();
+		CrowdController->StopCombat();
+	}
+
+	EntityByActor.Remove(Actor);
+	if (UShooterPawnPoolSubsystem* Pool = UShooterPawnPoolSubsystem::Get(this)) { Pool->Release(Actor); }
+	SET_DWORD_STAT(STAT_CrowdPromoted, EntityByActor.Num());
+}
+
+void UShooterCrowdSubsystem::ForgetEntity(FMassEntityHandle Entity)
+{
+	for (auto It = EntityByActor.CreateIterator(); It; ++It)
+	{
+		if (It.Value() == Entity)
+		{
+			It.RemoveCurrent();
+			break;
+		}
+	}
+	SET_DWORD_STAT(STAT_CrowdPromoted, EntityByActor.Num());
+}
+
+TSubclassOf<AShooterCharacter> UShooterCrowdSubsystem::GetCharacterClass() const
+{
+	UClass* Class = CharacterClass.LoadSynchronous();
+	return Class ? Class : AShooterCharacter::StaticClass();
+}
+
+TSubclassOf<AController> UShooterCrowdSubsystem::GetControllerClass() const
+{
+	UClass* Class = ControllerClass.LoadSynchronous();
+	return Class ? Class : AShooterCrowdAIController::StaticClass();
+}
+
+int32 UShooterCrowdSubsystem::GetNumFreeActors() const
+{
+	const UShooterPawnPoolSubsystem* Pool = UShooterPawnPoolSubsystem::Get(this);
+	return Pool ? Pool->GetNumFree(GetCharacterClass()) : 0;
+}
+
+void UShooterCrowdSubsystem::OnKilled(AActor* Victim, AActor* Killer)
+{
+	FMassEntityHandle Entity;
+	if (!EntityByActor.RemoveAndCopyValue(Victim, Entity)) return;
+
+	if (UMassEntitySubsystem* EntitySubsystem = GetWorld()->GetSubsystem<UMassEntitySubsystem>())
+	{
+		EntitySubsystem->GetMutableEntityManager().Defer().DestroyEntity(Entity);
+	}
+	SET_DWORD_STAT(STAT_CrowdPromoted, EntityByActor.Num());
+
+	// Body stays for a while, then the character goes back to the pool
+	TWeakObjectPtr<AShooterCharacter> WeakActor{ Cast<AShooterCharacter>(Victim) };
+	FTimerHandle ReleaseTimer;
+	GetWorld()->GetTimerManager().SetTimer(ReleaseTimer, FTimerDelegate::CreateWeakLambda(this, [this, WeakActor]()
+	{
+		UShooterPawnPoolSubsystem* Pool = UShooterPawnPoolSubsystem::Get(this);
+		if (Pool && WeakActor.IsValid()) { Pool->Release(WeakActor.Get()); }
+	}), DeathLingerTime, false);
+}
+
+void UShooterCrowdSubsystem::BeginRepresentation()
+{
+	InstanceTransforms.Reset();
+	NumGroundTraces = 0;
+}
+
+void UShooterCrowdSubsystem::FollowGround(FTransform& Transform, FShooterCrowdMoveFragment& Move, const FShooterCrowdParams& Params)
+{
+	FVector Location{ Transform.GetLocation() };
+	if (Move.bHasGround && FVector::DistSquared2D(Location, Move.LastGroundCheck) < FMath::Square(GroundCheckDistance)) return;
+	if (NumGroundTraces >= MaxGroundTracesPerFrame) return;
+
+	// A miss keeps the height, tried again one GroundCheckDistance further
+	++NumGroundTraces;
+	Move.LastGroundCheck = Location;
+	Move.bHasGround = true;
+
+	FHitResult Hit;
+	const FVector Start{ Location + FVector{ 0.f, 0.f, CrowdGroundTraceUp } };
+	const FVector End{ Location - FVector{ 0.f, 0.f, CrowdGroundTraceDown } };
+	if (!GetWorld()->LineTraceSingleByObjectType(Hit, Start, End, FCollisionObjectQueryParams{ ECC_WorldStatic })) return;
+
+	Location.Z = Hit.ImpactPoint.Z + Params.HeightAboveGround;
+	Transform.SetLocation(Location);
+}
+
+void UShooterCrowdSubsystem::AddInstance(const FTransform& Transform)
+{
+	InstanceTransforms.Add(Transform);
+}
+
+void UShooterCrowdSubsystem::AddShot(const FVector& Start, const FShooterCrowdTargetFragment& Target, const FShooterCrowdParams& Params)
+{
+	// Batched with the Niagara system. A beam component per simulated shot costs more than the crowd itself,
+	// so without batching there is no tracer unless a CrowdTracer was set
+	UShooterEffectsSubsystem* Effects = UShooterEffectsSubsystem::Get(this);
+	if (Effects && (Effects->IsBatching() || CrowdTracerSystem))
+	{
+		Effects->SpawnTracer(Effects->IsBatching() ? nullptr : CrowdTracerSystem, FTransform{ Start }, Target.TargetLocation);
+	}
+
+	// No trace for simulated shots, the hit is rolled on the distance with the gameplay stream
+	AActor* TargetActor = Target.Target.Get();
+	if (!TargetActor || Params.EngageDistance <= 0.f) return;
+
+	const float HitChance{ Params.HitChance * FMath::Max(1.f - FMath::Sqrt(Target.DistanceSq) / Params.EngageDistance, 0.f) };
+	if (UShooterSimulationSubsystem::GetRandomStream(this).GetFraction() >= HitChance) return;
+
+	if (UShooterDamageSubsystem* Damage = UShooterDamageSubsystem::Get(this)) { Damage->QueueDamage(TargetActor, nullptr, Params.ShotDamage); }
+}
+
+void UShooterCrowdSubsystem::EndRepresentation()
+{
+	SET_DWORD_STAT(STAT_CrowdInstances, InstanceTransforms.Num());
+	if (!CrowdInstances) return;
+
+	SCOPE_CYCLE_COUNTER(STAT_CrowdInstancesUpdate);
+
+	// Instances past the simulated combatants are hidden, the component only grows
+	const int32 NumSimulated{ InstanceTransforms.Num() };
+	const int32 NumTransforms{ FMath::Max(NumSimulated, NumVisibleInstances) };
+	if (NumTransforms == 0) return;
+
+	InstanceTransforms.SetNum(NumTransforms);
+	for (int32 Index = NumSimulated; Index < NumTransforms; ++Index)
+	{
+		InstanceTransforms[Index] = FTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector);
+	}
+
+	const int32 NumInstances{ CrowdInstances->GetInstanceCount() };
+	if (NumInstances < NumTransforms)
+	{
+		TArray<FTransform> NewInstances;
+		NewInstances.Init(FTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector), NumTransforms - NumInstances);
+		CrowdInstances->AddInstances(NewInstances, false, true);
+	}
+
+	CrowdInstances->BatchUpdateInstancesTransforms(0, InstanceTransforms, true, true, true);
+	NumVisibleInstances = NumSimulated;
+}
@@ -0,0 +1,107 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MassEntityTypes.h"
+#include "ShooterCrowdFragments.h"
+#include "ShooterCrowdSubsystem.generated.h"
+
+class AShooterCharacter;
+class AController;
+
+/**
+ * Crowd of lightweight combatants simulated as Mass entities (see UShooterCrowdTrait and the crowd processors).
+ * Distant combatants are instances of one instanced static mesh, a VAT material on CrowdMesh animates them.
+ * Combatants close to a player are promoted to a character from the pawn pool and demoted back once far enough.
+ */
+UCLASS(Config = Game)
+class ULTIMATESHOOTER_API UShooterCrowdSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	static UShooterCrowdSubsystem* Get(const UObject* WorldContextObject);
+
+	// Spawns Count combatants from CrowdConfig on a disk around Origin, returns the number spawned
+	int32 SpawnCrowd(int32 Count, const FVector& Origin, float Radius);
+
+	float GetPromoteDistance() const { return PromoteDistance; }
+	float GetDemoteDistance() const { return DemoteDistance; }
+	bool CanPromote() const { return EntityByActor.Num() < MaxPromoted; }
+	int32 GetNumPromoted() const { return EntityByActor.Num(); }
+	int32 GetNumFreeActors() const;
+
+	// Full character for the entity, null if none could be spawned. Its AI controller takes over the target and fire cadence.
+	AShooterCharacter* PromoteEntity(FMassEntityHandle Entity, const FTransform& Transform, const FShooterCrowdWeaponFragment& Weapon,
+		const FShooterCrowdTargetFragment& Target, const FShooterCrowdParams& Params);
+	// Parks the character back in the pool, its magazine ammo and fire cadence go back to the entity
+	void DemoteEntity(AShooterCharacter* Actor, FShooterCrowdWeaponFragment& OutWeapon, const FShooterCrowdParams& Params);
+	// Drops the entity of a character destroyed without a death, kill Z or streaming out
+	void ForgetEntity(FMassEntityHandle Entity);
+
+	// Filled by the representation processor each frame
+	void BeginRepresentation();
+	// Puts the combatant back on the ground once it walked GroundCheckDistance, at most MaxGroundTracesPerFrame traces a frame
+	void FollowGround(FTransform& Transform, FShooterCrowdMoveFragment& Move, const FShooterCrowdParams& Params);
+	void AddInstance(const FTransform& Transform);
+	// Tracer and hit roll of a simulated shot at the target
+	void AddShot(const FVector& Start, const FShooterCrowdTargetFragment& Target, const FShooterCrowdParams& Params);
+	void EndRepresentation();
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	void OnKilled(AActor* Victim, AActor* Killer);
+
+	TSubclassOf<AShooterCharacter> GetCharacterClass() const;
+	TSubclassOf<AController> GetControllerClass() const;
+
+private:
+	TMap<const AActor*, FMassEntityHandle> EntityByActor;
+
+	UPROPERTY(Transient)
+	class UInstancedStaticMeshComponent* CrowdInstances;
+	TArray<FTransform> InstanceTransforms;
+	// Instances showing a combatant last frame, the others are scaled to zero
+	int32 NumVisibleInstances{ 0 };
+	int32 NumGroundTraces{ 0 };
+
+	UPROPERTY(Transient)
+	class UParticleSystem* CrowdTracerSystem;
+
+	FDelegateHandle KilledHandle;
+
+	// Entity config holding UShooterCrowdTrait
+	UPROPERTY(Config)
+	TSoftObjectPtr<class UMassEntityConfigAsset> CrowdConfig;
+	UPROPERTY(Config)
+	TSoftObjectPtr<class UStaticMesh> CrowdMesh;
+	UPROPERTY(Config)
+	TSoftClassPtr<AShooterCharacter> CharacterClass;
+	// Brain of the promoted characters
+	UPROPERTY(Config)
+	TSoftClassPtr<class AShooterCrowdAIController> ControllerClass;
+	// Cascade beam of the simulated shots while the batched Niagara effects are off, unset draws none
+	UPROPERTY(Config)
+	TSoftObjectPtr<class UParticleSystem> CrowdTracer;
+	UPROPERTY(Config)
+	float PromoteDistance{ 2500.f };
+	// Larger than PromoteDistance so combatants at the edge don't flip every frame
+	UPROPERTY(Config)
+	float DemoteDistance{ 3500.f };
+	UPROPERTY(Config)
+	int32 MaxPromoted{ 32 };
+	// Time a dead promoted combatant stays in the level before going back to the pool
+	UPROPERTY(Config)
+	float DeathLingerTime{ 3.f };
+	UPROPERTY(Config)
+	float GroundCheckDistance{ 200.f };
+	UPROPERTY(Config)
+	int32 MaxGroundTracesPerFrame{ 64 };
+};
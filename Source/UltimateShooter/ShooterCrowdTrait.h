@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityTraitBase.h"
+#include "ShooterCrowdFragments.h"
+#include "ShooterCrowdTrait.generated.h"
+
+/**
+ * Lightweight crowd combatant: transform, wander movement, fire cadence and ammo.
+ * Add it to a Mass entity config used by UShooterCrowdSubsystem or a level Mass spawner.
+ */
+UCLASS(meta = (DisplayName = "Shooter Crowd Combatant"))
+class ULTIMATESHOOTER_API UShooterCrowdTrait : public UMassEntityTraitBase
+{
+	GENERATED_BODY()
+
+protected:
+	virtual void BuildTemplate(FMassEntityTemplateBuildContext& BuildContext, const UWorld& World) const override;
+
+	UPROPERTY(EditAnywhere, Category = Crowd)
+	FShooterCrowdParams Params;
+};
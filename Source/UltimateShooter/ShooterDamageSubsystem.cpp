@@ -0,0 +1,168 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterDamageSubsystem.h"
+#include "Engine/World.h"
+#include "ShooterHealthComponent.h"
+#include "ShooterHitboxSubsystem.h"
+
+#include "UltimateShooter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Damage Apply"), STAT_DamageApply, STATGROUP_UltimateShooter);
+DECLARE_CYCLE_STAT(TEXT("Damage Broadcast"), STAT_DamageBroadcast, STATGROUP_UltimateShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damage Events"), STAT_DamageEvents, STATGROUP_UltimateShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damage Deaths"), STAT_DamageDeaths, STATGROUP_UltimateShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damage Records"), STAT_DamageRecords, STATGROUP_UltimateShooter);
+
+bool UShooterDamageSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+UShooterDamageSubsystem* UShooterDamageSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UShooterDamageSubsystem>() : nullptr;
+}
+
+TStatId UShooterDamageSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterDamageSubsystem, STATGROUP_Tickables);
+}
+
+void UShooterDamageSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	if (UShooterHitboxSubsystem* Hitboxes = Collection.InitializeDependency<UShooterHitboxSubsystem>())
+	{
+		ShotsResolvedHandle = Hitboxes->OnShotsResolved().AddUObject(this, &UShooterDamageSubsystem::OnShotsResolved);
+	}
+}
+
+void UShooterDamageSubsystem::Deinitialize()
+{
+	if (UShooterHitboxSubsystem* Hitboxes = UShooterHitboxSubsystem::Get(this)) { Hitboxes->OnShotsResolved().Remove(ShotsResolvedHandle); }
+
+	Health.Empty();
+	Components.Empty();
+	RecordByActor.Empty();
+	DamageQueue.Empty();
+
+	Super::Deinitialize();
+}
+
+void UShooterDamageSubsystem::RegisterHealth(UShooterHealthComponent* HealthComponent)
+{
+	if (HealthComponent->RecordIndex != INDEX_NONE) return;
+
+	HealthComponent->RecordIndex = Health.Add(HealthComponent->GetMaxHealth());
+	Components.Add(HealthComponent);
+	RecordByActor.Add(HealthComponent->GetOwner(), HealthComponent->RecordIndex);
+}
+
+void UShooterDamageSubsystem::UnregisterHealth(UShooterHealthComponent* HealthComponent)
+{
+	const int32 Index{ HealthComponent->RecordIndex };
+	if (!Components.IsValidIndex(Index) || Components[Index] != HealthComponent) return;
+
+	// The last record takes the free slot
+	Health.RemoveAtSwap(Index, 1, false);
+	Components.RemoveAtSwap(Index, 1, false);
+	RecordByActor.Remove(HealthComponent->GetOwner());
+	HealthComponent->RecordIndex = INDEX_NONE;
+
+	if (Components.IsValidIndex(Index))
+	{
+		Components[Index]->RecordIndex = Index;
+		RecordByActor.Add(Components[Index]->GetOwner(), Index);
+	}
+}
+
+void UShooterDamageSubsystem::SetHealth(int32 RecordIndex, float NewHealth)
+{
+	if (Health.IsValidIndex(RecordIndex)) { Health[RecordIndex] = NewHealth; }
+}
+
+void UShooterDamageSubsystem::QueueDamage(AActor* Victim, AActor* Instigator, float Damage, FName Bone)
+{
+	if (!Victim || Damage <= 0.f) return;
+
+	FShooterDamageEvent& Event = DamageQueue.AddDefaulted_GetRef();
+	Event.Victim = Victim;
+	Event.Instigator = Instigator;
+	Event.Damage = Damage;
+	Event.Bone = Bone;
+}
+
+void UShooterDamageSubsystem::OnShotsResolved(const TArray<FShooterShotResult>& Results)
+{
+	for (const FShooterShotResult& Result : Results)
+	{
+		if (!Result.bHit) continue;
+
+		const float Multiplier{ Result.Hit.Bone == HeadBoneName ? HeadshotMultiplier : 1.f };
+		QueueDamage(Result.Hit.Actor, Result.Instigator, Result.Damage * Multiplier, Result.Hit.Bone);
+	}
+}
+
+void UShooterDamageSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	SET_DWORD_STAT(STAT_DamageRecords, Health.Num());
+
+	ApplyDamage();
+}
+
+void UShooterDamageSubsystem::ApplyDamage()
+{
+	if (DamageQueue.Num() == 0) return;
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_DamageApply);
+		INC_DWORD_STAT_BY(STAT_DamageEvents, DamageQueue.Num());
+
+		AppliedEvents.Reset();
+		AppliedComponents.Reset();
+		KillingEvents.Reset();
+
+		for (FShooterDamageEvent& Event : DamageQueue)
+		{
+			// Victims destroyed since the hit are dropped, an instigator destroyed since is reported as none
+			if (!IsValid(Event.Victim)) continue;
+			if (!IsValid(Event.Instigator)) { Event.Instigator = nullptr; }
+
+			// Hits on actors without health or already dead this frame are dropped
+			const int32* Record = RecordByActor.Find(Event.Victim);
+			if (!Record || Health[*Record] <= 0.f) continue;
+
+			float& RecordHealth = Health[*Record];
+			RecordHealth = FMath::Max(RecordHealth - Event.Damage, 0.f);
+
+			AppliedEvents.Add(Event);
+			AppliedComponents.Add(Components[*Record]);
+			if (RecordHealth <= 0.f) { KillingEvents.Add(AppliedEvents.Num() - 1); }
+		}
+
+		// Damage queued by the listeners below goes to the next batch
+		DamageQueue.Reset();
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_DamageBroadcast);
+	INC_DWORD_STAT_BY(STAT_DamageDeaths, KillingEvents.Num());
+
+	for (int32 Index = 0; Index < AppliedEvents.Num(); ++Index)
+	{
+		const FShooterDamageEvent& Event = AppliedEvents[Index];
+		DamagedEvent.Broadcast(Event);
+		if (UShooterHealthComponent* HealthComponent = AppliedComponents[Index].Get()) { HealthComponent->OnHitReact.Broadcast(Event.Instigator, Event.Damage, Event.Bone); }
+	}
+
+	for (const int32 Index : KillingEvents)
+	{
+		const FShooterDamageEvent& Event = AppliedEvents[Index];
+		if (UShooterHealthComponent* HealthComponent = AppliedComponents[Index].Get()) { HealthComponent->OnDeath.Broadcast(Event.Instigator); }
+		KilledEvent.Broadcast(Event.Victim, Event.Instigator);
+	}
+}
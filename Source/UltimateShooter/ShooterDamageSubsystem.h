@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterDamageSubsystem.generated.h"
+
+USTRUCT(BlueprintType)
+struct FShooterDamageEvent
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	AActor* Victim{ nullptr };
+
+	UPROPERTY(BlueprintReadOnly)
+	AActor* Instigator{ nullptr };
+
+	UPROPERTY(BlueprintReadOnly)
+	float Damage{ 0.f };
+
+	UPROPERTY(BlueprintReadOnly)
+	FName Bone;
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnShooterDamaged, const FShooterDamageEvent& /*Event*/);
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnShooterKilled, AActor* /*Victim*/, AActor* /*Killer*/);
+
+/**
+ * Health of every damageable actor in one dense array, one record per UShooterHealthComponent.
+ * Hits of the frame are queued and applied in a single pass, then hit react, death and kill events are broadcast.
+ */
+UCLASS(Config = Game)
+class ULTIMATESHOOTER_API UShooterDamageSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	static UShooterDamageSubsystem* Get(const UObject* WorldContextObject);
+
+	void RegisterHealth(class UShooterHealthComponent* HealthComponent);
+	void UnregisterHealth(class UShooterHealthComponent* HealthComponent);
+
+	float GetHealth(int32 RecordIndex) const { return Health.IsValidIndex(RecordIndex) ? Health[RecordIndex] : 0.f; }
+	void SetHealth(int32 RecordIndex, float NewHealth);
+
+	// Applied with the rest of the frame damage
+	void QueueDamage(AActor* Victim, AActor* Instigator, float Damage, FName Bone = NAME_None);
+
+	// Every damage event that hit a living actor
+	FOnShooterDamaged& OnDamaged() { return DamagedEvent; }
+	// Health of the victim reached zero
+	FOnShooterKilled& OnKilled() { return KilledEvent; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	// Turns the hitbox hits of the frame into damage
+	void OnShotsResolved(const TArray<struct FShooterShotResult>& Results);
+
+	void ApplyDamage();
+
+private:
+	// Dense health records
+	TArray<float> Health;
+	UPROPERTY(Transient)
+	TArray<class UShooterHealthComponent*> Components;
+	TMap<const AActor*, int32> RecordByActor;
+
+	// Reflected so actors destroyed between the hit and the batch are never left dangling
+	UPROPERTY(Transient)
+	TArray<FShooterDamageEvent> DamageQueue;
+	// Events of the last batch, broadcast once every record is updated
+	UPROPERTY(Transient)
+	TArray<FShooterDamageEvent> AppliedEvents;
+	TArray<TWeakObjectPtr<class UShooterHealthComponent>> AppliedComponents;
+	// Indices in AppliedEvents of the hits that killed their victim
+	TArray<int32> KillingEvents;
+
+	FDelegateHandle ShotsResolvedHandle;
+
+	FOnShooterDamaged DamagedEvent;
+	FOnShooterKilled KilledEvent;
+
+	UPROPERTY(Config)
+	FName HeadBoneName{ TEXT("head") };
+	UPROPERTY(Config)
+	float HeadshotMultiplier{ 2.f };
+};
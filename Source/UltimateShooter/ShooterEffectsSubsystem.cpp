@@ -0,0 +1,155 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterEffectsSubsystem.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "NiagaraComponent.h"
+#include "NiagaraFunctionLibrary.h"
+#include "NiagaraDataInterfaceArrayFunctionLibrary.h"
+
+#include "ShooterSimulationSubsystem.h"
+#include "ShooterFrameGovernorSubsystem.h"
+#include "UltimateShooter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Shot Effects Cascade"), STAT_ShotEffectsCascade, STATGROUP_UltimateShooter);
+DECLARE_CYCLE_STAT(TEXT("Shot Effects Batched"), STAT_ShotEffectsBatched, STATGROUP_UltimateShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Shot Effects Batched Tracers"), STAT_ShotEffectsBatchedTracers, STATGROUP_UltimateShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Shot Effects Batched Impacts"), STAT_ShotEffectsBatchedImpacts, STATGROUP_UltimateShooter);
+
+static TAutoConsoleVariable<bool> CVarBatchedShotEffects(
+	TEXT("Shooter.Effects.Batched"),
+	true,
+	TEXT("Send tracers and impacts to the batched Niagara system (true) or spawn one Cascade emitter each (false)"));
+
+namespace ShotEffectsParams
+{
+	static const FName TracerStarts(TEXT("TracerStarts"));
+	static const FName TracerEnds(TEXT("TracerEnds"));
+	static const FName ImpactLocations(TEXT("ImpactLocations"));
+	static const FName ImpactNormals(TEXT("ImpactNormals"));
+}
+
+bool UShooterEffectsSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+UShooterEffectsSubsystem* UShooterEffectsSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UShooterEffectsSubsystem>() : nullptr;
+}
+
+TStatId UShooterEffectsSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterEffectsSubsystem, STATGROUP_Tickables);
+}
+
+void UShooterEffectsSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	UNiagaraSystem* System = BatchedEffectsSystem.LoadSynchronous();
+	if (!System) return;
+
+	// One component for the whole world, it lives as long as the world
+	BatchedEffectsComponent = UNiagaraFunctionLibrary::SpawnSystemAtLocation(&InWorld, System, FVector::ZeroVector, FRotator::ZeroRotator,
+		FVector(1.f), false, true, ENCPoolMethod::None, false);
+}
+
+void UShooterEffectsSubsystem::Deinitialize()
+{
+	if (BatchedEffectsComponent) { BatchedEffectsComponent->DestroyComponent(); }
+	BatchedEffectsComponent = nullptr;
+
+	Super::Deinitialize();
+}
+
+bool UShooterEffectsSubsystem::IsBatching() const
+{
+	return BatchedEffectsComponent && CVarBatchedShotEffects.GetValueOnGameThread();
+}
+
+void UShooterEffectsSubsystem::SpawnTracer(UParticleSystem* CascadeBeam, const FTransform& MuzzleTransform, const FVector& End)
+{
+	if (UShooterSimulationSubsystem::IsFastForwarding(this)) return;
+	// Distant shots lose their effects first when the frame runs long
+	const UShooterFrameGovernorSubsystem* Governor = UShooterFrameGovernorSubsystem::Get(this);
+	if (Governor && !Governor->ShouldSpawnShotEffect(MuzzleTransform.GetLocation(), End)) return;
+
+	if (IsBatching())
+	{
+		SCOPE_CYCLE_COUNTER(STAT_ShotEffectsBatched);
+		TracerStarts.Add(MuzzleTransform.GetLocation());
+		TracerEnds.Add(End);
+		CSV_CUSTOM_STAT(ShooterGameplay, EffectsBatched, 1, ECsvCustomStatOp::Accumulate);
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_ShotEffectsCascade);
+	// Pooled components go back to the world's pool when they finish instead of being destroyed and collected
+	UParticleSystemComponent* Beam = UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), CascadeBeam, MuzzleTransform, true, EPSCPoolMethod::AutoRelease);
+	if (Beam)
+	{
+		Beam->SetVectorParameter(FName("Target"), End);
+		CSV_CUSTOM_STAT(ShooterGameplay, EmittersSpawned, 1, ECsvCustomStatOp::Accumulate);
+	}
+}
+
+void UShooterEffectsSubsystem::SpawnImpact(UParticleSystem* CascadeImpact, const FVector& Location, const FVector& Normal)
+{
+	if (UShooterSimulationSubsystem::IsFastForwarding(this)) return;
+	const UShooterFrameGovernorSubsystem* Governor = UShooterFrameGovernorSubsystem::Get(this);
+	if (Governor && !Governor->ShouldSpawnShotEffect(Location, Location)) return;
+
+	if (IsBatching())
+	{
+		SCOPE_CYCLE_COUNTER(STAT_ShotEffectsBatched);
+		ImpactLocations.Add(Location);
+		ImpactNormals.Add(Normal);
+		CSV_CUSTOM_STAT(ShooterGameplay, EffectsBatched, 1, ECsvCustomStatOp::Accumulate);
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_ShotEffectsCascade);
+	if (CascadeImpact && UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), CascadeImpact, FTransform(Location), true, EPSCPoolMethod::AutoRelease))
+	{
+		CSV_CUSTOM_STAT(ShooterGameplay, EmittersSpawned, 1, ECsvCustomStatOp::Accumulate);
+	}
+}
+
+void UShooterEffectsSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	FlushBatch();
+}
+
+void UShooterEffectsSubsystem::FlushBatch()
+{
+	if (!BatchedEffectsComponent) return;
+
+	const bool bHasEffects{ TracerStarts.Num() > 0 || ImpactLocations.Num() > 0 };
+	// Nothing new and the component arrays are already empty
+	if (!bHasEffects && !bBatchDirty) return;
+
+	SCOPE_CYCLE_COUNTER(STAT_ShotEffectsBatched);
+	INC_DWORD_STAT_BY(STAT_ShotEffectsBatchedTracers, TracerStarts.Num());
+	INC_DWORD_STAT_BY(STAT_ShotEffectsBatchedImpacts, ImpactLocations.Num());
+
+	// The system spawns one particle per array element the frame it receives them
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayVector(BatchedEffectsComponent, ShotEffectsParams::TracerStarts, TracerStarts);
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayVector(BatchedEffectsComponent, ShotEffectsParams::TracerEnds, TracerEnds);
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayVector(BatchedEffectsComponent, ShotEffectsParams::ImpactLocations, ImpactLocations);
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayVector(BatchedEffectsComponent, ShotEffectsParams::ImpactNormals, ImpactNormals);
+
+	TracerStarts.Reset();
+	TracerEnds.Reset();
+	ImpactLocations.Reset();
+	ImpactNormals.Reset();
+
+	bBatchDirty = bHasEffects;
+}
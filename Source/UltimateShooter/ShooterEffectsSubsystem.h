@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterEffectsSubsystem.generated.h"
+
+/**
+ * Spawns shot tracers and impacts. When a batched Niagara system is set, every tracer and impact of the frame
+ * is sent to one persistent Niagara component through array parameters instead of spawning a Cascade emitter each.
+ */
+UCLASS(Config = Game)
+class ULTIMATESHOOTER_API UShooterEffectsSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	static UShooterEffectsSubsystem* Get(const UObject* WorldContextObject);
+
+	// Smoke trail from the muzzle to End, CascadeBeam is used when batching is off
+	void SpawnTracer(class UParticleSystem* CascadeBeam, const FTransform& MuzzleTransform, const FVector& End);
+	// Bullet impact, CascadeImpact is used when batching is off
+	void SpawnImpact(class UParticleSystem* CascadeImpact, const FVector& Location, const FVector& Normal);
+
+	// True when tracers and impacts go to the batched Niagara system
+	bool IsBatching() const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	// Sends this frame's tracers and impacts to the Niagara component
+	void FlushBatch();
+
+private:
+	// Niagara system (CPU sim) reading the TracerStarts, TracerEnds, ImpactLocations and ImpactNormals user arrays
+	UPROPERTY(Config)
+	TSoftObjectPtr<class UNiagaraSystem> BatchedEffectsSystem;
+
+	UPROPERTY(Transient)
+	class UNiagaraComponent* BatchedEffectsComponent;
+
+	TArray<FVector> TracerStarts;
+	TArray<FVector> TracerEnds;
+	TArray<FVector> ImpactLocations;
+	TArray<FVector> ImpactNormals;
+
+	// Arrays were sent last frame and have to be cleared on the component
+	bool bBatchDirty{ false };
+};
@@ -0,0 +1,233 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterFrameGovernorSubsystem.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerController.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "RenderCore.h"
+#include "ShooterCharacter.h"
+#include "ShooterSimulationSubsystem.h"
+#include "ShooterInputReplaySubsystem.h"
+
+#include "UltimateShooter.h"
+
+static TAutoConsoleVariable<bool> CVarFrameGovernor(
+	TEXT("Shooter.Governor"),
+	true,
+	TEXT("Shed cosmetic gameplay work when the game thread runs over budget (true) or always run at Full (false)"));
+
+static TAutoConsoleVariable<int32> CVarFrameGovernorForceTier(
+	TEXT("Shooter.Governor.ForceTier"),
+	-1,
+	TEXT("Forces a quality tier: 0 Full, 1 Reduced, 2 Minimal, -1 lets the governor pick"));
+
+static const TCHAR* GetTierName(EShooterQualityTier Tier)
+{
+	switch (Tier)
+	{
+	case EShooterQualityTier::EQT_Full: return TEXT("Full");
+	case EShooterQualityTier::EQT_Reduced: return TEXT("Reduced");
+	default: return TEXT("Minimal");
+	}
+}
+
+bool UShooterFrameGovernorSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+UShooterFrameGovernorSubsystem* UShooterFrameGovernorSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UShooterFrameGovernorSubsystem>() : nullptr;
+}
+
+EShooterQualityTier UShooterFrameGovernorSubsystem::GetTier(const UObject* WorldContextObject)
+{
+	const UShooterFrameGovernorSubsystem* Governor = Get(WorldContextObject);
+	return Governor ? Governor->GetTier() : EShooterQualityTier::EQT_Full;
+}
+
+bool UShooterFrameGovernorSubsystem::IsHeldAtFull() const
+{
+	if (UShooterSimulationSubsystem::IsFastForwarding(this)) return true;
+
+	const UShooterInputReplaySubsystem* Replay = UShooterInputReplaySubsystem::Get(this);
+	return Replay && (Replay->IsRecording() || Replay->IsReplaying());
+}
+
+TStatId UShooterFrameGovernorSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterFrameGovernorSubsystem, STATGROUP_Tickables);
+}
+
+float UShooterFrameGovernorSubsystem::GetGameThreadMs()
+{
+	if (GGameThreadTime > 0) return static_cast<float>(FPlatformTime::ToMilliseconds(GGameThreadTime));
+	return static_cast<float>(FMath::Max(FApp::GetDeltaTime() - FApp::GetIdleTime(), 0.0) * 1000.0);
+}
+
+void UShooterFrameGovernorSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	UpdateTier(DeltaTime);
+	UpdateViewLocations();
+
+	TimeToApplyAnimInterval -= DeltaTime;
+	if (TimeToApplyAnimInterval <= 0.f)
+	{
+		TimeToApplyAnimInterval = AnimIntervalRefresh;
+		ApplyRemoteAnimInterval();
+	}
+}
+
+void UShooterFrameGovernorSubsystem::UpdateTier(float DeltaTime)
+{
+	const float FrameMs{ GetGameThreadMs() };
+	if (GameThreadMs.Num() < WindowFrames) { GameThreadMs.Add(FrameMs); }
+	else
+	{
+		GameThreadMs[NextGameThreadMs] = FrameMs;
+		NextGameThreadMs = (NextGameThreadMs + 1) % WindowFrames;
+	}
+	float TotalMs{ 0.f };
+	for (const float Ms : GameThreadMs) { TotalMs += Ms; }
+	AverageGameThreadMs = TotalMs / GameThreadMs.Num();
+
+	const int32 ForcedTier{ CVarFrameGovernorForceTier.GetValueOnGameThread() };
+	if (ForcedTier >= 0 && !IsHeldAtFull())
+	{
+		SetTier(static_cast<EShooterQualityTier>(FMath::Min(ForcedTier, static_cast<int32>(EShooterQualityTier::EQT_MAX) - 1)));
+		return;
+	}
+	if (!CVarFrameGovernor.GetValueOnGameThread() || IsHeldAtFull())
+	{
+		SetTier(EShooterQualityTier::EQT_Full);
+		return;
+	}
+
+	// Between the two lines both timers reset, a tier only moves on a sustained trend
+	if (AverageGameThreadMs > GameThreadBudgetMs)
+	{
+		OverBudgetTime += DeltaTime;
+		UnderBudgetTime = 0.f;
+	}
+	else if (AverageGameThreadMs < GameThreadBudgetMs * RecoverRatio)
+	{
+		UnderBudgetTime += DeltaTime;
+		OverBudgetTime = 0.f;
+	}
+	else
+	{
+		OverBudgetTime = 0.f;
+		UnderBudgetTime = 0.f;
+	}
+
+	const int32 TierIndex{ static_cast<int32>(Tier) };
+	if (OverBudgetTime >= DegradeSeconds && TierIndex < static_cast<int32>(EShooterQualityTier::EQT_MAX) - 1)
+	{
+		SetTier(static_cast<EShooterQualityTier>(TierIndex + 1));
+	}
+	else if (UnderBudgetTime >= RecoverSeconds && TierIndex > 0)
+	{
+		SetTier(static_cast<EShooterQualityTier>(TierIndex - 1));
+	}
+}
+
+void UShooterFrameGovernorSubsystem::SetTier(EShooterQualityTier NewTier)
+{
+	if (NewTier == Tier) return;
+
+	UE_LOG(LogUltimateShooter, Log, TEXT("Frame governor: %s -> %s, game thread %.2f ms avg over %d frames, budget %.2f ms"),
+		GetTierName(Tier), GetTierName(NewTier), AverageGameThreadMs, GameThreadMs.Num(), GameThreadBudgetMs);
+
+	Tier = NewTier;
+	OverBudgetTime = 0.f;
+	UnderBudgetTime = 0.f;
+
+	ApplyRemoteAnimInterval();
+	TimeToApplyAnimInterval = AnimIntervalRefresh;
+}
+
+void UShooterFrameGovernorSubsystem::UpdateViewLocations()
+{
+	ViewLocations.Reset();
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (!PlayerController || !PlayerController->IsLocalController()) continue;
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+		ViewLocations.Add(ViewLocation);
+	}
+}
+
+bool UShooterFrameGovernorSubsystem::ShouldSpawnShotEffect(const FVector& Start, const FVector& End) const
+{
+	const EShooterQualityTier CurrentTier{ GetTier() };
+	if (CurrentTier == EShooterQualityTier::EQT_Full) return true;
+
+	const float MaxDistance{ CurrentTier == EShooterQualityTier::EQT_Reduced ? ReducedEffectsDistance : MinimalEffectsDistance };
+	for (const FVector& ViewLocation : ViewLocations)
+	{
+		if (FMath::PointDistToSegmentSquared(ViewLocation, Start, End) <= FMath::Square(MaxDistance)) return true;
+	}
+	return false;
+}
+
+int32 UShooterFrameGovernorSubsystem::GetItemTraceInterval(const UObject* WorldContextObject)
+{
+	const UShooterFrameGovernorSubsystem* Governor = Get(WorldContextObject);
+	const EShooterQualityTier CurrentTier{ Governor ? Governor->GetTier() : EShooterQualityTier::EQT_Full };
+	if (CurrentTier == EShooterQualityTier::EQT_Full) return 1;
+	return FMath::Max(CurrentTier == EShooterQualityTier::EQT_Reduced ? Governor->ReducedItemTraceInterval : Governor->MinimalItemTraceInterval, 1);
+}
+
+int32 UShooterFrameGovernorSubsystem::GetPickupInterpInterval(const UObject* WorldContextObject)
+{
+	const UShooterFrameGovernorSubsystem* Governor = Get(WorldContextObject);
+	const EShooterQualityTier CurrentTier{ Governor ? Governor->GetTier() : EShooterQualityTier::EQT_Full };
+	if (CurrentTier == EShooterQualityTier::EQT_Full) return 1;
+	return FMath::Max(CurrentTier == EShooterQualityTier::EQT_Reduced ? Governor->ReducedPickupInterpInterval : Governor->MinimalPickupInterpInterval, 1);
+}
+
+void UShooterFrameGovernorSubsystem::ApplyRemoteAnimInterval()
+{
+	const EShooterQualityTier CurrentTier{ bThrottleRemoteAnims ? GetTier() : EShooterQualityTier::EQT_Full };
+	float RemoteInterval{ 0.f };
+	if (CurrentTier == EShooterQualityTier::EQT_Reduced) { RemoteInterval = ReducedRemoteAnimInterval; }
+	else if (CurrentTier == EShooterQualityTier::EQT_Minimal) { RemoteInterval = MinimalRemoteAnimInterval; }
+
+	// Back to every frame, tick intervals set anywhere else are left alone
+	if (RemoteInterval <= 0.f)
+	{
+		for (const TWeakObjectPtr<USkeletalMeshComponent>& Mesh : ThrottledMeshes)
+		{
+			if (Mesh.IsValid()) { Mesh->SetComponentTickInterval(0.f); }
+		}
+		ThrottledMeshes.Empty();
+		return;
+	}
+
+	for (TActorIterator<AShooterCharacter> It(GetWorld()); It; ++It)
+	{
+		USkeletalMeshComponent* Mesh = It->GetMesh();
+		if (!Mesh) continue;
+
+		// The local player's own anims stay at full rate
+		if (It->IsLocallyControlled() && It->IsPlayerControlled())
+		{
+			if (ThrottledMeshes.Remove(Mesh) > 0) { Mesh->SetComponentTickInterval(0.f); }
+			continue;
+		}
+		ThrottledMeshes.Add(Mesh);
+		if (Mesh->GetComponentTickInterval() != RemoteInterval) { Mesh->SetComponentTickInterval(RemoteInterval); }
+	}
+}
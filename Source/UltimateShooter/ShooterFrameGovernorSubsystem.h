@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterFrameGovernorSubsystem.generated.h"
+
+UENUM(BlueprintType)
+enum class EShooterQualityTier : uint8
+{
+	EQT_Full UMETA(DisplayName = "Full"),
+	EQT_Reduced UMETA(DisplayName = "Reduced"),
+	EQT_Minimal UMETA(DisplayName = "Minimal"),
+
+	EQT_MAX UMETA(DisplayName = "DefaultMAX")
+};
+
+/**
+ * Watches the rolling game thread time against GameThreadBudgetMs and moves the cosmetic quality tier one step at a time:
+ * down after DegradeSeconds over budget, back up after RecoverSeconds under RecoverRatio of it.
+ * Lower tiers skip shot effects far from the local views, trace for items and update pickup interps less often.
+ * With bThrottleRemoteAnims they also tick the anims of remote characters at a lower rate, which leaves their hitboxes
+ * a few frames behind and delays their anim notifies, reloads included.
+ * Held at Full while fast forwarding, recording or replaying, so those runs don't depend on the machine load.
+ */
+UCLASS(Config = Game)
+class ULTIMATESHOOTER_API UShooterFrameGovernorSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	static UShooterFrameGovernorSubsystem* Get(const UObject* WorldContextObject);
+
+	// Full outside game worlds
+	static EShooterQualityTier GetTier(const UObject* WorldContextObject);
+	EShooterQualityTier GetTier() const { return IsHeldAtFull() ? EShooterQualityTier::EQT_Full : Tier; }
+
+	// Shot tracers and impacts, false when every local view is too far for the tier
+	bool ShouldSpawnShotEffect(const FVector& Start, const FVector& End) const;
+	// Frames between item traces of the player character
+	static int32 GetItemTraceInterval(const UObject* WorldContextObject);
+	// Frames between pickup interp updates
+	static int32 GetPickupInterpInterval(const UObject* WorldContextObject);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	// Game thread time of the last frame, the frame minus idle time where the engine doesn't measure it
+	static float GetGameThreadMs();
+
+	// Fast forward and input recordings or replays must not depend on how loaded the machine is
+	bool IsHeldAtFull() const;
+
+	void UpdateTier(float DeltaTime);
+	void SetTier(EShooterQualityTier NewTier);
+	void UpdateViewLocations();
+	// Anim tick interval of every character the local players don't control, puts back the meshes it throttled
+	void ApplyRemoteAnimInterval();
+
+private:
+	EShooterQualityTier Tier{ EShooterQualityTier::EQT_Full };
+
+	// Ring of the last WindowFrames game thread times
+	TArray<float> GameThreadMs;
+	int32 NextGameThreadMs{ 0 };
+	float AverageGameThreadMs{ 0.f };
+
+	// Seconds the average has been over budget, or under the recover line
+	float OverBudgetTime{ 0.f };
+	float UnderBudgetTime{ 0.f };
+
+	float TimeToApplyAnimInterval{ 0.f };
+	// Meshes this governor set a tick interval on, the only ones it resets
+	TSet<TWeakObjectPtr<class USkeletalMeshComponent>> ThrottledMeshes;
+
+	TArray<FVector, TInlineAllocator<4>> ViewLocations;
+
+	UPROPERTY(Config)
+	float GameThreadBudgetMs{ 16.6f };
+	UPROPERTY(Config)
+	int32 WindowFrames{ 30 };
+	// Fraction of the budget the average has to stay under to recover a tier
+	UPROPERTY(Config)
+	float RecoverRatio{ 0.8f };
+	UPROPERTY(Config)
+	float DegradeSeconds{ 0.5f };
+	UPROPERTY(Config)
+	float RecoverSeconds{ 3.f };
+
+	// Shot effects further than this from every local view are skipped
+	UPROPERTY(Config)
+	float ReducedEffectsDistance{ 4000.f };
+	UPROPERTY(Config)
+	float MinimalEffectsDistance{ 1500.f };
+
+	UPROPERTY(Config)
+	int32 ReducedItemTraceInterval{ 2 };
+	UPROPERTY(Config)
+	int32 MinimalItemTraceInterval{ 4 };
+
+	UPROPERTY(Config)
+	int32 ReducedPickupInterpInterval{ 2 };
+	UPROPERTY(Config)
+	int32 MinimalPickupInterpInterval{ 3 };
+
+	// Off by default, the remote meshes drive the hitboxes and the reload notifies
+	UPROPERTY(Config)
+	bool bThrottleRemoteAnims{ false };
+	// Mesh tick interval of remote characters, 0 ticks every frame
+	UPROPERTY(Config)
+	float ReducedRemoteAnimInterval{ 1.f / 30.f };
+	UPROPERTY(Config)
+	float MinimalRemoteAnimInterval{ 1.f / 15.f };
+	// Seconds between passes over the characters, picks up spawns and possession changes
+	UPROPERTY(Config)
+	float AnimIntervalRefresh{ 1.f };
+};
@@ -0,0 +1,214 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterGCReportSubsystem.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/ScopeLock.h"
+#include "UObject/UObjectGlobals.h"
+#include "UObject/UObjectIterator.h"
+
+#include "UltimateShooter.h"
+
+static FAutoConsoleCommandWithWorldAndArgs GGCReportCommand(
+	TEXT("Shooter.GC.Report"),
+	TEXT("Shooter.GC.Report - logs objects created and destroyed per minute by class and the GC pauses since the last report"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UShooterGCReportSubsystem* GCReport = UShooterGCReportSubsystem::Get(World);
+		if (!GCReport) return;
+
+		if (GCReport->IsTracking()) { GCReport->Report(); }
+		else
+		{
+			GCReport->StartTracking();
+			UE_LOG(LogUltimateShooter, Log, TEXT("GC report: tracking started, run Shooter.GC.Report again for the window"));
+		}
+	}));
+
+void FShooterObjectChurnTracker::Start()
+{
+	if (bTracking) return;
+
+	{
+		// Objects already alive get their name too, their deletes are counted like the others
+		FScopeLock Lock{ &CountsLock };
+		ClassNames.Reset();
+		ClassNames.SetNum(GUObjectArray.GetObjectArrayNum());
+		for (FRawObjectIterator It; It; ++It)
+		{
+			const UObjectBase* Object = static_cast<const UObjectBase*>((*It)->Object);
+			ClassNames[GUObjectArray.ObjectToIndex(Object)] = Object->GetClass()->GetFName();
+		}
+	}
+
+	GUObjectArray.AddUObjectCreateListener(this);
+	GUObjectArray.AddUObjectDeleteListener(this);
+	bTracking = true;
+}
+
+void FShooterObjectChurnTracker::Stop()
+{
+	if (!bTracking) return;
+
+	GUObjectArray.RemoveUObjectCreateListener(this);
+	GUObjectArray.RemoveUObjectDeleteListener(this);
+	bTracking = false;
+
+	FScopeLock Lock{ &CountsLock };
+	Counts.Reset();
+	ClassNames.Empty();
+}
+
+TMap<FName, FShooterObjectChurnTracker::FClassChurn> FShooterObjectChurnTracker::ConsumeCounts()
+{
+	FScopeLock Lock{ &CountsLock };
+	return MoveTemp(Counts);
+}
+
+void FShooterObjectChurnTracker::NotifyUObjectCreated(const UObjectBase* Object, int32 Index)
+{
+	// The class is set before the object gets its index, and it outlives its instances
+	const FName ClassName{ Object->GetClass()->GetFName() };
+
+	FScopeLock Lock{ &CountsLock };
+	++Counts.FindOrAdd(ClassName).Created;
+	if (Index >= ClassNames.Num()) { ClassNames.SetNum(Index + 1); }
+	ClassNames[Index] = ClassName;
+}
+
+void FShooterObjectChurnTracker::NotifyUObjectDeleted(const UObjectBase* Object, int32 Index)
+{
+	// Don't touch the object, its class may already be freed
+	FScopeLock Lock{ &CountsLock };
+	if (!ClassNames.IsValidIndex(Index) || ClassNames[Index].IsNone()) return;
+
+	++Counts.FindOrAdd(ClassNames[Index]).Deleted;
+	ClassNames[Index] = NAME_None;
+}
+
+void FShooterObjectChurnTracker::OnUObjectArrayShutdown()
+{
+	Stop();
+}
+
+bool UShooterGCReportSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+UShooterGCReportSubsystem* UShooterGCReportSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UShooterGCReportSubsystem>() : nullptr;
+}
+
+TStatId UShooterGCReportSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterGCReportSubsystem, STATGROUP_Tickables);
+}
+
+void UShooterGCReportSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (bEnabled || FParse::Param(FCommandLine::Get(), TEXT("ShooterGCReport"))) { StartTracking(); }
+}
+
+void UShooterGCReportSubsystem::Deinitialize()
+{
+	StopTracking();
+
+	Super::Deinitialize();
+}
+
+void UShooterGCReportSubsystem::StartTracking()
+{
+	if (IsTracking()) return;
+
+	ChurnTracker.Start();
+	PreGarbageCollectHandle = FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddUObject(this, &UShooterGCReportSubsystem::OnPreGarbageCollect);
+	PostGarbageCollectHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject(this, &UShooterGCReportSubsystem::OnPostGarbageCollect);
+
+	WindowStartTime = FPlatformTime::Seconds();
+	GCStartTime = 0.0;
+	GCPausesMs.Reset();
+}
+
+void UShooterGCReportSubsystem::StopTracking()
+{
+	if (!IsTracking()) return;
+
+	ChurnTracker.Stop();
+	FCoreUObjectDelegates::GetPreGarbageCollectDelegate().Remove(PreGarbageCollectHandle);
+	FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGarbageCollectHandle);
+	PreGarbageCollectHandle.Reset();
+	PostGarbageCollectHandle.Reset();
+}
+
+void UShooterGCReportSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (IsTracking() && FPlatformTime::Seconds() - WindowStartTime >= ReportInterval) { Report(); }
+}
+
+void UShooterGCReportSubsystem::OnPreGarbageCollect()
+{
+	GCStartTime = FPlatformTime::Seconds();
+}
+
+void UShooterGCReportSubsystem::OnPostGarbageCollect()
+{
+	if (GCStartTime <= 0.0) return;
+
+	// Reachability and the part of the purge that runs in the same frame, the rest of an incremental purge is spread over later frames
+	const float PauseMs{ static_cast<float>((FPlatformTime::Seconds() - GCStartTime) * 1000.0) };
+	GCStartTime = 0.0;
+	GCPausesMs.Add(PauseMs);
+	CSV_CUSTOM_STAT(ShooterGameplay, GCPauseMs, PauseMs, ECsvCustomStatOp::Set);
+}
+
+void UShooterGCReportSubsystem::Report()
+{
+	const double Now{ FPlatformTime::Seconds() };
+	const double WindowMinutes{ FMath::Max(Now - WindowStartTime, 1.0) / 60.0 };
+	WindowStartTime = Now;
+
+	TMap<FName, FShooterObjectChurnTracker::FClassChurn> Counts{ ChurnTracker.ConsumeCounts() };
+
+	int64 TotalCreated{ 0 };
+	int64 TotalDeleted{ 0 };
+	for (const TPair<FName, FShooterObjectChurnTracker::FClassChurn>& Pair : Counts)
+	{
+		TotalCreated += Pair.Value.Created;
+		TotalDeleted += Pair.Value.Deleted;
+	}
+
+	float TotalPauseMs{ 0.f };
+	float MaxPauseMs{ 0.f };
+	for (const float PauseMs : GCPausesMs)
+	{
+		TotalPauseMs += PauseMs;
+		MaxPauseMs = FMath::Max(MaxPauseMs, PauseMs);
+	}
+
+	UE_LOG(LogUltimateShooter, Log, TEXT("GC report over %.1f min: %.0f created/min, %.0f destroyed/min, %d collections, pause avg %.2f ms max %.2f ms"),
+		WindowMinutes, TotalCreated / WindowMinutes, TotalDeleted / WindowMinutes, GCPausesMs.Num(),
+		GCPausesMs.Num() > 0 ? TotalPauseMs / GCPausesMs.Num() : 0.f, MaxPauseMs);
+	GCPausesMs.Reset();
+
+	Counts.ValueSort([](const FShooterObjectChurnTracker::FClassChurn& A, const FShooterObjectChurnTracker::FClassChurn& B)
+	{
+		return A.Created + A.Deleted > B.Created + B.Deleted;
+	});
+
+	int32 NumReported{ 0 };
+	for (const TPair<FName, FShooterObjectChurnTracker::FClassChurn>& Pair : Counts)
+	{
+		if (NumReported++ >= NumReportedClasses) break;
+		UE_LOG(LogUltimateShooter, Log, TEXT("  %-40s %8.1f created/min %8.1f destroyed/min"),
+			*Pair.Key.ToString(), Pair.Value.Created / WindowMinutes, Pair.Value.Deleted / WindowMinutes);
+	}
+}
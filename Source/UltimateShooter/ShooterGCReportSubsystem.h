@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HAL/CriticalSection.h"
+#include "UObject/UObjectArray.h"
+#include "ShooterGCReportSubsystem.generated.h"
+
+/**
+ * Counts UObjects created and deleted by class name. The object array notifies from whatever thread
+ * allocates or frees the object (async loading, async purge), so the counts sit behind a lock.
+ * The class can be purged in the same pass as its instances, so deletes look up the name recorded at creation.
+ */
+class FShooterObjectChurnTracker : public FUObjectArray::FUObjectCreateListener, public FUObjectArray::FUObjectDeleteListener
+{
+public:
+	struct FClassChurn
+	{
+		int32 Created{ 0 };
+		int32 Deleted{ 0 };
+	};
+
+	~FShooterObjectChurnTracker() { Stop(); }
+
+	void Start();
+	void Stop();
+	bool IsTracking() const { return bTracking; }
+
+	// Counts since the last call, resets them
+	TMap<FName, FClassChurn> ConsumeCounts();
+
+	virtual void NotifyUObjectCreated(const UObjectBase* Object, int32 Index) override;
+	virtual void NotifyUObjectDeleted(const UObjectBase* Object, int32 Index) override;
+	virtual void OnUObjectArrayShutdown() override;
+
+private:
+	FCriticalSection CountsLock;
+	TMap<FName, FClassChurn> Counts;
+	// Class name by object index, None for free slots
+	TArray<FName> ClassNames;
+	bool bTracking{ false };
+};
+
+/**
+ * GC pressure report for long bot matches. Every ReportInterval logs the objects created and destroyed per minute by class
+ * and the pause of every collection in the window, so churn fixes can be compared on the incremental GC pauses they buy.
+ * Off unless bEnabled or -ShooterGCReport, Shooter.GC.Report logs the window so far and starts tracking.
+ * Of the churn it lists only the shot emitters are pooled (EPSCPoolMethod::AutoRelease). Picked up ammo is still
+ * destroyed and weapons still spawned by SpawnDefaultWeapon, whether they're worth pooling is for this report to show.
+ */
+UCLASS(Config = Game)
+class ULTIMATESHOOTER_API UShooterGCReportSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	static UShooterGCReportSubsystem* Get(const UObject* WorldContextObject);
+
+	void StartTracking();
+	void StopTracking();
+	bool IsTracking() const { return ChurnTracker.IsTracking(); }
+
+	// Logs the window so far and starts a new one
+	void Report();
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	void OnPreGarbageCollect();
+	void OnPostGarbageCollect();
+
+private:
+	FShooterObjectChurnTracker ChurnTracker;
+
+	double WindowStartTime{ 0.0 };
+	double GCStartTime{ 0.0 };
+	// Pauses of the collections in the window
+	TArray<float> GCPausesMs;
+
+	FDelegateHandle PreGarbageCollectHandle;
+	FDelegateHandle PostGarbageCollectHandle;
+
+	UPROPERTY(Config)
+	bool bEnabled{ false };
+	// Seconds per report window
+	UPROPERTY(Config)
+	float ReportInterval{ 60.f };
+	// Classes listed per report, by most churn
+	UPROPERTY(Config)
+	int32 NumReportedClasses{ 15 };
+};
@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterHUDViewModel.h"
+
+#include "UltimateShooter.h"
+
+void UShooterHUDViewModel::SetAmmo(int32 InMagazineAmmo, int32 InCarriedAmmo)
+{
+	if (MagazineAmmo == InMagazineAmmo && CarriedAmmo == InCarriedAmmo) return;
+
+	MagazineAmmo = InMagazineAmmo;
+	CarriedAmmo = InCarriedAmmo;
+	OnAmmoChanged.Broadcast(MagazineAmmo, CarriedAmmo);
+	CSV_CUSTOM_STAT(ShooterGameplay, HUDUpdates, 1, ECsvCustomStatOp::Accumulate);
+}
+
+void UShooterHUDViewModel::SetCombatState(ECombatState InCombatState)
+{
+	if (CombatState == InCombatState) return;
+
+	CombatState = InCombatState;
+	OnCombatStateChanged.Broadcast(CombatState);
+	CSV_CUSTOM_STAT(ShooterGameplay, HUDUpdates, 1, ECsvCustomStatOp::Accumulate);
+}
+
+void UShooterHUDViewModel::SetWeapon(AWeapon* InWeapon)
+{
+	if (Weapon == InWeapon) return;
+
+	Weapon = InWeapon;
+	OnWeaponChanged.Broadcast(Weapon);
+	CSV_CUSTOM_STAT(ShooterGameplay, HUDUpdates, 1, ECsvCustomStatOp::Accumulate);
+}
@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/NoExportTypes.h"
+#include "ShooterCharacter.h"
+#include "ShooterHUDViewModel.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnHUDAmmoChanged, int32, MagazineAmmo, int32, CarriedAmmo);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnHUDCombatStateChanged, ECombatState, CombatState);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnHUDWeaponChanged, class AWeapon*, Weapon);
+
+/**
+ * HUD state of a character. The character pushes values here and the HUD is only notified when something changed,
+ * so widgets don't need per-frame bindings.
+ */
+UCLASS(BlueprintType)
+class ULTIMATESHOOTER_API UShooterHUDViewModel : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	void SetAmmo(int32 InMagazineAmmo, int32 InCarriedAmmo);
+	void SetCombatState(ECombatState InCombatState);
+	void SetWeapon(class AWeapon* InWeapon);
+
+	FORCEINLINE int32 GetMagazineAmmo() const { return MagazineAmmo; }
+	FORCEINLINE int32 GetCarriedAmmo() const { return CarriedAmmo; }
+	FORCEINLINE ECombatState GetCombatState() const { return CombatState; }
+	FORCEINLINE AWeapon* GetWeapon() const { return Weapon; }
+
+	UPROPERTY(BlueprintAssignable, Category = HUD)
+	FOnHUDAmmoChanged OnAmmoChanged;
+	UPROPERTY(BlueprintAssignable, Category = HUD)
+	FOnHUDCombatStateChanged OnCombatStateChanged;
+	UPROPERTY(BlueprintAssignable, Category = HUD)
+	FOnHUDWeaponChanged OnWeaponChanged;
+
+private:
+	// Ammo in the equipped weapon
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = HUD, meta = (AllowPrivateAccess = "true"))
+	int32 MagazineAmmo{ 0 };
+	// Ammo carried for the equipped weapon type
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = HUD, meta = (AllowPrivateAccess = "true"))
+	int32 CarriedAmmo{ 0 };
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = HUD, meta = (AllowPrivateAccess = "true"))
+	ECombatState CombatState{ ECombatState::ECS_Unoccupied };
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = HUD, meta = (AllowPrivateAccess = "true"))
+	class AWeapon* Weapon{ nullptr };
+};
@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterHealthComponent.h"
+#include "ShooterDamageSubsystem.h"
+
+UShooterHealthComponent::UShooterHealthComponent()
+	: MaxHealth(100.f), RecordIndex(INDEX_NONE)
+{
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UShooterHealthComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (UShooterDamageSubsystem* Damage = UShooterDamageSubsystem::Get(this)) { Damage->RegisterHealth(this); }
+}
+
+void UShooterHealthComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UShooterDamageSubsystem* Damage = UShooterDamageSubsystem::Get(this)) { Damage->UnregisterHealth(this); }
+
+	Super::EndPlay(EndPlayReason);
+}
+
+float UShooterHealthComponent::GetHealth() const
+{
+	const UShooterDamageSubsystem* Damage = UShooterDamageSubsystem::Get(this);
+	return Damage && RecordIndex != INDEX_NONE ? Damage->GetHealth(RecordIndex) : MaxHealth;
+}
+
+void UShooterHealthComponent::ResetHealth()
+{
+	if (UShooterDamageSubsystem* Damage = UShooterDamageSubsystem::Get(this); Damage && RecordIndex != INDEX_NONE)
+	{
+		Damage->SetHealth(RecordIndex, MaxHealth);
+	}
+}
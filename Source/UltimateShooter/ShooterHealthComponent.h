@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "ShooterHealthComponent.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnShooterHitReact, AActor*, DamageInstigator, float, Damage, FName, Bone);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnShooterDeath, AActor*, Killer);
+
+/**
+ * Makes the owner damageable. The health value lives in a dense record of UShooterDamageSubsystem,
+ * damage is applied there once per frame and the events below are broadcast after the batch.
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class ULTIMATESHOOTER_API UShooterHealthComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+	friend class UShooterDamageSubsystem;
+
+public:
+	UShooterHealthComponent();
+
+	UFUNCTION(BlueprintCallable, Category = Health)
+	float GetHealth() const;
+	UFUNCTION(BlueprintCallable, Category = Health)
+	float GetMaxHealth() const { return MaxHealth; }
+	UFUNCTION(BlueprintCallable, Category = Health)
+	bool IsDead() const { return GetHealth() <= 0.f; }
+
+	// Back to full health
+	void ResetHealth();
+
+	UPROPERTY(BlueprintAssignable, Category = Health)
+	FOnShooterHitReact OnHitReact;
+
+	UPROPERTY(BlueprintAssignable, Category = Health)
+	FOnShooterDeath OnDeath;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Health, meta = (AllowPrivateAccess = "true", ClampMin = "1.0"))
+	float MaxHealth;
+
+	// Index of the health record, kept up to date by the damage subsystem
+	int32 RecordIndex;
+};
@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterHitboxBVH.h"
+#include "Algo/Sort.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	// Nodes per worker task, refitting a node is only a few box unions
+	constexpr int32 RefitBatchSize{ 32 };
+}
+
+void FShooterHitboxBVH::Reset()
+{
+	Nodes.Reset();
+	ItemOrder.Reset();
+	SortedBounds.Reset();
+	NodesByDepth.Reset();
+}
+
+void FShooterHitboxBVH::Build(TConstArrayView<FBox> ItemBounds)
+{
+	Reset();
+	if (ItemBounds.Num() == 0) return;
+
+	ItemOrder.SetNumUninitialized(ItemBounds.Num());
+	for (int32 Index = 0; Index < ItemOrder.Num(); ++Index) { ItemOrder[Index] = Index; }
+
+	Nodes.AddDefaulted();
+	BuildNode(0, 0, ItemBounds.Num(), 0, ItemBounds);
+
+	SortedBounds.SetNumUninitialized(ItemOrder.Num());
+	for (int32 Index = 0; Index < ItemOrder.Num(); ++Index) { SortedBounds[Index] = ItemBounds[ItemOrder[Index]]; }
+}
+
+void FShooterHitboxBVH::BuildNode(int32 NodeIndex, int32 First, int32 Count, int32 Depth, TConstArrayView<FBox> ItemBounds)
+{
+	if (NodesByDepth.Num() <= Depth) { NodesByDepth.SetNum(Depth + 1); }
+	NodesByDepth[Depth].Add(NodeIndex);
+
+	FBox Bounds{ ForceInit };
+	FBox Centers{ ForceInit };
+	for (int32 Index = First; Index < First + Count; ++Index)
+	{
+		Bounds += ItemBounds[ItemOrder[Index]];
+		Centers += ItemBounds[ItemOrder[Index]].GetCenter();
+	}
+	Nodes[NodeIndex].Bounds = Bounds;
+
+	if (Count <= MaxLeafItems || Depth + 1 >= MaxStackDepth / 2)
+	{
+		Nodes[NodeIndex].First = First;
+		Nodes[NodeIndex].Count = Count;
+		return;
+	}
+
+	// Median split on the longest axis of the item centers
+	const FVector Extent{ Centers.GetExtent() };
+	const int32 Axis{ Extent.X >= Extent.Y && Extent.X >= Extent.Z ? 0 : (Extent.Y >= Extent.Z ? 1 : 2) };
+	Algo::Sort(MakeArrayView(ItemOrder.GetData() + First, Count), [ItemBounds, Axis](int32 A, int32 B)
+	{
+		return ItemBounds[A].GetCenter()[Axis] < ItemBounds[B].GetCenter()[Axis];
+	});
+
+	// Nodes may reallocate, work with indices only
+	const int32 Child{ Nodes.AddDefaulted(2) };
+	Nodes[NodeIndex].Child = Child;
+
+	const int32 Half{ Count / 2 };
+	BuildNode(Child, First, Half, Depth + 1, ItemBounds);
+	BuildNode(Child + 1, First + Half, Count - Half, Depth + 1, ItemBounds);
+}
+
+void FShooterHitboxBVH::Refit(TConstArrayView<FBox> ItemBounds)
+{
+	check(ItemBounds.Num() == ItemOrder.Num());
+
+	ParallelFor(TEXT("HitboxBVH.RefitLeaves"), SortedBounds.Num(), RefitBatchSize * MaxLeafItems, [this, ItemBounds](int32 Index)
+	{
+		SortedBounds[Index] = ItemBounds[ItemOrder[Index]];
+	});
+
+	// A level only reads the level below, so each level is refit in parallel
+	for (int32 Depth = NodesByDepth.Num() - 1; Depth >= 0; --Depth)
+	{
+		const TArray<int32>& Level = NodesByDepth[Depth];
+		ParallelFor(TEXT("HitboxBVH.RefitLevel"), Level.Num(), RefitBatchSize, [this, &Level](int32 Index)
+		{
+			FNode& Node = Nodes[Level[Index]];
+			if (Node.IsLeaf())
+			{
+				FBox Bounds{ ForceInit };
+				for (int32 Item = Node.First; Item < Node.First + Node.Count; ++Item) { Bounds += SortedBounds[Item]; }
+				Node.Bounds = Bounds;
+			}
+			else
+			{
+				Node.Bounds = Nodes[Node.Child].Bounds + Nodes[Node.Child + 1].Bounds;
+			}
+		});
+	}
+}
@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Bounding volume hierarchy over item boxes (one box per character hitbox set).
+ * Built with median splits when the item set changes, refit level by level in parallel every frame.
+ */
+class ULTIMATESHOOTER_API FShooterHitboxBVH
+{
+public:
+	void Build(TConstArrayView<FBox> ItemBounds);
+	// Same items as the last Build, new boxes
+	void Refit(TConstArrayView<FBox> ItemBounds);
+	void Reset();
+
+	int32 NumItems() const { return ItemOrder.Num(); }
+	int32 NumNodes() const { return Nodes.Num(); }
+
+	/**
+	 * Calls Visitor(ItemIndex, MaxDistance) for every item box the segment Start + Dir * [0, Length] enters, nearest nodes first.
+	 * The visitor returns the new max distance, so boxes behind the closest hit so far are skipped.
+	 */
+	template<typename VisitorType>
+	void Raycast(const FVector& Start, const FVector& Dir, float Length, VisitorType&& Visitor) const;
+
+	static bool RayBoxEntry(const FBox& Box, const FVector& Start, const FVector& InvDir, float MaxDistance, float& OutEntry);
+
+private:
+	struct FNode
+	{
+		FBox Bounds{ ForceInit };
+		// Children are Child and Child + 1, INDEX_NONE for leaves
+		int32 Child{ INDEX_NONE };
+		// Leaf items in ItemOrder
+		int32 First{ 0 };
+		int32 Count{ 0 };
+
+		bool IsLeaf() const { return Child == INDEX_NONE; }
+	};
+
+	static constexpr int32 MaxLeafItems{ 4 };
+	static constexpr int32 MaxStackDepth{ 64 };
+
+	void BuildNode(int32 NodeIndex, int32 First, int32 Count, int32 Depth, TConstArrayView<FBox> ItemBounds);
+
+	TArray<FNode> Nodes;
+	TArray<int32> ItemOrder;
+	// Item boxes in ItemOrder order, tested in the leaves
+	TArray<FBox> SortedBounds;
+	// Node indices of each tree level, refit from the deepest one up
+	TArray<TArray<int32>> NodesByDepth;
+};
+
+FORCEINLINE bool FShooterHitboxBVH::RayBoxEntry(const FBox& Box, const FVector& Start, const FVector& InvDir, float MaxDistance, float& OutEntry)
+{
+	const FVector T0{ (Box.Min - Start) * InvDir };
+	const FVector T1{ (Box.Max - Start) * InvDir };
+	const FVector TMin{ T0.ComponentMin(T1) };
+	const FVector TMax{ T0.ComponentMax(T1) };
+
+	const double Entry{ FMath::Max(TMin.GetMax(), 0.0) };
+	const double Exit{ FMath::Min(TMax.GetMin(), static_cast<double>(MaxDistance)) };
+
+	OutEntry = static_cast<float>(Entry);
+	return Entry <= Exit;
+}
+
+template<typename VisitorType>
+void FShooterHitboxBVH::Raycast(const FVector& Start, const FVector& Dir, float Length, VisitorType&& Visitor) const
+{
+	if (Nodes.Num() == 0) return;
+
+	const FVector InvDir{
+		Dir.X != 0.0 ? 1.0 / Dir.X : UE_BIG_NUMBER,
+		Dir.Y != 0.0 ? 1.0 / Dir.Y : UE_BIG_NUMBER,
+		Dir.Z != 0.0 ? 1.0 / Dir.Z : UE_BIG_NUMBER };
+
+	float MaxDistance{ Length };
+	float Entry;
+	if (!RayBoxEntry(Nodes[0].Bounds, Start, InvDir, MaxDistance, Entry)) return;
+
+	int32 Stack[MaxStackDepth];
+	int32 StackSize{ 0 };
+	Stack[StackSize++] = 0;
+
+	while (StackSize > 0)
+	{
+		const FNode& Node = Nodes[Stack[--StackSize]];
+		if (Node.IsLeaf())
+		{
+			for (int32 Index = Node.First; Index < Node.First + Node.Count; ++Index)
+			{
+				if (RayBoxEntry(SortedBounds[Index], Start, InvDir, MaxDistance, Entry))
+				{
+					MaxDistance = Visitor(ItemOrder[Index], MaxDistance);
+				}
+			}
+			continue;
+		}
+
+		float NearEntry, FarEntry;
+		int32 Near{ Node.Child };
+		int32 Far{ Node.Child + 1 };
+		bool bNear{ RayBoxEntry(Nodes[Near].Bounds, Start, InvDir, MaxDistance, NearEntry) };
+		bool bFar{ RayBoxEntry(Nodes[Far].Bounds, Start, InvDir, MaxDistance, FarEntry) };
+		if (bNear && bFar && FarEntry < NearEntry)
+		{
+			Swap(Near, Far);
+		}
+		else if (!bNear)
+		{
+			Swap(Near, Far);
+			Swap(bNear, bFar);
+		}
+
+		// Near child pushed last so it is popped first
+		checkSlow(StackSize + 2 <= MaxStackDepth);
+		if (bFar) { Stack[StackSize++] = Far; }
+		if (bNear) { Stack[StackSize++] = Near; }
+	}
+}
@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterHitboxComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/Character.h"
+#include "ShooterHitboxSubsystem.h"
+
+#include "UltimateShooter.h"
+
+UShooterHitboxComponent::UShooterHitboxComponent()
+{
+	// Updated by UShooterHitboxSubsystem with every other hitbox once animation is done
+	PrimaryComponentTick.bCanEverTick = false;
+
+	// Mannequin skeleton, override in the character Blueprint for other skeletons
+	Capsules = {
+		{ TEXT("head"), NAME_None, 12.f },
+		{ TEXT("spine_03"), TEXT("neck_01"), 16.f },
+		{ TEXT("spine_01"), TEXT("spine_03"), 18.f },
+		{ TEXT("pelvis"), TEXT("spine_01"), 16.f },
+		{ TEXT("upperarm_l"), TEXT("lowerarm_l"), 7.f },
+		{ TEXT("lowerarm_l"), TEXT("hand_l"), 6.f },
+		{ TEXT("upperarm_r"), TEXT("lowerarm_r"), 7.f },
+		{ TEXT("lowerarm_r"), TEXT("hand_r"), 6.f },
+		{ TEXT("thigh_l"), TEXT("calf_l"), 10.f },
+		{ TEXT("calf_l"), TEXT("foot_l"), 8.f },
+		{ TEXT("thigh_r"), TEXT("calf_r"), 10.f },
+		{ TEXT("calf_r"), TEXT("foot_r"), 8.f },
+	};
+}
+
+void UShooterHitboxComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	const ACharacter* Character = Cast<ACharacter>(GetOwner());
+	Mesh = Character ? Character->GetMesh() : nullptr;
+	if (!Mesh) return;
+
+	BoneIndices.Reset(Capsules.Num());
+	CapsulesSoA.Reset();
+	for (const FShooterHitboxCapsule& Capsule : Capsules)
+	{
+		const int32 StartIndex{ Mesh->GetBoneIndex(Capsule.StartBone) };
+		if (StartIndex == INDEX_NONE)
+		{
+			UE_LOG(LogUltimateShooter, Warning, TEXT("%s: hitbox bone %s not found"), *GetNameSafe(GetOwner()), *Capsule.StartBone.ToString());
+		}
+		const int32 EndIndex{ Capsule.EndBone.IsNone() ? StartIndex : Mesh->GetBoneIndex(Capsule.EndBone) };
+
+		BoneIndices.Emplace(StartIndex, EndIndex == INDEX_NONE ? StartIndex : EndIndex);
+		CapsulesSoA.Add(FVector3f::ZeroVector, FVector3f::ZeroVector, Capsule.Radius);
+	}
+	CapsulesSoA.Pad();
+
+	UpdateCapsules();
+
+	if (UShooterHitboxSubsystem* Hitboxes = UShooterHitboxSubsystem::Get(this)) { Hitboxes->RegisterHitbox(this); }
+}
+
+void UShooterHitboxComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UShooterHitboxSubsystem* Hitboxes = UShooterHitboxSubsystem::Get(this)) { Hitboxes->UnregisterHitbox(this); }
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UShooterHitboxComponent::UpdateCapsules()
+{
+	if (!Mesh) return;
+
+	Bounds.Init();
+	for (int32 Index = 0; Index < BoneIndices.Num(); ++Index)
+	{
+		// Missing bones collapse on the actor location
+		const FVector3f A{ BoneIndices[Index].Key != INDEX_NONE ? Mesh->GetBoneTransform(BoneIndices[Index].Key).GetLocation() : Mesh->GetComponentLocation() };
+		const FVector3f B{ BoneIndices[Index].Value != INDEX_NONE ? Mesh->GetBoneTransform(BoneIndices[Index].Value).GetLocation() : Mesh->GetComponentLocation() };
+		const float Radius{ CapsulesSoA.Radius[Index] };
+
+		CapsulesSoA.Set(Index, A, B, Radius);
+
+		Bounds += FBox(FVector(A.ComponentMin(B) - Radius), FVector(A.ComponentMax(B) + Radius));
+	}
+}
+
+void UShooterHitboxComponent::SetHitboxEnabled(bool bEnabled)
+{
+	UShooterHitboxSubsystem* Hitboxes = UShooterHitboxSubsystem::Get(this);
+	if (!Hitboxes || !Mesh) return;
+
+	if (bEnabled)
+	{
+		UpdateCapsules();
+		Hitboxes->RegisterHitbox(this);
+	}
+	else
+	{
+		Hitboxes->UnregisterHitbox(this);
+	}
+}
+
+bool UShooterHitboxComponent::Raycast(const FVector& Start, const FVector& Dir, float Length, FName& OutBone, float& OutDistance) const
+{
+	const int32 CapsuleIndex{ ShooterHitbox::RaycastCapsules(CapsulesSoA, FVector3f(Start), FVector3f(Dir), Length, OutDistance) };
+	if (!Capsules.IsValidIndex(CapsuleIndex)) return false;
+
+	OutBone = Capsules[CapsuleIndex].StartBone;
+	return true;
+}
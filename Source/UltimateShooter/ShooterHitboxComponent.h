@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "ShooterHitboxKernel.h"
+#include "ShooterHitboxComponent.generated.h"
+
+USTRUCT(BlueprintType)
+struct FShooterHitboxCapsule
+{
+	GENERATED_BODY()
+
+	FShooterHitboxCapsule() {}
+	FShooterHitboxCapsule(FName InStartBone, FName InEndBone, float InRadius)
+		: StartBone(InStartBone), EndBone(InEndBone), Radius(InRadius) {}
+
+	// Bone reported when the capsule is hit
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	FName StartBone;
+
+	// Other end of the capsule segment, the capsule is a sphere when None
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	FName EndBone;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	float Radius{ 10.f };
+};
+
+/**
+ * A handful of capsules between bones of the owner mesh.
+ * UShooterHitboxSubsystem refreshes them after animation and tests shots against them.
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class ULTIMATESHOOTER_API UShooterHitboxComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UShooterHitboxComponent();
+
+	// Moves the capsules to the current bone transforms, safe to call from worker threads
+	void UpdateCapsules();
+
+	// Adds or removes the capsules from hit registration, used by pooled characters
+	void SetHitboxEnabled(bool bEnabled);
+
+	// Nearest capsule hit by the segment Start + Dir * [0, Length]
+	bool Raycast(const FVector& Start, const FVector& Dir, float Length, FName& OutBone, float& OutDistance) const;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Hitbox, meta = (AllowPrivateAccess = "true"))
+	TArray<FShooterHitboxCapsule> Capsules;
+
+	UPROPERTY(Transient)
+	class USkeletalMeshComponent* Mesh;
+
+	// Bone indices of every capsule, resolved on begin play
+	TArray<TPair<int32, int32>> BoneIndices;
+
+	// World space capsules and their bounds
+	FHitboxCapsuleSoA CapsulesSoA;
+	FBox Bounds{ ForceInit };
+
+public:
+	FORCEINLINE const FHitboxCapsuleSoA& GetCapsulesSoA() const { return CapsulesSoA; }
+	FORCEINLINE const FBox& GetBounds() const { return Bounds; }
+};
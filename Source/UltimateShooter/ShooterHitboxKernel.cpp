@@ -0,0 +1,173 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterHitboxKernel.h"
+#include "Math/VectorRegister.h"
+
+namespace
+{
+	// Far away zero radius capsule used to fill the last vector lanes
+	constexpr float PadCoordinate{ 1.e10f };
+
+	FORCEINLINE VectorRegister4Float Dot3(
+		const VectorRegister4Float& AX, const VectorRegister4Float& AY, const VectorRegister4Float& AZ,
+		const VectorRegister4Float& BX, const VectorRegister4Float& BY, const VectorRegister4Float& BZ)
+	{
+		return VectorMultiplyAdd(AX, BX, VectorMultiplyAdd(AY, BY, VectorMultiply(AZ, BZ)));
+	}
+
+	FORCEINLINE VectorRegister4Float Clamp01(const VectorRegister4Float& V)
+	{
+		return VectorMin(VectorMax(V, VectorZeroFloat()), VectorOneFloat());
+	}
+}
+
+void FHitboxCapsuleSoA::Reset()
+{
+	AX.Reset(); AY.Reset(); AZ.Reset();
+	BX.Reset(); BY.Reset(); BZ.Reset();
+	Radius.Reset();
+	NumCapsules = 0;
+}
+
+void FHitboxCapsuleSoA::Add(const FVector3f& A, const FVector3f& B, float InRadius)
+{
+	// Drop the padding of a previous Pad call
+	const int32 Index{ NumCapsules++ };
+	AX.SetNum(NumCapsules); AY.SetNum(NumCapsules); AZ.SetNum(NumCapsules);
+	BX.SetNum(NumCapsules); BY.SetNum(NumCapsules); BZ.SetNum(NumCapsules);
+	Radius.SetNum(NumCapsules);
+
+	Set(Index, A, B, InRadius);
+}
+
+void FHitboxCapsuleSoA::Set(int32 Index, const FVector3f& A, const FVector3f& B, float InRadius)
+{
+	AX[Index] = A.X; AY[Index] = A.Y; AZ[Index] = A.Z;
+	BX[Index] = B.X; BY[Index] = B.Y; BZ[Index] = B.Z;
+	Radius[Index] = InRadius;
+}
+
+void FHitboxCapsuleSoA::Pad()
+{
+	const int32 PaddedNum{ Align(NumCapsules, 4) };
+	for (TArray<float>* Coordinate : { &AX, &AY, &AZ, &BX, &BY, &BZ })
+	{
+		Coordinate->SetNum(PaddedNum);
+		for (int32 Index = NumCapsules; Index < PaddedNum; ++Index) { (*Coordinate)[Index] = PadCoordinate; }
+	}
+	Radius.SetNum(PaddedNum);
+	for (int32 Index = NumCapsules; Index < PaddedNum; ++Index) { Radius[Index] = 0.f; }
+}
+
+int32 ShooterHitbox::RaycastCapsules(const FHitboxCapsuleSoA& Capsules, const FVector3f& Start, const FVector3f& Dir, float Length, float& OutDistance)
+{
+	checkSlow(Capsules.AX.Num() % 4 == 0);
+
+	// Closest points between the shot segment P(s) = Start + D1 * s and each capsule segment Q(t) = A + D2 * t (Ericson, 5.1.9)
+	const VectorRegister4Float SX{ VectorSetFloat1(Start.X) };
+	const VectorRegister4Float SY{ VectorSetFloat1(Start.Y) };
+	const VectorRegister4Float SZ{ VectorSetFloat1(Start.Z) };
+	const VectorRegister4Float D1X{ VectorSetFloat1(Dir.X * Length) };
+	const VectorRegister4Float D1Y{ VectorSetFloat1(Dir.Y * Length) };
+	const VectorRegister4Float D1Z{ VectorSetFloat1(Dir.Z * Length) };
+	const VectorRegister4Float A1{ VectorSetFloat1(Length * Length) };
+	const VectorRegister4Float InvA1{ VectorSetFloat1(1.f / FMath::Max(Length * Length, UE_KINDA_SMALL_NUMBER)) };
+	const VectorRegister4Float LengthV{ VectorSetFloat1(Length) };
+	const VectorRegister4Float Epsilon{ VectorSetFloat1(UE_KINDA_SMALL_NUMBER) };
+	const VectorRegister4Float Zero{ VectorZeroFloat() };
+
+	int32 BestIndex{ INDEX_NONE };
+	float BestDistance{ TNumericLimits<float>::Max() };
+
+	const int32 NumPadded{ Capsules.AX.Num() };
+	for (int32 Index = 0; Index < NumPadded; Index += 4)
+	{
+		const VectorRegister4Float AX{ VectorLoad(&Capsules.AX[Index]) };
+		const VectorRegister4Float AY{ VectorLoad(&Capsules.AY[Index]) };
+		const VectorRegister4Float AZ{ VectorLoad(&Capsules.AZ[Index]) };
+
+		const VectorRegister4Float D2X{ VectorSubtract(VectorLoad(&Capsules.BX[Index]), AX) };
+		const VectorRegister4Float D2Y{ VectorSubtract(VectorLoad(&Capsules.BY[Index]), AY) };
+		const VectorRegister4Float D2Z{ VectorSubtract(VectorLoad(&Capsules.BZ[Index]), AZ) };
+
+		const VectorRegister4Float RX{ VectorSubtract(SX, AX) };
+		const VectorRegister4Float RY{ VectorSubtract(SY, AY) };
+		const VectorRegister4Float RZ{ VectorSubtract(SZ, AZ) };
+
+		const VectorRegister4Float B{ Dot3(D1X, D1Y, D1Z, D2X, D2Y, D2Z) };
+		const VectorRegister4Float C{ Dot3(D1X, D1Y, D1Z, RX, RY, RZ) };
+		const VectorRegister4Float E{ Dot3(D2X, D2Y, D2Z, D2X, D2Y, D2Z) };
+		const VectorRegister4Float F{ Dot3(D2X, D2Y, D2Z, RX, RY, RZ) };
+
+		// s for the infinite lines, 0 when they are parallel
+		const VectorRegister4Float Denom{ VectorSubtract(VectorMultiply(A1, E), VectorMultiply(B, B)) };
+		VectorRegister4Float S{ VectorDivide(VectorSubtract(VectorMultiply(B, F), VectorMultiply(C, E)), VectorMax(Denom, Epsilon)) };
+		S = Clamp01(VectorSelect(VectorCompareGT(Denom, Epsilon), S, Zero));
+
+		// Best t for that s, then best s for the clamped t. The second step gives the same s when t was not clamped
+		const VectorRegister4Float T{ Clamp01(VectorDivide(VectorMultiplyAdd(B, S, F), VectorMax(E, Epsilon))) };
+		S = Clamp01(VectorMultiply(VectorSubtract(VectorMultiply(B, T), C), InvA1));
+
+		const VectorRegister4Float DX{ VectorSubtract(VectorMultiplyAdd(D1X, S, RX), VectorMultiply(D2X, T)) };
+		const VectorRegister4Float DY{ VectorSubtract(VectorMultiplyAdd(D1Y, S, RY), VectorMultiply(D2Y, T)) };
+		const VectorRegister4Float DZ{ VectorSubtract(VectorMultiplyAdd(D1Z, S, RZ), VectorMultiply(D2Z, T)) };
+		const VectorRegister4Float DistSquared{ Dot3(DX, DY, DZ, DX, DY, DZ) };
+
+		const VectorRegister4Float CapsuleRadius{ VectorLoad(&Capsules.Radius[Index]) };
+		const VectorRegister4Float RadiusSquared{ VectorMultiply(CapsuleRadius, CapsuleRadius) };
+
+		const int32 HitMask{ VectorMaskBits(VectorCompareLE(DistSquared, RadiusSquared)) };
+		if (HitMask == 0) continue;
+
+		// Entry point: closest approach minus half the chord through the capsule
+		const VectorRegister4Float HalfChord{ VectorSqrt(VectorMax(VectorSubtract(RadiusSquared, DistSquared), Zero)) };
+		const VectorRegister4Float Entry{ VectorMax(VectorSubtract(VectorMultiply(S, LengthV), HalfChord), Zero) };
+
+		alignas(16) float Entries[4];
+		VectorStoreAligned(Entry, Entries);
+		for (int32 Lane = 0; Lane < 4; ++Lane)
+		{
+			if ((HitMask & (1 << Lane)) && Entries[Lane] < BestDistance)
+			{
+				BestDistance = Entries[Lane];
+				BestIndex = Index + Lane;
+			}
+		}
+	}
+
+	OutDistance = BestDistance;
+	return BestIndex;
+}
+
+int32 ShooterHitbox::RaycastCapsulesScalar(const FHitboxCapsuleSoA& Capsules, const FVector3f& Start, const FVector3f& Dir, float Length, float& OutDistance)
+{
+	const FVector ShotStart{ Start };
+	const FVector ShotEnd{ Start + Dir * Length };
+
+	int32 BestIndex{ INDEX_NONE };
+	float BestDistance{ TNumericLimits<float>::Max() };
+
+	for (int32 Index = 0; Index < Capsules.Num(); ++Index)
+	{
+		const FVector A{ Capsules.AX[Index], Capsules.AY[Index], Capsules.AZ[Index] };
+		const FVector B{ Capsules.BX[Index], Capsules.BY[Index], Capsules.BZ[Index] };
+
+		FVector OnShot, OnCapsule;
+		FMath::SegmentDistToSegmentSafe(ShotStart, ShotEnd, A, B, OnShot, OnCapsule);
+
+		const float DistSquared{ static_cast<float>(FVector::DistSquared(OnShot, OnCapsule)) };
+		const float RadiusSquared{ FMath::Square(Capsules.Radius[Index]) };
+		if (DistSquared > RadiusSquared) continue;
+
+		const float Entry{ FMath::Max(static_cast<float>(FVector::Dist(ShotStart, OnShot)) - FMath::Sqrt(RadiusSquared - DistSquared), 0.f) };
+		if (Entry < BestDistance)
+		{
+			BestDistance = Entry;
+			BestIndex = Index;
+		}
+	}
+
+	OutDistance = BestDistance;
+	return BestIndex;
+}
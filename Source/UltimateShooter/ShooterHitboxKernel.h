@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Hitbox capsules (segment + radius) in SoA layout so the kernel can load 4 capsules per vector register.
+ * Arrays are padded to a multiple of 4 with capsules that can never be hit.
+ */
+struct ULTIMATESHOOTER_API FHitboxCapsuleSoA
+{
+	TArray<float> AX, AY, AZ;
+	TArray<float> BX, BY, BZ;
+	TArray<float> Radius;
+
+	int32 Num() const { return NumCapsules; }
+
+	void Reset();
+	void Add(const FVector3f& A, const FVector3f& B, float InRadius);
+	void Set(int32 Index, const FVector3f& A, const FVector3f& B, float InRadius);
+	// Pads the arrays to a multiple of 4, call after the last Add
+	void Pad();
+
+private:
+	int32 NumCapsules{ 0 };
+};
+
+namespace ShooterHitbox
+{
+	/**
+	 * Nearest capsule hit by the segment Start + Dir * [0, Length], Dir must be normalized.
+	 * Returns the capsule index and the entry distance along the segment, INDEX_NONE when nothing is hit.
+	 */
+	ULTIMATESHOOTER_API int32 RaycastCapsules(const FHitboxCapsuleSoA& Capsules, const FVector3f& Start, const FVector3f& Dir, float Length, float& OutDistance);
+
+	// One capsule at a time, reference for the benchmark
+	ULTIMATESHOOTER_API int32 RaycastCapsulesScalar(const FHitboxCapsuleSoA& Capsules, const FVector3f& Start, const FVector3f& Dir, float Length, float& OutDistance);
+}
@@ -0,0 +1,400 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterHitboxSubsystem.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Async/ParallelFor.h"
+#include "ShooterHitboxComponent.h"
+#include "ShooterHitboxKernel.h"
+
+#include "UltimateShooter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Hitbox Trace"), STAT_HitboxTrace, STATGROUP_UltimateShooter);
+DECLARE_CYCLE_STAT(TEXT("Hitbox Update All"), STAT_HitboxUpdateAll, STATGROUP_UltimateShooter);
+DECLARE_CYCLE_STAT(TEXT("Hitbox BVH Build"), STAT_HitboxBVHBuild, STATGROUP_UltimateShooter);
+DECLARE_CYCLE_STAT(TEXT("Hitbox BVH Refit"), STAT_HitboxBVHRefit, STATGROUP_UltimateShooter);
+DECLARE_CYCLE_STAT(TEXT("Hitbox Resolve Shots"), STAT_HitboxResolveShots, STATGROUP_UltimateShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hitbox Shots Resolved"), STAT_HitboxShotsResolved, STATGROUP_UltimateShooter);
+
+static TAutoConsoleVariable<int32> CVarHitboxRebuildFrames(
+	TEXT("Shooter.Hitbox.RebuildFrames"),
+	30,
+	TEXT("Frames between full BVH rebuilds, the BVH is only refit in between (rebuilt anyway when characters come or go)"));
+
+static FAutoConsoleCommand GHitboxBenchCommand(
+	TEXT("Shooter.Hitbox.Bench"),
+	TEXT("Shooter.Hitbox.Bench [NumCharacters=64] [NumRays=100000] - times the vector hitbox kernel against the scalar one"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumCharacters{ Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 64 };
+		const int32 NumRays{ Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 100'000 };
+		UShooterHitboxSubsystem::RunBenchmark(FMath::Max(NumCharacters, 1), FMath::Max(NumRays, 1));
+	}));
+
+static FAutoConsoleCommand GHitboxBroadphaseBenchCommand(
+	TEXT("Shooter.Hitbox.BenchBVH"),
+	TEXT("Shooter.Hitbox.BenchBVH [NumRays=20000] - times the hitbox BVH against testing every character with 16, 64 and 256 characters"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumRays{ Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 20'000 };
+		UShooterHitboxSubsystem::RunBroadphaseBenchmark({ 16, 64, 256 }, FMath::Max(NumRays, 1));
+	}));
+
+namespace
+{
+	// Nearest hitbox found so far by a query
+	struct FHitboxCandidate
+	{
+		int32 Index{ INDEX_NONE };
+		FName Bone;
+		float Distance{ 0.f };
+	};
+
+	// Characters standing on a grid 300 units apart, with a layout close to the default hitboxes
+	void MakeBenchCharacters(int32 NumCharacters, TArray<FHitboxCapsuleSoA>& OutCharacters, TArray<FBox>& OutBounds)
+	{
+		const int32 GridSize{ FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumCharacters))) };
+
+		OutCharacters.SetNum(NumCharacters);
+		OutBounds.SetNum(NumCharacters);
+		for (int32 Index = 0; Index < NumCharacters; ++Index)
+		{
+			const FVector3f Base{ (Index % GridSize) * 300.f, (Index / GridSize) * 300.f, 0.f };
+			FHitboxCapsuleSoA& Capsules = OutCharacters[Index];
+			Capsules.Reset();
+			Capsules.Add(Base + FVector3f(0.f, 0.f, 160.f), Base + FVector3f(0.f, 0.f, 160.f), 12.f);
+			Capsules.Add(Base + FVector3f(0.f, 0.f, 130.f), Base + FVector3f(0.f, 0.f, 145.f), 16.f);
+			Capsules.Add(Base + FVector3f(0.f, 0.f, 100.f), Base + FVector3f(0.f, 0.f, 130.f), 18.f);
+			Capsules.Add(Base + FVector3f(0.f, 0.f, 90.f), Base + FVector3f(0.f, 0.f, 100.f), 16.f);
+			for (const float Side : { -1.f, 1.f })
+			{
+				Capsules.Add(Base + FVector3f(0.f, Side * 20.f, 140.f), Base + FVector3f(0.f, Side * 45.f, 120.f), 7.f);
+				Capsules.Add(Base + FVector3f(0.f, Side * 45.f, 120.f), Base + FVector3f(20.f, Side * 40.f, 100.f), 6.f);
+				Capsules.Add(Base + FVector3f(0.f, Side * 12.f, 90.f), Base + FVector3f(0.f, Side * 14.f, 50.f), 10.f);
+				Capsules.Add(Base + FVector3f(0.f, Side * 14.f, 50.f), Base + FVector3f(0.f, Side * 15.f, 10.f), 8.f);
+			}
+			Capsules.Pad();
+
+			OutBounds[Index] = FBox(FVector(Base) - FVector(60.f, 60.f, 0.f), FVector(Base) + FVector(60.f, 60.f, 180.f));
+		}
+	}
+
+	struct FBenchRay
+	{
+		FVector Start;
+		FVector Dir;
+		float Length;
+	};
+
+	// Rays from around the grid aimed near a random character
+	void MakeBenchRays(const TArray<FBox>& Bounds, int32 NumRays, TArray<FBenchRay>& OutRays)
+	{
+		FRandomStream Random{ 1337 };
+
+		FBox GridBounds{ ForceInit };
+		for (const FBox& Box : Bounds) { GridBounds += Box; }
+		const FVector GridCenter{ GridBounds.GetCenter() };
+		const double Radius{ GridBounds.GetExtent().Size() + 1000.0 };
+
+		OutRays.SetNum(NumRays);
+		for (FBenchRay& Ray : OutRays)
+		{
+			Ray.Start = GridCenter + Random.GetUnitVector() * Radius;
+			const FVector Target{ Bounds[Random.RandHelper(Bounds.Num())].GetCenter() + Random.GetUnitVector() * 50.f };
+			Ray.Dir = (Target - Ray.Start).GetSafeNormal();
+			Ray.Length = 50'000.f;
+		}
+	}
+}
+
+bool UShooterHitboxSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+UShooterHitboxSubsystem* UShooterHitboxSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UShooterHitboxSubsystem>() : nullptr;
+}
+
+TStatId UShooterHitboxSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterHitboxSubsystem, STATGROUP_Tickables);
+}
+
+void UShooterHitboxSubsystem::Deinitialize()
+{
+	Hitboxes.Empty();
+	HitboxBounds.Empty();
+	BVH.Reset();
+	QueuedShots.Empty();
+
+	Super::Deinitialize();
+}
+
+void UShooterHitboxSubsystem::RegisterHitbox(UShooterHitboxComponent* Hitbox)
+{
+	if (Hitboxes.Contains(Hitbox)) return;
+
+	Hitboxes.Add(Hitbox);
+	HitboxBounds.Add(Hitbox->GetBounds());
+	bBVHDirty = true;
+}
+
+void UShooterHitboxSubsystem::UnregisterHitbox(UShooterHitboxComponent* Hitbox)
+{
+	const int32 Index{ Hitboxes.Find(Hitbox) };
+	if (Index == INDEX_NONE) return;
+
+	Hitboxes.RemoveAtSwap(Index);
+	HitboxBounds.RemoveAtSwap(Index);
+	bBVHDirty = true;
+}
+
+void UShooterHitboxSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// Tickable objects run after TG_PostPhysics, animation is done for this frame
+	UpdateHitboxes();
+	ResolveShots();
+}
+
+void UShooterHitboxSubsystem::UpdateHitboxes()
+{
+	{
+		SCOPE_CYCLE_COUNTER(STAT_HitboxUpdateAll);
+		// Each hitbox only reads its own mesh bones and writes its own capsules
+		ParallelFor(TEXT("Hitbox.Update"), Hitboxes.Num(), 8, [this](int32 Index)
+		{
+			Hitboxes[Index]->UpdateCapsules();
+			HitboxBounds[Index] = Hitboxes[Index]->GetBounds();
+		});
+	}
+
+	if (bBVHDirty || ++FramesSinceBuild >= CVarHitboxRebuildFrames.GetValueOnGameThread())
+	{
+		SCOPE_CYCLE_COUNTER(STAT_HitboxBVHBuild);
+		BVH.Build(HitboxBounds);
+		bBVHDirty = false;
+		FramesSinceBuild = 0;
+	}
+	else
+	{
+		SCOPE_CYCLE_COUNTER(STAT_HitboxBVHRefit);
+		BVH.Refit(HitboxBounds);
+	}
+}
+
+void UShooterHitboxSubsystem::QueueShot(const FVector& Start, const FVector& End, AActor* Instigator, float Damage)
+{
+	FShooterShotResult& Shot = QueuedShots.AddDefaulted_GetRef();
+	Shot.Instigator = Instigator;
+	Shot.Damage = Damage;
+	Shot.Start = Start;
+	Shot.End = End;
+}
+
+void UShooterHitboxSubsystem::ResolveShots()
+{
+	if (QueuedShots.Num() == 0) return;
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_HitboxResolveShots);
+		INC_DWORD_STAT_BY(STAT_HitboxShotsResolved, QueuedShots.Num());
+
+		// The BVH and the hitboxes are read only here
+		ParallelFor(TEXT("Hitbox.ResolveShots"), QueuedShots.Num(), 16, [this](int32 Index)
+		{
+			FShooterShotResult& Shot = QueuedShots[Index];
+			Shot.bHit = TraceHitboxesBroadphase(Shot.Start, Shot.End, Shot.Hit, Shot.Instigator);
+		});
+	}
+
+	// Listeners may queue new shots, they go to the next batch
+	TArray<FShooterShotResult> Results{ MoveTemp(QueuedShots) };
+	QueuedShots.Reset();
+	ShotsResolvedEvent.Broadcast(Results);
+}
+
+bool UShooterHitboxSubsystem::TraceHitboxes(const FVector& Start, const FVector& End, FShooterHitboxHit& OutHit, const AActor* IgnoreActor) const
+{
+	return TraceHitboxesBroadphase(Start, End, OutHit, IgnoreActor);
+}
+
+bool UShooterHitboxSubsystem::TraceHitboxesBroadphase(const FVector& Start, const FVector& End, FShooterHitboxHit& OutHit, const AActor* IgnoreActor) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_HitboxTrace);
+
+	FVector Dir;
+	float Length;
+	(End - Start).ToDirectionAndLength(Dir, Length);
+	if (Length <= UE_KINDA_SMALL_NUMBER) return false;
+
+	FHitboxCandidate Best;
+	auto TestHitbox = [&](int32 Index, float MaxDistance)
+	{
+		const UShooterHitboxComponent* Hitbox = Hitboxes[Index];
+		if (!Hitbox || Hitbox->GetOwner() == IgnoreActor) return MaxDistance;
+
+		FName Bone;
+		float Distance;
+		if (Hitbox->Raycast(Start, Dir, Length, Bone, Distance) && Distance < MaxDistance)
+		{
+			Best.Index = Index;
+			Best.Bone = Bone;
+			Best.Distance = Distance;
+			return Distance;
+		}
+		return MaxDistance;
+	};
+
+	if (bBVHDirty || BVH.NumItems() != Hitboxes.Num())
+	{
+		// Characters came or went since the last build, test them all
+		const FVector Extent{ End - Start };
+		float MaxDistance{ Length };
+		for (int32 Index = 0; Index < Hitboxes.Num(); ++Index)
+		{
+			if (FMath::LineBoxIntersection(HitboxBounds[Index], Start, End, Extent)) { MaxDistance = TestHitbox(Index, MaxDistance); }
+		}
+	}
+	else
+	{
+		BVH.Raycast(Start, Dir, Length, TestHitbox);
+	}
+
+	if (Best.Index == INDEX_NONE) return false;
+
+	OutHit.Actor = Hitboxes[Best.Index]->GetOwner();
+	OutHit.Bone = Best.Bone;
+	OutHit.Distance = Best.Distance;
+	OutHit.Location = Start + Dir * Best.Distance;
+	return true;
+}
+
+void UShooterHitboxSubsystem::RunBenchmark(int32 NumCharacters, int32 NumRays)
+{
+	TArray<FHitboxCapsuleSoA> Characters;
+	TArray<FBox> Bounds;
+	MakeBenchCharacters(NumCharacters, Characters, Bounds);
+
+	TArray<FBenchRay> Rays;
+	MakeBenchRays(Bounds, NumRays, Rays);
+
+	auto RunRays = [&](auto Kernel, TArray<int32>& OutHits)
+	{
+		OutHits.SetNumUninitialized(NumRays);
+		const double StartTime{ FPlatformTime::Seconds() };
+		for (int32 RayIndex = 0; RayIndex < NumRays; ++RayIndex)
+		{
+			const FBenchRay& Ray = Rays[RayIndex];
+			const FVector End{ Ray.Start + Ray.Dir * Ray.Length };
+			float BestDistance{ Ray.Length };
+			int32 BestCharacter{ INDEX_NONE };
+			for (int32 Index = 0; Index < NumCharacters; ++Index)
+			{
+				if (!FMath::LineBoxIntersection(Bounds[Index], Ray.Start, End, End - Ray.Start)) continue;
+
+				float Distance;
+				if (Kernel(Characters[Index], FVector3f(Ray.Start), FVector3f(Ray.Dir), Ray.Length, Distance) != INDEX_NONE && Distance < BestDistance)
+				{
+					BestDistance = Distance;
+					BestCharacter = Index;
+				}
+			}
+			OutHits[RayIndex] = BestCharacter;
+		}
+		return FPlatformTime::Seconds() - StartTime;
+	};
+
+	TArray<int32> VectorHits, ScalarHits;
+	const double VectorTime{ RunRays(&ShooterHitbox::RaycastCapsules, VectorHits) };
+	const double ScalarTime{ RunRays(&ShooterHitbox::RaycastCapsulesScalar, ScalarHits) };
+
+	int32 NumHits{ 0 };
+	int32 NumMismatches{ 0 };
+	for (int32 RayIndex = 0; RayIndex < NumRays; ++RayIndex)
+	{
+		NumHits += VectorHits[RayIndex] != INDEX_NONE;
+		NumMismatches += VectorHits[RayIndex] != ScalarHits[RayIndex];
+	}
+
+	UE_LOG(LogUltimateShooter, Log, TEXT("Hitbox bench: %d characters, %d capsules each, %d rays, %d hits, %d mismatches"),
+		NumCharacters, Characters[0].Num(), NumRays, NumHits, NumMismatches);
+	UE_LOG(LogUltimateShooter, Log, TEXT("  vector %.1f ns/ray, scalar %.1f ns/ray (x%.2f)"),
+		VectorTime * 1.e9 / NumRays, ScalarTime * 1.e9 / NumRays, VectorTime > 0.0 ? ScalarTime / VectorTime : 0.0);
+}
+
+void UShooterHitboxSubsystem::RunBroadphaseBenchmark(const TArray<int32>& CharacterCounts, int32 NumRays)
+{
+	for (const int32 NumCharacters : CharacterCounts)
+	{
+		TArray<FHitboxCapsuleSoA> Characters;
+		TArray<FBox> Bounds;
+		MakeBenchCharacters(NumCharacters, Characters, Bounds);
+
+		TArray<FBenchRay> Rays;
+		MakeBenchRays(Bounds, NumRays, Rays);
+
+		FShooterHitboxBVH BenchBVH;
+		double StartTime{ FPlatformTime::Seconds() };
+		BenchBVH.Build(Bounds);
+		const double BuildTime{ FPlatformTime::Seconds() - StartTime };
+
+		StartTime = FPlatformTime::Seconds();
+		BenchBVH.Refit(Bounds);
+		const double RefitTime{ FPlatformTime::Seconds() - StartTime };
+
+		auto TestCharacter = [&Characters](int32 Index, const FBenchRay& Ray, float MaxDistance, int32& BestCharacter)
+		{
+			float Distance;
+			if (ShooterHitbox::RaycastCapsules(Characters[Index], FVector3f(Ray.Start), FVector3f(Ray.Dir), Ray.Length, Distance) != INDEX_NONE && Distance < MaxDistance)
+			{
+				BestCharacter = Index;
+				return Distance;
+			}
+			return MaxDistance;
+		};
+
+		// Every character bounds tested, as TraceHitboxes did before the BVH
+		TArray<int32> BruteForceHits;
+		BruteForceHits.SetNumUninitialized(NumRays);
+		StartTime = FPlatformTime::Seconds();
+		for (int32 RayIndex = 0; RayIndex < NumRays; ++RayIndex)
+		{
+			const FBenchRay& Ray = Rays[RayIndex];
+			const FVector End{ Ray.Start + Ray.Dir * Ray.Length };
+			float MaxDistance{ Ray.Length };
+			int32 BestCharacter{ INDEX_NONE };
+			for (int32 Index = 0; Index < NumCharacters; ++Index)
+			{
+				if (FMath::LineBoxIntersection(Bounds[Index], Ray.Start, End, End - Ray.Start)) { MaxDistance = TestCharacter(Index, Ray, MaxDistance, BestCharacter); }
+			}
+			BruteForceHits[RayIndex] = BestCharacter;
+		}
+		const double BruteForceTime{ FPlatformTime::Seconds() - StartTime };
+
+		TArray<int32> BVHHits;
+		BVHHits.SetNumUninitialized(NumRays);
+		StartTime = FPlatformTime::Seconds();
+		for (int32 RayIndex = 0; RayIndex < NumRays; ++RayIndex)
+		{
+			const FBenchRay& Ray = Rays[RayIndex];
+			int32 BestCharacter{ INDEX_NONE };
+			BenchBVH.Raycast(Ray.Start, Ray.Dir, Ray.Length, [&](int32 Index, float MaxDistance) { return TestCharacter(Index, Ray, MaxDistance, BestCharacter); });
+			BVHHits[RayIndex] = BestCharacter;
+		}
+		const double BVHTime{ FPlatformTime::Seconds() - StartTime };
+
+		int32 NumMismatches{ 0 };
+		for (int32 RayIndex = 0; RayIndex < NumRays; ++RayIndex) { NumMismatches += BruteForceHits[RayIndex] != BVHHits[RayIndex]; }
+
+		UE_LOG(LogUltimateShooter, Log, TEXT("Hitbox BVH bench: %d characters, %d nodes, build %.3f ms, refit %.3f ms, %d mismatches"),
+			NumCharacters, BenchBVH.NumNodes(), BuildTime * 1000.0, RefitTime * 1000.0, NumMismatches);
+		UE_LOG(LogUltimateShooter, Log, TEXT("  all characters %.1f ns/ray, BVH %.1f ns/ray (x%.2f)"),
+			BruteForceTime * 1.e9 / NumRays, BVHTime * 1.e9 / NumRays, BVHTime > 0.0 ? BruteForceTime / BVHTime : 0.0);
+	}
+}
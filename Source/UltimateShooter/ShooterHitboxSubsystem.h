@@ -0,0 +1,113 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterHitboxBVH.h"
+#include "ShooterHitboxSubsystem.generated.h"
+
+USTRUCT(BlueprintType)
+struct FShooterHitboxHit
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	AActor* Actor{ nullptr };
+
+	UPROPERTY(BlueprintReadOnly)
+	FName Bone;
+
+	UPROPERTY(BlueprintReadOnly)
+	FVector Location{ ForceInit };
+
+	// Distance from the shot start
+	UPROPERTY(BlueprintReadOnly)
+	float Distance{ 0.f };
+};
+
+USTRUCT(BlueprintType)
+struct FShooterShotResult
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	AActor* Instigator{ nullptr };
+
+	UPROPERTY(BlueprintReadOnly)
+	FVector Start{ ForceInit };
+
+	UPROPERTY(BlueprintReadOnly)
+	FVector End{ ForceInit };
+
+	UPROPERTY(BlueprintReadOnly)
+	float Damage{ 0.f };
+
+	UPROPERTY(BlueprintReadOnly)
+	bool bHit{ false };
+
+	UPROPERTY(BlueprintReadOnly)
+	FShooterHitboxHit Hit;
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnShotsResolved, const TArray<FShooterShotResult>& /*Results*/);
+
+/**
+ * Hit registration against the hitbox capsules of every character, without going through the physics scene.
+ * After animation the hitboxes are updated and a BVH over their bounds is refit in parallel,
+ * then every shot queued during the frame is resolved against it in one batch.
+ */
+UCLASS()
+class ULTIMATESHOOTER_API UShooterHitboxSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	static UShooterHitboxSubsystem* Get(const UObject* WorldContextObject);
+
+	void RegisterHitbox(class UShooterHitboxComponent* Hitbox);
+	void UnregisterHitbox(class UShooterHitboxComponent* Hitbox);
+
+	// Nearest hitbox between Start and End right now, against the last updated poses
+	bool TraceHitboxes(const FVector& Start, const FVector& End, FShooterHitboxHit& OutHit, const AActor* IgnoreActor = nullptr) const;
+
+	// Resolved with the other shots of the frame once the hitboxes follow this frame poses
+	void QueueShot(const FVector& Start, const FVector& End, AActor* Instigator, float Damage);
+
+	// Broadcast once per frame with every shot queued that frame
+	FOnShotsResolved& OnShotsResolved() { return ShotsResolvedEvent; }
+
+	// Rays against synthetic characters, vector kernel against the scalar one
+	static void RunBenchmark(int32 NumCharacters, int32 NumRays);
+	// Rays against synthetic characters, BVH against testing every character, for several character counts
+	static void RunBroadphaseBenchmark(const TArray<int32>& CharacterCounts, int32 NumRays);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	// Moves every hitbox to its bone transforms and refits or rebuilds the BVH
+	void UpdateHitboxes();
+	void ResolveShots();
+
+	bool TraceHitboxesBroadphase(const FVector& Start, const FVector& End, FShooterHitboxHit& OutHit, const AActor* IgnoreActor) const;
+
+private:
+	UPROPERTY(Transient)
+	TArray<class UShooterHitboxComponent*> Hitboxes;
+
+	// Bounds of Hitboxes, same order
+	TArray<FBox> HitboxBounds;
+
+	FShooterHitboxBVH BVH;
+	// Hitboxes were added or removed since the last build
+	bool bBVHDirty{ true };
+	int32 FramesSinceBuild{ 0 };
+
+	TArray<FShooterShotResult> QueuedShots;
+	FOnShotsResolved ShotsResolvedEvent;
+};
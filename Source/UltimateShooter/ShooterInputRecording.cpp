@@ -0,0 +1,143 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterInputRecording.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+
+#include "UltimateShooter.h"
+
+static constexpr uint32 InputRecordingMagic{ 0x52495353 };   // "SSIR"
+static constexpr uint16 InputRecordingVersion{ 1 };
+
+// Value axes stored for each value type, Boolean is stored as a 0/1 axis
+static int32 GetNumStoredAxes(EInputActionValueType ValueType)
+{
+	switch (ValueType)
+	{
+	case EInputActionValueType::Axis2D: return 2;
+	case EInputActionValueType::Axis3D: return 3;
+	default: return 1;
+	}
+}
+
+// Every element takes at least a byte, a larger count is a truncated or corrupt file
+static bool IsValidCount(const FArchive& Ar, int32 Num)
+{
+	return !Ar.IsError() && Num >= 0 && Num <= Ar.TotalSize() - Ar.Tell();
+}
+
+// Same layout as TArray operator<<, with the count checked before anything is allocated
+template <typename ElementType>
+static bool SerializeArray(FArchive& Ar, TArray<ElementType>& Array)
+{
+	int32 Num{ Array.Num() };
+	Ar << Num;
+	if (Ar.IsLoading())
+	{
+		if (!IsValidCount(Ar, Num))
+		{
+			Ar.SetError();
+			return false;
+		}
+		Array.SetNum(Num);
+	}
+	for (ElementType& Element : Array) { Ar << Element; }
+	return !Ar.IsError();
+}
+
+void FShooterInputRecording::Serialize(FArchive& Ar)
+{
+	uint32 Magic{ InputRecordingMagic };
+	uint16 Version{ InputRecordingVersion };
+	Ar << Magic << Version;
+	if (Magic != InputRecordingMagic || Version != InputRecordingVersion)
+	{
+		Ar.SetError();
+		return;
+	}
+
+	if (!SerializeArray(Ar, BindingNames) || !SerializeArray(Ar, FrameDeltas)) return;
+	if (Ar.IsLoading())
+	{
+		// Replayed as the fixed delta time
+		for (const float FrameDelta : FrameDeltas)
+		{
+			if (!FMath::IsFinite(FrameDelta) || FrameDelta <= 0.f)
+			{
+				Ar.SetError();
+				return;
+			}
+		}
+	}
+	Ar << StartLocation << StartRotation << StartControlRotation;
+
+	int32 NumEvents{ Events.Num() };
+	Ar << NumEvents;
+	if (Ar.IsLoading())
+	{
+		if (!IsValidCount(Ar, NumEvents))
+		{
+			Ar.SetError();
+			return;
+		}
+		Events.SetNum(NumEvents);
+	}
+
+	// Frames as deltas, most fit a byte once packed
+	uint32 LastFrame{ 0 };
+	for (FShooterInputEvent& Event : Events)
+	{
+		uint32 FrameDelta{ Event.Frame - LastFrame };
+		Ar.SerializeIntPacked(FrameDelta);
+		Event.Frame = LastFrame + FrameDelta;
+		LastFrame = Event.Frame;
+
+		uint8 ValueType{ static_cast<uint8>(Event.Value.GetValueType()) };
+		Ar << Event.Binding << ValueType;
+
+		FVector3f Axes{ Event.Value.Get<FVector>() };
+		for (int32 Axis = 0; Axis < GetNumStoredAxes(static_cast<EInputActionValueType>(ValueType)); ++Axis)
+		{
+			Ar << Axes[Axis];
+		}
+
+		if (Ar.IsLoading())
+		{
+			Event.Value = FInputActionValue(static_cast<EInputActionValueType>(ValueType), FVector{ Axes });
+		}
+		if (Ar.IsError()) return;
+	}
+}
+
+bool FShooterInputRecording::SaveToFile(const FString& Filename) const
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer{ Bytes };
+	// Saving only reads the fields
+	const_cast<FShooterInputRecording*>(this)->Serialize(Writer);
+
+	return !Writer.IsError() && FFileHelper::SaveArrayToFile(Bytes, *Filename);
+}
+
+bool FShooterInputRecording::LoadFromFile(const FString& Filename)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *Filename)) return false;
+
+	FMemoryReader Reader{ Bytes };
+	Serialize(Reader);
+	if (Reader.IsError())
+	{
+		UE_LOG(LogUltimateShooter, Warning, TEXT("%s is not an input recording of this version"), *Filename);
+		return false;
+	}
+	return true;
+}
+
+FString FShooterInputRecording::GetRecordingPath(const FString& Name)
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("InputRecordings"), Name + TEXT(".sirec"));
+}
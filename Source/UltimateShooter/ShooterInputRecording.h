@@ -0,0 +1,43 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "InputActionValue.h"
+
+// One triggered input binding of the recorded session
+struct FShooterInputEvent
+{
+	// Frame since the recording started
+	uint32 Frame{ 0 };
+	// Index into AShooterCharacter::InputBindings
+	uint8 Binding{ 0 };
+	FInputActionValue Value;
+};
+
+/**
+ * Input of a play session and the delta time of every recorded frame, replayed frame by frame as fixed steps.
+ * Stored as a small binary file: header, binding names, frame deltas, then events with only the value axes their type uses.
+ */
+struct FShooterInputRecording
+{
+	// Binding names at record time, a replay is refused if the binding table changed since
+	TArray<FName> BindingNames;
+	// Delta time of every recorded frame
+	TArray<float> FrameDeltas;
+	// Pawn and control rotation at the first frame
+	FVector StartLocation{ ForceInit };
+	FRotator StartRotation{ ForceInit };
+	FRotator StartControlRotation{ ForceInit };
+	// Sorted by frame
+	TArray<FShooterInputEvent> Events;
+
+	bool SaveToFile(const FString& Filename) const;
+	bool LoadFromFile(const FString& Filename);
+
+	// Saved/InputRecordings/<Name>.sirec
+	static FString GetRecordingPath(const FString& Name);
+
+private:
+	void Serialize(FArchive& Ar);
+};
@@ -0,0 +1,251 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterInputReplaySubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "ShooterCharacter.h"
+
+#include "UltimateShooter.h"
+
+static FAutoConsoleCommandWithWorldAndArgs GInputRecordCommand(
+	TEXT("Shooter.Input.Record"),
+	TEXT("Shooter.Input.Record <Name> - records the player input to Saved/InputRecordings/<Name>.sirec"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UShooterInputReplaySubsystem* InputReplay = UShooterInputReplaySubsystem::Get(World);
+		if (InputReplay && Args.Num() > 0) { InputReplay->StartRecording(Args[0]); }
+	}));
+
+static FAutoConsoleCommandWithWorld GInputStopRecordingCommand(
+	TEXT("Shooter.Input.StopRecording"),
+	TEXT("Stops and saves the input recording"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UShooterInputReplaySubsystem* InputReplay = UShooterInputReplaySubsystem::Get(World)) { InputReplay->StopRecording(); }
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GInputReplayCommand(
+	TEXT("Shooter.Input.Replay"),
+	TEXT("Shooter.Input.Replay <Name> - replays Saved/InputRecordings/<Name>.sirec into the player character"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UShooterInputReplaySubsystem* InputReplay = UShooterInputReplaySubsystem::Get(World);
+		if (InputReplay && Args.Num() > 0) { InputReplay->StartReplay(Args[0]); }
+	}));
+
+static FAutoConsoleCommandWithWorld GInputStopReplayCommand(
+	TEXT("Shooter.Input.StopReplay"),
+	TEXT("Stops the input replay"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UShooterInputReplaySubsystem* InputReplay = UShooterInputReplaySubsystem::Get(World)) { InputReplay->StopReplay(); }
+	}));
+
+bool UShooterInputReplaySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+UShooterInputReplaySubsystem* UShooterInputReplaySubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UShooterInputReplaySubsystem>() : nullptr;
+}
+
+void UShooterInputReplaySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	TickStartHandle = FWorldDelegates::OnWorldTickStart.AddUObject(this, &UShooterInputReplaySubsystem::OnWorldTickStart);
+}
+
+void UShooterInputReplaySubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	FString ReplayName;
+	if (FParse::Value(FCommandLine::Get(), TEXT("ShooterReplay="), ReplayName))
+	{
+		StartReplay(ReplayName, true);
+	}
+}
+
+void UShooterInputReplaySubsystem::Deinitialize()
+{
+	StopRecording();
+	StopReplay();
+	FWorldDelegates::OnWorldTickStart.Remove(TickStartHandle);
+
+	Super::Deinitialize();
+}
+
+AShooterCharacter* UShooterInputReplaySubsystem::GetPlayerCharacter() const
+{
+	const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	return PlayerController ? Cast<AShooterCharacter>(PlayerController->GetPawn()) : nullptr;
+}
+
+bool UShooterInputReplaySubsystem::StartRecording(const FString& Name)
+{
+	if (Mode != EReplayMode::Idle) return false;
+
+	const AShooterCharacter* Character = GetPlayerCharacter();
+	if (!Character) return false;
+
+	Recording = FShooterInputRecording{};
+	Recording.BindingNames = AShooterCharacter::GetInputBindingNames();
+	Recording.StartLocation = Character->GetActorLocation();
+	Recording.StartRotation = Character->GetActorRotation();
+	Recording.StartControlRotation = Character->GetControlRotation();
+
+	RecordingName = Name;
+	Frame = 0;
+	Mode = EReplayMode::Recording;
+
+	UE_LOG(LogUltimateShooter, Log, TEXT("Recording input to %s"), *FShooterInputRecording::GetRecordingPath(Name));
+	return true;
+}
+
+void UShooterInputReplaySubsystem::StopRecording()
+{
+	if (Mode != EReplayMode::Recording) return;
+	Mode = EReplayMode::Idle;
+
+	const FString Path{ FShooterInputRecording::GetRecordingPath(RecordingName) };
+	const bool bSaved{ Recording.SaveToFile(Path) };
+	UE_LOG(LogUltimateShooter, Log, TEXT("Input recording %s: %d frames, %d events%s"),
+		*Path, Recording.FrameDeltas.Num(), Recording.Events.Num(), bSaved ? TEXT("") : TEXT(", save failed"));
+}
+
+void UShooterInputReplaySubsystem::RecordInput(int32 Binding, const FInputActionValue& Value)
+{
+	if (Mode != EReplayMode::Recording) return;
+
+	FShooterInputEvent& Event = Recording.Events.AddDefaulted_GetRef();
+	Event.Frame = Frame;
+	Event.Binding = static_cast<uint8>(Binding);
+	Event.Value = Value;
+}
+
+bool UShooterInputReplaySubsystem::StartReplay(const FString& Name, bool bInQuitWhenDone)
+{
+	if (Mode != EReplayMode::Idle) return false;
+
+	const FString Path{ FShooterInputRecording::GetRecordingPath(Name) };
+	if (!Recording.LoadFromFile(Path) || Recording.FrameDeltas.Num() == 0)
+	{
+		UE_LOG(LogUltimateShooter, Warning, TEXT("No input recording at %s"), *Path);
+		return false;
+	}
+	if (Recording.BindingNames != AShooterCharacter::GetInputBindingNames())
+	{
+		UE_LOG(LogUltimateShooter, Warning, TEXT("%s was recorded with other input bindings"), *Path);
+		return false;
+	}
+
+	RecordingName = Name;
+	bQuitWhenDone = bInQuitWhenDone;
+	Frame = 0;
+	NextEvent = 0;
+	FrameTimesMs.Reset(Recording.FrameDeltas.Num());
+	LastFrameStartTime = 0.0;
+
+	// Next frame already runs at the recorded first delta
+	bWasFixedTimeStep = FApp::UseFixedTimeStep();
+	PreviousFixedDeltaTime = FApp::GetFixedDeltaTime();
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(Recording.FrameDeltas[0]);
+
+	Mode = EReplayMode::Replaying;
+	UE_LOG(LogUltimateShooter, Log, TEXT("Replaying %s: %d frames, %d events"), *Path, Recording.FrameDeltas.Num(), Recording.Events.Num());
+	return true;
+}
+
+void UShooterInputReplaySubsystem::StopReplay()
+{
+	if (Mode != EReplayMode::Replaying) return;
+	Mode = EReplayMode::Idle;
+
+	FApp::SetUseFixedTimeStep(bWasFixedTimeStep);
+	FApp::SetFixedDeltaTime(PreviousFixedDeltaTime);
+
+	ReportReplay();
+
+	if (bQuitWhenDone) { FPlatformMisc::RequestExit(false); }
+}
+
+void UShooterInputReplaySubsystem::OnWorldTickStart(UWorld* TickedWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (TickedWorld != GetWorld()) return;
+
+	if (Mode == EReplayMode::Recording)
+	{
+		// Input handled later this frame belongs to it
+		Frame = Recording.FrameDeltas.Num();
+		Recording.FrameDeltas.Add(DeltaSeconds);
+	}
+	else if (Mode == EReplayMode::Replaying)
+	{
+		ReplayFrame();
+	}
+}
+
+void UShooterInputReplaySubsystem::ReplayFrame()
+{
+	const double Now{ FPlatformTime::Seconds() };
+	if (LastFrameStartTime > 0.0) { FrameTimesMs.Add(static_cast<float>((Now - LastFrameStartTime) * 1000.0)); }
+	LastFrameStartTime = Now;
+
+	if (Frame >= static_cast<uint32>(Recording.FrameDeltas.Num()))
+	{
+		StopReplay();
+		return;
+	}
+
+	AShooterCharacter* Character = GetPlayerCharacter();
+	if (Character && Frame == 0)
+	{
+		Character->SetActorLocationAndRotation(Recording.StartLocation, Recording.StartRotation, false, nullptr, ETeleportType::ResetPhysics);
+		if (AController* Controller = Character->GetController()) { Controller->SetControlRotation(Recording.StartControlRotation); }
+	}
+
+	for (; NextEvent < Recording.Events.Num() && Recording.Events[NextEvent].Frame == Frame; ++NextEvent)
+	{
+		const FShooterInputEvent& Event = Recording.Events[NextEvent];
+		if (Character) { Character->HandleInput(Event.Binding, Event.Value); }
+	}
+
+	// Step of the next frame
+	++Frame;
+	if (Frame < static_cast<uint32>(Recording.FrameDeltas.Num())) { FApp::SetFixedDeltaTime(Recording.FrameDeltas[Frame]); }
+}
+
+void UShooterInputReplaySubsystem::ReportReplay() const
+{
+	if (FrameTimesMs.Num() == 0) return;
+
+	TArray<float> Sorted{ FrameTimesMs };
+	Sorted.Sort();
+	double TotalMs{ 0.0 };
+	for (const float FrameMs : FrameTimesMs) { TotalMs += FrameMs; }
+
+	UE_LOG(LogUltimateShooter, Log, TEXT("Replay %s: %d frames, avg %.2f ms, median %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms"),
+		*RecordingName, FrameTimesMs.Num(), TotalMs / FrameTimesMs.Num(), Sorted[Sorted.Num() / 2],
+		Sorted[FMath::Min(Sorted.Num() * 95 / 100, Sorted.Num() - 1)], Sorted[FMath::Min(Sorted.Num() * 99 / 100, Sorted.Num() - 1)], Sorted.Last());
+
+	// One line per frame, diff two builds frame by frame
+	FString Csv{ TEXT("Frame,FrameMs\n") };
+	for (int32 Index = 0; Index < FrameTimesMs.Num(); ++Index)
+	{
+		Csv += FString::Printf(TEXT("%d,%.3f\n"), Index, FrameTimesMs[Index]);
+	}
+	const FString CsvPath{ FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("InputRecordings"),
+		FString::Printf(TEXT("%s_%s.csv"), *RecordingName, *FDateTime::Now().ToString())) };
+	FFileHelper::SaveStringToFile(Csv, *CsvPath);
+}
@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterInputRecording.h"
+#include "ShooterInputReplaySubsystem.generated.h"
+
+class AShooterCharacter;
+
+/**
+ * Records the player input bindings with the frame they fired on, and replays a recording into the player character.
+ * A replay runs with a fixed timestep set to the recorded delta of every frame, so each build simulates the same frames
+ * from the same input and frame times can be compared one to one. Start with -ShooterReplay=<Name> for a headless run
+ * (-nullrhi -nosound), the game exits when the replay ends.
+ */
+UCLASS()
+class ULTIMATESHOOTER_API UShooterInputReplaySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	static UShooterInputReplaySubsystem* Get(const UObject* WorldContextObject);
+
+	bool StartRecording(const FString& Name);
+	void StopRecording();
+
+	bool StartReplay(const FString& Name, bool bInQuitWhenDone = false);
+	void StopReplay();
+
+	bool IsRecording() const { return Mode == EReplayMode::Recording; }
+	bool IsReplaying() const { return Mode == EReplayMode::Replaying; }
+
+	// Called by the player character for every live input binding it handles
+	void RecordInput(int32 Binding, const FInputActionValue& Value);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	// Before any tick group of the frame, so replayed input is handled where live input would be
+	void OnWorldTickStart(UWorld* TickedWorld, ELevelTick TickType, float DeltaSeconds);
+	void ReplayFrame();
+
+	// Frame time summary and a per frame CSV next to the recording
+	void ReportReplay() const;
+
+	AShooterCharacter* GetPlayerCharacter() const;
+
+private:
+	enum class EReplayMode : uint8
+	{
+		Idle,
+		Recording,
+		Replaying
+	};
+	EReplayMode Mode{ EReplayMode::Idle };
+
+	FShooterInputRecording Recording;
+	FString RecordingName;
+
+	// Frame of the recording being recorded or replayed
+	uint32 Frame{ 0 };
+	int32 NextEvent{ 0 };
+	bool bQuitWhenDone{ false };
+
+	// Engine timestep before the replay
+	bool bWasFixedTimeStep{ false };
+	double PreviousFixedDeltaTime{ 0.0 };
+
+	// Wall time of every replayed frame
+	TArray<float> FrameTimesMs;
+	double LastFrameStartTime{ 0.0 };
+
+	FDelegateHandle TickStartHandle;
+};
@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterOverlayWidget.h"
+#include "Components/InvalidationBox.h"
+
+#include "ShooterHUDViewModel.h"
+
+void UShooterOverlayWidget::NativeConstruct()
+{
+	Super::NativeConstruct();
+
+	// Only invalidated when a child changes
+	if (StaticHUDBox) { StaticHUDBox->SetCanCache(true); }
+}
+
+void UShooterOverlayWidget::NativeDestruct()
+{
+	SetViewModel(nullptr);
+
+	Super::NativeDestruct();
+}
+
+void UShooterOverlayWidget::SetViewModel(UShooterHUDViewModel* InViewModel)
+{
+	if (ViewModel == InViewModel) return;
+
+	if (ViewModel)
+	{
+		ViewModel->OnAmmoChanged.RemoveDynamic(this, &UShooterOverlayWidget::HandleAmmoChanged);
+		ViewModel->OnCombatStateChanged.RemoveDynamic(this, &UShooterOverlayWidget::HandleCombatStateChanged);
+		ViewModel->OnWeaponChanged.RemoveDynamic(this, &UShooterOverlayWidget::HandleWeaponChanged);
+	}
+
+	ViewModel = InViewModel;
+	if (!ViewModel) return;
+
+	ViewModel->OnAmmoChanged.AddDynamic(this, &UShooterOverlayWidget::HandleAmmoChanged);
+	ViewModel->OnCombatStateChanged.AddDynamic(this, &UShooterOverlayWidget::HandleCombatStateChanged);
+	ViewModel->OnWeaponChanged.AddDynamic(this, &UShooterOverlayWidget::HandleWeaponChanged);
+
+	// Initial values
+	HandleWeaponChanged(ViewModel->GetWeapon());
+	HandleAmmoChanged(ViewModel->GetMagazineAmmo(), ViewModel->GetCarriedAmmo());
+	HandleCombatStateChanged(ViewModel->GetCombatState());
+}
+
+void UShooterOverlayWidget::HandleAmmoChanged(int32 MagazineAmmo, int32 CarriedAmmo)
+{
+	OnAmmoChanged(MagazineAmmo, CarriedAmmo);
+}
+
+void UShooterOverlayWidget::HandleCombatStateChanged(ECombatState CombatState)
+{
+	OnCombatStateChanged(CombatState);
+}
+
+void UShooterOverlayWidget::HandleWeaponChanged(AWeapon* Weapon)
+{
+	OnWeaponChanged(Weapon);
+}
@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "ShooterCharacter.h"
+#include "ShooterOverlayWidget.generated.h"
+
+/**
+ * Base class for the HUD overlay. Listens to the character's HUD view model instead of polling it with bindings.
+ */
+UCLASS()
+class ULTIMATESHOOTER_API UShooterOverlayWidget : public UUserWidget
+{
+	GENERATED_BODY()
+
+public:
+	// Starts listening to ViewModel, stops listening to the previous one
+	void SetViewModel(class UShooterHUDViewModel* InViewModel);
+
+protected:
+	virtual void NativeConstruct() override;
+	virtual void NativeDestruct() override;
+
+	// Implemented in Blueprint to update the ammo texts
+	UFUNCTION(BlueprintImplementableEvent, Category = HUD)
+	void OnAmmoChanged(int32 MagazineAmmo, int32 CarriedAmmo);
+	// Implemented in Blueprint to update the combat state (reloading...)
+	UFUNCTION(BlueprintImplementableEvent, Category = HUD)
+	void OnCombatStateChanged(ECombatState CombatState);
+	// Implemented in Blueprint to update the weapon icon and name
+	UFUNCTION(BlueprintImplementableEvent, Category = HUD)
+	void OnWeaponChanged(class AWeapon* Weapon);
+
+private:
+	UFUNCTION()
+	void HandleAmmoChanged(int32 MagazineAmmo, int32 CarriedAmmo);
+	UFUNCTION()
+	void HandleCombatStateChanged(ECombatState CombatState);
+	UFUNCTION()
+	void HandleWeaponChanged(class AWeapon* Weapon);
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = HUD, meta = (AllowPrivateAccess = "true"))
+	class UShooterHUDViewModel* ViewModel;
+
+	// Wraps the HUD parts that only change on events so Slate can cache them
+	UPROPERTY(BlueprintReadOnly, Category = HUD, meta = (BindWidgetOptional, AllowPrivateAccess = "true"))
+	class UInvalidationBox* StaticHUDBox;
+};
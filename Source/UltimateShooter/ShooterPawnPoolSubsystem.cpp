@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterPawnPoolSubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/Controller.h"
+#include "ShooterCharacter.h"
+
+#include "UltimateShooter.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pawn Pool Free"), STAT_PawnPoolFree, STATGROUP_UltimateShooter);
+
+bool UShooterPawnPoolSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+UShooterPawnPoolSubsystem* UShooterPawnPoolSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UShooterPawnPoolSubsystem>() : nullptr;
+}
+
+void UShooterPawnPoolSubsystem::Deinitialize()
+{
+	FreeCharacters.Empty();
+
+	Super::Deinitialize();
+}
+
+int32 UShooterPawnPoolSubsystem::Prewarm(TSubclassOf<AShooterCharacter> Class, int32 Count)
+{
+	int32 NumSpawned{ 0 };
+	for (int32 i = 0; i < Count; ++i)
+	{
+		AShooterCharacter* Character = SpawnCharacter(Class);
+		if (!Character) break;
+
+		FreeCharacters.Add(Character);
+		++NumSpawned;
+	}
+
+	SET_DWORD_STAT(STAT_PawnPoolFree, FreeCharacters.Num());
+	return NumSpawned;
+}
+
+AShooterCharacter* UShooterPawnPoolSubsystem::Acquire(TSubclassOf<AShooterCharacter> Class, TSubclassOf<AController> ControllerClass, bool* bOutReused)
+{
+	if (!Class) return nullptr;
+
+	AShooterCharacter* Character{ nullptr };
+	const int32 FreeIndex{ FreeCharacters.FindLastByPredicate([&Class](const AShooterCharacter* Free) { return Free && Free->GetClass() == Class; }) };
+	if (FreeIndex != INDEX_NONE)
+	{
+		Character = FreeCharacters[FreeIndex];
+		FreeCharacters.RemoveAtSwap(FreeIndex, 1, false);
+	}
+	else
+	{
+		Character = SpawnCharacter(Class);
+		if (!Character) return nullptr;
+	}
+	if (bOutReused) { *bOutReused = FreeIndex != INDEX_NONE; }
+
+	// The last user may have wanted another brain
+	if (!ControllerClass) { ControllerClass = Class->GetDefaultObject<AShooterCharacter>()->AIControllerClass; }
+	AController* CurrentController = Character->GetController();
+	if (ControllerClass && (!CurrentController || !CurrentController->IsA(ControllerClass)))
+	{
+		if (CurrentController)
+		{
+			CurrentController->UnPossess();
+			CurrentController->Destroy();
+		}
+		Character->AIControllerClass = ControllerClass;
+		Character->SpawnDefaultController();
+	}
+
+	SET_DWORD_STAT(STAT_PawnPoolFree, FreeCharacters.Num());
+	return Character;
+}
+
+void UShooterPawnPoolSubsystem::Release(AShooterCharacter* Character)
+{
+	if (!Character || FreeCharacters.Contains(Character)) return;
+
+	if (AController* Controller = Character->GetController()) { Controller->StopMovement(); }
+
+	Character->SetPooled(true);
+	Character->SetActorLocation(PoolLocation, false, nullptr, ETeleportType::ResetPhysics);
+	FreeCharacters.Add(Character);
+	SET_DWORD_STAT(STAT_PawnPoolFree, FreeCharacters.Num());
+}
+
+int32 UShooterPawnPoolSubsystem::GetNumFree(TSubclassOf<AShooterCharacter> Class) const
+{
+	if (!Class) return FreeCharacters.Num();
+
+	int32 NumFree{ 0 };
+	for (const AShooterCharacter* Character : FreeCharacters)
+	{
+		if (Character && Character->GetClass() == Class) { ++NumFree; }
+	}
+	return NumFree;
+}
+
+AShooterCharacter* UShooterPawnPoolSubsystem::SpawnCharacter(TSubclassOf<AShooterCharacter> Class)
+{
+	if (!Class) return nullptr;
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	AShooterCharacter* Character{ GetWorld()->SpawnActor<AShooterCharacter>(Class, PoolLocation, FRotator::ZeroRotator, SpawnParams) };
+	if (Character)
+	{
+		if (!Character->GetController()) { Character->SpawnDefaultController(); }
+		Character->SetPooled(true);
+	}
+	return Character;
+}
@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterPawnPoolSubsystem.generated.h"
+
+class AShooterCharacter;
+
+/**
+ * Characters spawned ahead of time and reused, shared by the wave game mode and the crowd promotions.
+ * Free characters are parked at PoolLocation with rendering, collision and ticks off (AShooterCharacter::SetPooled),
+ * whoever acquires one resets it, moves it in place and unparks it.
+ */
+UCLASS(Config = Game)
+class ULTIMATESHOOTER_API UShooterPawnPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	static UShooterPawnPoolSubsystem* Get(const UObject* WorldContextObject);
+
+	// Spawns Count parked characters of Class, returns the number spawned
+	int32 Prewarm(TSubclassOf<AShooterCharacter> Class, int32 Count);
+
+	// A free character of Class, a new one when there is none (bOutReused false). Possessed by ControllerClass,
+	// the AIControllerClass of Class when null. Still parked.
+	AShooterCharacter* Acquire(TSubclassOf<AShooterCharacter> Class, TSubclassOf<AController> ControllerClass = nullptr, bool* bOutReused = nullptr);
+	void Release(AShooterCharacter* Character);
+
+	// Free characters of Class, of every class when null
+	int32 GetNumFree(TSubclassOf<AShooterCharacter> Class = nullptr) const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	AShooterCharacter* SpawnCharacter(TSubclassOf<AShooterCharacter> Class);
+
+private:
+	UPROPERTY(Transient)
+	TArray<AShooterCharacter*> FreeCharacters;
+
+	// Where free characters are parked
+	UPROPERTY(Config)
+	FVector PoolLocation{ 0.f, 0.f, -10000.f };
+};
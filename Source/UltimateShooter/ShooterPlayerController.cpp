@@ -4,6 +4,9 @@
 #include "ShooterPlayerController.h"
 #include "Blueprint/UserWidget.h"
 
+#include "ShooterCharacter.h"
+#include "ShooterOverlayWidget.h"
+
 AShooterPlayerController::AShooterPlayerController()
 {
 
@@ -20,5 +23,22 @@ void AShooterPlayerController::BeginPlay()
 	if (!OverlayHUD) return;	
 	OverlayHUD->AddToViewport();
 	OverlayHUD->SetVisibility(ESlateVisibility::Visible);
-	
+
+	BindHUDViewModel(GetPawn());
+}
+
+void AShooterPlayerController::OnPossess(APawn* InPawn)
+{
+	Super::OnPossess(InPawn);
+
+	BindHUDViewModel(InPawn);
+}
+
+void AShooterPlayerController::BindHUDViewModel(APawn* InPawn)
+{
+	UShooterOverlayWidget* OverlayWidget = Cast<UShooterOverlayWidget>(OverlayHUD);
+	if (!OverlayWidget) return;
+
+	const AShooterCharacter* ShooterCharacter = Cast<AShooterCharacter>(InPawn);
+	OverlayWidget->SetViewModel(ShooterCharacter ? ShooterCharacter->GetHUDViewModel() : nullptr);
 }
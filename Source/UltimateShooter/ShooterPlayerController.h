@@ -22,6 +22,11 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	virtual void OnPossess(APawn* InPawn) override;
+
+	// Feeds the possessed character's HUD view model to the overlay
+	void BindHUDViewModel(APawn* InPawn);
+
 private:
 	// Reference to the Overall HUD Overlay
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Widgets, meta = (AllowPrivateAccess = "true"))
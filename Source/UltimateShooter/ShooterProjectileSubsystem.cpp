@@ -0,0 +1,305 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterProjectileSubsystem.h"
+#include "Engine/World.h"
+#include "Engine/StaticMesh.h"
+#include "GameFramework/PlayerController.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Async/ParallelFor.h"
+#include "Math/VectorRegister.h"
+#include "ShooterShotSubsystem.h"
+#include "ShooterHitboxSubsystem.h"
+#include "ShooterEffectsSubsystem.h"
+
+#include "UltimateShooter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Projectiles Integrate"), STAT_ProjectilesIntegrate, STATGROUP_UltimateShooter);
+DECLARE_CYCLE_STAT(TEXT("Projectiles Sweep"), STAT_ProjectilesSweep, STATGROUP_UltimateShooter);
+DECLARE_CYCLE_STAT(TEXT("Projectiles Resolve"), STAT_ProjectilesResolve, STATGROUP_UltimateShooter);
+DECLARE_CYCLE_STAT(TEXT("Projectiles Tracers"), STAT_ProjectilesTracers, STATGROUP_UltimateShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectiles Live"), STAT_ProjectilesLive, STATGROUP_UltimateShooter);
+
+static FAutoConsoleCommandWithWorldAndArgs GProjectileStressCommand(
+	TEXT("Shooter.Projectiles.Stress"),
+	TEXT("Shooter.Projectiles.Stress [Count=10000] - launches projectiles in every direction from the player"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UShooterProjectileSubsystem* Projectiles = UShooterProjectileSubsystem::Get(World);
+		if (!Projectiles) return;
+
+		const APlayerController* PlayerController = World->GetFirstPlayerController();
+		const APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+		const FVector Origin{ Pawn ? Pawn->GetActorLocation() + FVector(0.f, 0.f, 200.f) : FVector::ZeroVector };
+
+		const int32 Count{ Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10'000 };
+		FRandomStream Random{ 1337 };
+		int32 NumLaunched{ 0 };
+		for (int32 Index = 0; Index < Count; ++Index)
+		{
+			FVector Dir{ Random.GetUnitVector() };
+			Dir.Z = FMath::Abs(Dir.Z);
+			NumLaunched += Projectiles->LaunchProjectile(nullptr, Origin, Dir * 5'000.f, 1.f, 5.f, 0.f, nullptr);
+		}
+
+		UE_LOG(LogUltimateShooter, Log, TEXT("Launched %d/%d projectiles, %d live (max %d)"),
+			NumLaunched, Count, Projectiles->GetNumProjectiles(), Projectiles->GetMaxProjectiles());
+	}));
+
+bool UShooterProjectileSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+UShooterProjectileSubsystem* UShooterProjectileSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UShooterProjectileSubsystem>() : nullptr;
+}
+
+TStatId UShooterProjectileSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterProjectileSubsystem, STATGROUP_Tickables);
+}
+
+void UShooterProjectileSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	for (TArray<float>* Array : { &PosX, &PosY, &PosZ, &PrevX, &PrevY, &PrevZ, &VelX, &VelY, &VelZ, &GravityScales, &Ages, &Lifetimes, &Damages })
+	{
+		Array->Reserve(MaxProjectiles);
+	}
+
+	UStaticMesh* Mesh = TracerMesh.LoadSynchronous();
+	if (!Mesh) return;
+
+	// One transient actor owns the tracer instances of the whole world
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.ObjectFlags |= RF_Transient;
+	AActor* TracerActor = InWorld.SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParameters);
+	if (!TracerActor) return;
+
+	TracerInstances = NewObject<UInstancedStaticMeshComponent>(TracerActor, TEXT("ProjectileTracers"));
+	TracerInstances->SetMobility(EComponentMobility::Movable);
+	TracerInstances->SetStaticMesh(Mesh);
+	TracerInstances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	TracerInstances->SetCastShadow(false);
+	TracerActor->SetRootComponent(TracerInstances);
+	TracerInstances->RegisterComponent();
+}
+
+void UShooterProjectileSubsystem::Deinitialize()
+{
+	if (TracerInstances && TracerInstances->GetOwner()) { TracerInstances->GetOwner()->Destroy(); }
+	TracerInstances = nullptr;
+
+	Super::Deinitialize();
+}
+
+bool UShooterProjectileSubsystem::LaunchProjectile(AActor* Instigator, const FVector& Location, const FVector& Velocity, float GravityScale, float Lifetime,
+	float Damage, UParticleSystem* ImpactParticles)
+{
+	if (NumProjectiles >= MaxProjectiles)
+	{
+		++NumRejected;
+		return false;
+	}
+
+	PosX.Add(Location.X); PosY.Add(Location.Y); PosZ.Add(Location.Z);
+	PrevX.Add(Location.X); PrevY.Add(Location.Y); PrevZ.Add(Location.Z);
+	VelX.Add(Velocity.X); VelY.Add(Velocity.Y); VelZ.Add(Velocity.Z);
+	GravityScales.Add(GravityScale);
+	Ages.Add(0.f);
+	Lifetimes.Add(Lifetime);
+	Damages.Add(Damage);
+	Instigators.Add(Instigator);
+	ImpactEffects.Add(ImpactParticles);
+	Hits.AddDefaulted();
+	++NumProjectiles;
+	return true;
+}
+
+void UShooterProjectileSubsystem::RemoveProjectile(int32 Index)
+{
+	for (TArray<float>* Array : { &PosX, &PosY, &PosZ, &PrevX, &PrevY, &PrevZ, &VelX, &VelY, &VelZ, &GravityScales, &Ages, &Lifetimes, &Damages })
+	{
+		Array->RemoveAtSwap(Index, 1, false);
+	}
+	Instigators.RemoveAtSwap(Index, 1, false);
+	ImpactEffects.RemoveAtSwap(Index, 1, false);
+	Hits.RemoveAtSwap(Index, 1, false);
+	--NumProjectiles;
+}
+
+void UShooterProjectileSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (NumProjectiles > 0)
+	{
+		Integrate(DeltaTime);
+		Sweep();
+		ResolveHits();
+	}
+	UpdateTracers();
+
+	SET_DWORD_STAT(STAT_ProjectilesLive, NumProjectiles);
+}
+
+void UShooterProjectileSubsystem::Integrate(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ProjectilesIntegrate);
+
+	// Semi implicit Euler: drag and gravity on the velocity, then the new velocity moves the position
+	const float Drag{ FMath::Max(1.f - AirDrag * DeltaTime, 0.f) };
+	const float GravityStep{ GetWorld()->GetGravityZ() * DeltaTime };
+
+	const VectorRegister4Float DeltaTimeV{ VectorSetFloat1(DeltaTime) };
+	const VectorRegister4Float DragV{ VectorSetFloat1(Drag) };
+	const VectorRegister4Float GravityStepV{ VectorSetFloat1(GravityStep) };
+
+	int32 Index{ 0 };
+	for (; Index + 4 <= NumProjectiles; Index += 4)
+	{
+		const VectorRegister4Float VX{ VectorMultiply(VectorLoad(&VelX[Index]), DragV) };
+		const VectorRegister4Float VY{ VectorMultiply(VectorLoad(&VelY[Index]), DragV) };
+		const VectorRegister4Float VZ{ VectorMultiplyAdd(VectorLoad(&GravityScales[Index]), GravityStepV, VectorMultiply(VectorLoad(&VelZ[Index]), DragV)) };
+		VectorStore(VX, &VelX[Index]);
+		VectorStore(VY, &VelY[Index]);
+		VectorStore(VZ, &VelZ[Index]);
+
+		const VectorRegister4Float PX{ VectorLoad(&PosX[Index]) };
+		const VectorRegister4Float PY{ VectorLoad(&PosY[Index]) };
+		const VectorRegister4Float PZ{ VectorLoad(&PosZ[Index]) };
+		VectorStore(PX, &PrevX[Index]);
+		VectorStore(PY, &PrevY[Index]);
+		VectorStore(PZ, &PrevZ[Index]);
+		VectorStore(VectorMultiplyAdd(VX, DeltaTimeV, PX), &PosX[Index]);
+		VectorStore(VectorMultiplyAdd(VY, DeltaTimeV, PY), &PosY[Index]);
+		VectorStore(VectorMultiplyAdd(VZ, DeltaTimeV, PZ), &PosZ[Index]);
+
+		VectorStore(VectorAdd(VectorLoad(&Ages[Index]), DeltaTimeV), &Ages[Index]);
+	}
+
+	// Last projectiles that do not fill a vector
+	for (; Index < NumProjectiles; ++Index)
+	{
+		VelX[Index] *= Drag;
+		VelY[Index] *= Drag;
+		VelZ[Index] = VelZ[Index] * Drag + GravityScales[Index] * GravityStep;
+
+		PrevX[Index] = PosX[Index];
+		PrevY[Index] = PosY[Index];
+		PrevZ[Index] = PosZ[Index];
+		PosX[Index] += VelX[Index] * DeltaTime;
+		PosY[Index] += VelY[Index] * DeltaTime;
+		PosZ[Index] += VelZ[Index] * DeltaTime;
+
+		Ages[Index] += DeltaTime;
+	}
+}
+
+void UShooterProjectileSubsystem::Sweep()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ProjectilesSweep);
+
+	// Weak pointers are resolved here, workers only see raw pointers
+	TArray<const AActor*> IgnoredActors;
+	IgnoredActors.SetNumUninitialized(NumProjectiles);
+	for (int32 Index = 0; Index < NumProjectiles; ++Index) { IgnoredActors[Index] = Instigators[Index].Get(); }
+
+	const UWorld* World = GetWorld();
+	const UShooterHitboxSubsystem* Hitboxes = UShooterHitboxSubsystem::Get(this);
+
+	// Scene queries and the hitbox BVH are read only during the sweep
+	ParallelFor(TEXT("Projectiles.Sweep"), NumProjectiles, 64, [&](int32 Index)
+	{
+		const FVector Start{ PrevX[Index], PrevY[Index], PrevZ[Index] };
+		FVector End{ PosX[Index], PosY[Index], PosZ[Index] };
+		FProjectileHit& Hit = Hits[Index];
+		Hit = FProjectileHit();
+
+		const FCollisionQueryParams Params{ SCENE_QUERY_STAT(ShooterProjectile), false, IgnoredActors[Index] };
+		FHitResult WorldHit;
+		if (World->LineTraceSingleByChannel(WorldHit, Start, End, ECollisionChannel::ECC_Visibility, Params, UShooterShotSubsystem::GetShotResponseParams()))
+		{
+			Hit.bWorld = true;
+			Hit.Location = WorldHit.Location;
+			Hit.Normal = WorldHit.ImpactNormal;
+			End = WorldHit.Location;
+		}
+
+		FShooterHitboxHit HitboxHit;
+		if (Hitboxes && Hitboxes->TraceHitboxes(Start, End, HitboxHit, IgnoredActors[Index]))
+		{
+			Hit.bWorld = false;
+			Hit.bHitbox = true;
+			Hit.Location = HitboxHit.Location;
+			Hit.Normal = (Start - End).GetSafeNormal();
+		}
+	});
+}
+
+void UShooterProjectileSubsystem::ResolveHits()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ProjectilesResolve);
+
+	UShooterHitboxSubsystem* Hitboxes = UShooterHitboxSubsystem::Get(this);
+	UShooterEffectsSubsystem* ShotEffects = UShooterEffectsSubsystem::Get(this);
+
+	// Backwards so swapping the last projectile in does not skip one
+	for (int32 Index = NumProjectiles - 1; Index >= 0; --Index)
+	{
+		const FProjectileHit& Hit = Hits[Index];
+		if (Hit.bHitbox && Hitboxes)
+		{
+			// Registered with the other shots of the frame, slightly past the entry point so the capsule is hit
+			const FVector Start{ PrevX[Index], PrevY[Index], PrevZ[Index] };
+			Hitboxes->QueueShot(Start, Hit.Location + (Hit.Location - Start).GetSafeNormal(), Instigators[Index].Get(), Damages[Index]);
+		}
+		if (Hit.bWorld && ShotEffects)
+		{
+			ShotEffects->SpawnImpact(ImpactEffects[Index], Hit.Location, Hit.Normal);
+		}
+
+		if (Hit.bWorld || Hit.bHitbox || Ages[Index] >= Lifetimes[Index]) { RemoveProjectile(Index); }
+	}
+}
+
+void UShooterProjectileSubsystem::UpdateTracers()
+{
+	if (!TracerInstances) return;
+
+	SCOPE_CYCLE_COUNTER(STAT_ProjectilesTracers);
+
+	// Instances past the live projectiles are hidden, the component only grows
+	const int32 NumTransforms{ FMath::Max(NumProjectiles, NumVisibleTracers) };
+	if (NumTransforms == 0) return;
+
+	TracerTransforms.SetNumUninitialized(NumTransforms);
+	const FVector TracerScale{ TracerLength / 100.f, TracerThickness, TracerThickness };
+	ParallelFor(TEXT("Projectiles.Tracers"), NumTransforms, 256, [this, &TracerScale](int32 Index)
+	{
+		if (Index >= NumProjectiles)
+		{
+			TracerTransforms[Index] = FTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector);
+			return;
+		}
+
+		const FVector Velocity{ VelX[Index], VelY[Index], VelZ[Index] };
+		TracerTransforms[Index] = FTransform(Velocity.ToOrientationQuat(), FVector(PosX[Index], PosY[Index], PosZ[Index]), TracerScale);
+	});
+
+	const int32 NumInstances{ TracerInstances->GetInstanceCount() };
+	if (NumInstances < NumTransforms)
+	{
+		TArray<FTransform> NewInstances;
+		NewInstances.Init(FTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector), NumTransforms - NumInstances);
+		TracerInstances->AddInstances(NewInstances, false, true);
+	}
+
+	TracerInstances->BatchUpdateInstancesTransforms(0, TracerTransforms, true, true, true);
+	NumVisibleTracers = NumProjectiles;
+}
@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterProjectileSubsystem.generated.h"
+
+/**
+ * Simulated bullets with travel time and drop, without an actor per bullet.
+ * Live projectiles are kept in structure of arrays form, integrated 4 at a time each frame and swept
+ * against the world and the character hitboxes in parallel. Tracers are instances of one instanced static mesh.
+ */
+UCLASS(Config = Game)
+class ULTIMATESHOOTER_API UShooterProjectileSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	static UShooterProjectileSubsystem* Get(const UObject* WorldContextObject);
+
+	// False when MaxProjectiles are already flying
+	bool LaunchProjectile(AActor* Instigator, const FVector& Location, const FVector& Velocity, float GravityScale, float Lifetime,
+		float Damage, class UParticleSystem* ImpactParticles);
+
+	int32 GetNumProjectiles() const { return NumProjectiles; }
+	int32 GetMaxProjectiles() const { return MaxProjectiles; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	// Velocity and position step for every projectile
+	void Integrate(float DeltaTime);
+	// Traces last frame position to the new one, fills Hits
+	void Sweep();
+	// Effects, hitbox shots and removal of dead projectiles
+	void ResolveHits();
+	void UpdateTracers();
+
+	void RemoveProjectile(int32 Index);
+
+private:
+	struct FProjectileHit
+	{
+		FVector Location{ ForceInit };
+		FVector Normal{ ForceInit };
+		bool bWorld{ false };
+		bool bHitbox{ false };
+	};
+
+	// Structure of arrays, all NumProjectiles long
+	TArray<float> PosX, PosY, PosZ;
+	TArray<float> PrevX, PrevY, PrevZ;
+	TArray<float> VelX, VelY, VelZ;
+	TArray<float> GravityScales;
+	TArray<float> Ages;
+	TArray<float> Lifetimes;
+	TArray<float> Damages;
+	TArray<TWeakObjectPtr<AActor>> Instigators;
+	UPROPERTY(Transient)
+	TArray<class UParticleSystem*> ImpactEffects;
+	TArray<FProjectileHit> Hits;
+	int32 NumProjectiles{ 0 };
+
+	int32 NumRejected{ 0 };
+
+	UPROPERTY(Transient)
+	class UInstancedStaticMeshComponent* TracerInstances;
+	TArray<FTransform> TracerTransforms;
+	// Instances showing a projectile last frame, the others are scaled to zero
+	int32 NumVisibleTracers{ 0 };
+
+	UPROPERTY(Config)
+	int32 MaxProjectiles{ 10'000 };
+	// Fraction of the velocity lost per second
+	UPROPERTY(Config)
+	float AirDrag{ 0.05f };
+	// Mesh 100 units long along X, stretched and thinned into a tracer
+	UPROPERTY(Config)
+	TSoftObjectPtr<class UStaticMesh> TracerMesh;
+	UPROPERTY(Config)
+	float TracerLength{ 150.f };
+	UPROPERTY(Config)
+	float TracerThickness{ 0.02f };
+};
@@ -0,0 +1,424 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterSaveSubsystem.h"
+#include "Async/Async.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Item.h"
+#include "Weapon.h"
+#include "ShooterCharacter.h"
+
+#include "UltimateShooter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Snapshot Capture"), STAT_SnapshotCapture, STATGROUP_UltimateShooter);
+DECLARE_CYCLE_STAT(TEXT("Snapshot Apply"), STAT_SnapshotApply, STATGROUP_UltimateShooter);
+
+static FAutoConsoleCommandWithWorldAndArgs GSaveCommand(
+	TEXT("Shooter.Save"),
+	TEXT("Shooter.Save [Slot=Quick] - writes a full snapshot of the match to Saved/Snapshots"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UShooterSaveSubsystem* Save = UShooterSaveSubsystem::Get(World)) { Save->SaveSnapshot(Args.Num() > 0 ? Args[0] : TEXT("Quick")); }
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GLoadCommand(
+	TEXT("Shooter.Load"),
+	TEXT("Shooter.Load [Slot=Quick] - loads the newest snapshot of the slot"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UShooterSaveSubsystem* Save = UShooterSaveSubsystem::Get(World)) { Save->LoadSnapshot(Args.Num() > 0 ? Args[0] : TEXT("Quick")); }
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GLoadBenchmarkCommand(
+	TEXT("Shooter.Save.BenchmarkLoad"),
+	TEXT("Shooter.Save.BenchmarkLoad [NumItems=10000] - spawns the pickups, saves and loads them back and logs the load times"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UShooterSaveSubsystem* Save = UShooterSaveSubsystem::Get(World)) { Save->RunLoadBenchmark(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10000); }
+	}));
+
+bool UShooterSaveSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+UShooterSaveSubsystem* UShooterSaveSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UShooterSaveSubsystem>() : nullptr;
+}
+
+TStatId UShooterSaveSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterSaveSubsystem, STATGROUP_Tickables);
+}
+
+void UShooterSaveSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	TimeToAutosave = AutosaveInterval;
+}
+
+void UShooterSaveSubsystem::Deinitialize()
+{
+	// Don't leave a half written file behind
+	if (PendingTask.IsValid()) { PendingTask.Wait(); }
+
+	Super::Deinitialize();
+}
+
+void UShooterSaveSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (AutosaveInterval <= 0.f) return;
+
+	TimeToAutosave -= DeltaTime;
+	// Still writing the last one, try again next frame
+	if (TimeToAutosave > 0.f || IsBusy()) return;
+
+	TimeToAutosave = AutosaveInterval;
+	SaveSnapshot(AutosaveSlot, true);
+}
+
+bool UShooterSaveSubsystem::SaveSnapshot(const FString& Slot, bool bDelta)
+{
+	if (IsBusy())
+	{
+		UE_LOG(LogUltimateShooter, Warning, TEXT("Snapshot %s skipped, the last save or load is still running"), *Slot);
+		return false;
+	}
+	HandleSaveResult();
+
+	const double CaptureStartTime{ FPlatformTime::Seconds() };
+	TSharedRef<FShooterSnapshot> Snapshot{ MakeShared<FShooterSnapshot>() };
+	CaptureSnapshot(*Snapshot);
+
+	// First save of the slot this session leaves the sequence at 0, the worker picks it from the files on disk
+	FSlotState& SlotState = Slots.FindOrAdd(Slot);
+	if (SlotState.LastSnapshot) { Snapshot->Sequence = SlotState.LastSnapshot->Sequence + 1; }
+
+	TSharedPtr<const FShooterSnapshot> Base;
+	if (bDelta && SlotState.LastSnapshot && SlotState.DeltasSinceFull < FullSnapshotInterval)
+	{
+		Base = SlotState.LastSnapshot;
+		++SlotState.DeltasSinceFull;
+	}
+	else
+	{
+		SlotState.DeltasSinceFull = 0;
+	}
+	SlotState.LastSnapshot = Snapshot;
+
+	const double CaptureMs{ (FPlatformTime::Seconds() - CaptureStartTime) * 1000.0 };
+
+	PendingSaveSlot = Slot;
+	PendingTask = Async(EAsyncExecution::ThreadPool, [Slot, Snapshot, Base, CaptureMs]()
+	{
+		if (Snapshot->Sequence == 0)
+		{
+			// Carry on after the files of an earlier session
+			const TArray<uint32> Sequences{ FShooterSnapshot::FindSnapshotSequences(Slot) };
+			Snapshot->Sequence = (Sequences.Num() > 0 ? FMath::Max(Sequences) : 0) + 1;
+		}
+
+		const double EncodeStartTime{ FPlatformTime::Seconds() };
+		TArray<uint8> Bytes;
+		Snapshot->Write(Bytes, Base.Get());
+
+		const double WriteStartTime{ FPlatformTime::Seconds() };
+		const FString Path{ FShooterSnapshot::GetSnapshotPath(Slot, Snapshot->Sequence) };
+		if (!FFileHelper::SaveArrayToFile(Bytes, *Path))
+		{
+			UE_LOG(LogUltimateShooter, Warning, TEXT("Could not write snapshot %s"), *Path);
+			return false;
+		}
+		if (!Base) { DeleteSnapshotsBefore(Slot, Snapshot->Sequence); }
+
+		const double EndTime{ FPlatformTime::Seconds() };
+		UE_LOG(LogUltimateShooter, Log, TEXT("Snapshot %s: %s, %d characters, %d items, %d bytes, capture %.2f ms (game thread), encode %.2f ms, write %.2f ms"),
+			*Path, Base ? TEXT("delta") : TEXT("full"), Snapshot->Characters.Num(), Snapshot->Items.Num(), Bytes.Num(),
+			CaptureMs, (WriteStartTime - EncodeStartTime) * 1000.0, (EndTime - WriteStartTime) * 1000.0);
+		return true;
+	});
+	return true;
+}
+
+bool UShooterSaveSubsystem::LoadSnapshot(const FString& Slot)
+{
+	if (IsBusy())
+	{
+		UE_LOG(LogUltimateShooter, Warning, TEXT("Load of %s skipped, the last save or load is still running"), *Slot);
+		return false;
+	}
+	HandleSaveResult();
+
+	TWeakObjectPtr<UShooterSaveSubsystem> WeakThis{ this };
+	PendingTask = Async(EAsyncExecution::ThreadPool, [WeakThis, Slot]()
+	{
+		TSharedRef<FShooterSnapshot> Snapshot{ MakeShared<FShooterSnapshot>() };
+		FLoadStats Stats;
+		if (!ReadSlot(Slot, *Snapshot, Stats))
+		{
+			UE_LOG(LogUltimateShooter, Warning, TEXT("No readable snapshot for slot %s"), *Slot);
+			return true;
+		}
+
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, Slot, Snapshot, Stats]()
+		{
+			UShooterSaveSubsystem* This = WeakThis.Get();
+			if (!This) return;
+
+			const double ApplyStartTime{ FPlatformTime::Seconds() };
+			This->ApplySnapshot(*Snapshot);
+
+			// What was loaded is the newest file of the slot, the next autosave can delta against it
+			FSlotState& SlotState = This->Slots.FindOrAdd(Slot);
+			SlotState.LastSnapshot = Snapshot;
+			SlotState.DeltasSinceFull = Stats.NumFiles - 1;
+
+			UE_LOG(LogUltimateShooter, Log, TEXT("Loaded snapshot %s_%u: %d characters, %d items, %d files, %lld bytes, read %.2f ms, decode %.2f ms (worker), apply %.2f ms (game thread)"),
+				*Slot, Snapshot->Sequence, Snapshot->Characters.Num(), Snapshot->Items.Num(), Stats.NumFiles, Stats.NumBytes,
+				Stats.ReadMs, Stats.DecodeMs, (FPlatformTime::Seconds() - ApplyStartTime) * 1000.0);
+		});
+		return true;
+	});
+	return true;
+}
+
+void UShooterSaveSubsystem::HandleSaveResult()
+{
+	if (!PendingTask.IsValid()) return;
+
+	// The last snapshot of the slot never made it to disk, a delta against it couldn't be loaded
+	if (!PendingSaveSlot.IsEmpty() && !PendingTask.Get()) { Slots.Remove(PendingSaveSlot); }
+	PendingTask.Reset();
+	PendingSaveSlot.Reset();
+}
+
+void UShooterSaveSubsystem::CaptureSnapshot(FShooterSnapshot& OutSnapshot) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_SnapshotCapture);
+
+	for (TActorIterator<AShooterCharacter> It(GetWorld()); It; ++It)
+	{
+		const AShooterCharacter* Character = *It;
+
+		FShooterCharacterRecord& Record = OutSnapshot.Characters.AddDefaulted_GetRef();
+		Record.Name = Character->GetFName();
+		Record.Transform = Character->GetActorTransform();
+		Record.Ammo = Character->GetAmmoMap().Array();
+		Record.CombatState = Character->GetCombatState();
+		Record.bCrouching = Character->GetCrouching();
+		if (const AWeapon* Weapon = Character->GetEquippedWeapon()) { Record.WeaponName = Weapon->GetFName(); }
+	}
+
+	TMap<const UClass*, uint16> ClassIndices;
+	for (TActorIterator<AItem> It(GetWorld()); It; ++It)
+	{
+		const AItem* Item = *It;
+		if (Item->IsActorBeingDestroyed()) continue;
+
+		FShooterItemRecord& Record = OutSnapshot.Items.AddDefaulted_GetRef();
+		Record.Name = Item->GetFName();
+		if (const uint16* ClassIndex = ClassIndices.Find(Item->GetClass())) { Record.ClassIndex = *ClassIndex; }
+		else
+		{
+			Record.ClassIndex = static_cast<uint16>(OutSnapshot.ItemClasses.Add(Item->GetClass()->GetPathName()));
+			ClassIndices.Add(Item->GetClass(), Record.ClassIndex);
+		}
+		Record.Transform = Item->GetActorTransform();
+		Record.State = Item->GetItemState();
+		Record.Rarity = Item->GetItemRarity();
+		Record.Count = Item->GetItemCount();
+		if (const AWeapon* Weapon = Cast<AWeapon>(Item)) { Record.Ammo = Weapon->GetAmmo(); }
+	}
+}
+
+void UShooterSaveSubsystem::ApplySnapshot(const FShooterSnapshot& Snapshot)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SnapshotApply);
+
+	UWorld* World = GetWorld();
+
+	TArray<UClass*> ItemClasses;
+	ItemClasses.Reserve(Snapshot.ItemClasses.Num());
+	for (const FString& ClassPath : Snapshot.ItemClasses) { ItemClasses.Add(FSoftClassPath{ ClassPath }.TryLoadClass<AItem>()); }
+
+	TMap<FName, AItem*> WorldItems;
+	for (TActorIterator<AItem> It(World); It; ++It) { WorldItems.Add(It->GetFName(), *It); }
+
+	// Items first, a respawned weapon has to exist before its character equips it
+	TArray<AItem*> Items;
+	Items.SetNumZeroed(Snapshot.Items.Num());
+	TMap<FName, AWeapon*> Weapons;
+	for (int32 Index = 0; Index < Snapshot.Items.Num(); ++Index)
+	{
+		const FShooterItemRecord& Record = Snapshot.Items[Index];
+		UClass* ItemClass = ItemClasses[Record.ClassIndex];
+
+		AItem* Item{ nullptr };
+		if (WorldItems.RemoveAndCopyValue(Record.Name, Item) && Item->GetClass() != ItemClass)
+		{
+			Item->Destroy();
+			Item = nullptr;
+		}
+		if (!Item && ItemClass)
+		{
+			FActorSpawnParameters SpawnParameters;
+			SpawnParameters.Name = Record.Name;
+			SpawnParameters.NameMode = FActorSpawnParameters::ESpawnActorNameMode::Requested;
+			SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+			Item = World->SpawnActor<AItem>(ItemClass, Record.Transform, SpawnParameters);
+		}
+		if (!Item) continue;
+
+		Items[Index] = Item;
+		Item->SetItemRarity(Record.Rarity);
+		Item->SetItemCount(Record.Count);
+		if (AWeapon* Weapon = Cast<AWeapon>(Item))
+		{
+			Weapon->SetAmmo(Record.Ammo);
+			Weapons.Add(Record.Name, Weapon);
+		}
+
+		// Interp and throw timers aren't saved, those items land where they were
+		EItemState State{ Record.State };
+		if (State == EItemState::EIS_EquipInterping || State == EItemState::EIS_Falling) { State = EItemState::EIS_Pickup; }
+		// Held weapons follow the hand socket
+		if (State != EItemState::EIS_Equipped) { Item->SetActorTransform(Record.Transform, false, nullptr, ETeleportType::TeleportPhysics); }
+		if (Item->GetItemState() != State) { Item->SetItemState(State); }
+	}
+
+	// Spawned since the save, held weapons go with their character
+	for (const TPair<FName, AItem*>& Pair : WorldItems)
+	{
+		if (Pair.Value->GetItemState() != EItemState::EIS_Equipped) { Pair.Value->Destroy(); }
+	}
+
+	// Characters come from the game mode and are only matched, never spawned
+	TMap<FName, AShooterCharacter*> Characters;
+	for (TActorIterator<AShooterCharacter> It(World); It; ++It) { Characters.Add(It->GetFName(), *It); }
+	for (const FShooterCharacterRecord& Record : Snapshot.Characters)
+	{
+		if (AShooterCharacter* Character = Characters.FindRef(Record.Name))
+		{
+			Character->RestoreSnapshotState(Record.Transform, Record.Ammo, Record.CombatState, Record.bCrouching, Weapons.FindRef(Record.WeaponName));
+		}
+	}
+
+	// A weapon equipped at save time whose character now holds another one
+	for (AItem* Item : Items)
+	{
+		if (Item && Item->GetItemState() == EItemState::EIS_Equipped && !Cast<AShooterCharacter>(Item->GetAttachParentActor()))
+		{
+			Item->SetItemState(EItemState::EIS_Pickup);
+		}
+	}
+}
+
+bool UShooterSaveSubsystem::ReadSlot(const FString& Slot, FShooterSnapshot& OutSnapshot, FLoadStats& OutStats)
+{
+	const TArray<uint32> Sequences{ FShooterSnapshot::FindSnapshotSequences(Slot) };
+	if (Sequences.Num() == 0) return false;
+
+	// Newest first, back to the full snapshot
+	const double ReadStartTime{ FPlatformTime::Seconds() };
+	TArray<TArray<uint8>> Files;
+	uint32 Sequence{ FMath::Max(Sequences) };
+	while (true)
+	{
+		TArray<uint8>& Bytes = Files.AddDefaulted_GetRef();
+		if (!FFileHelper::LoadFileToArray(Bytes, *FShooterSnapshot::GetSnapshotPath(Slot, Sequence))) return false;
+		OutStats.NumBytes += Bytes.Num();
+
+		uint32 FileSequence{ 0 };
+		uint32 BaseSequence{ 0 };
+		if (!FShooterSnapshot::ReadHeader(Bytes, FileSequence, BaseSequence)) return false;
+		if (BaseSequence == 0) break;
+		// Deltas always point back
+		if (BaseSequence >= Sequence) return false;
+		Sequence = BaseSequence;
+	}
+	OutStats.NumFiles = Files.Num();
+
+	const double DecodeStartTime{ FPlatformTime::Seconds() };
+	for (int32 Index = Files.Num() - 1; Index >= 0; --Index)
+	{
+		if (!OutSnapshot.Read(Files[Index])) return false;
+	}
+
+	OutStats.ReadMs = (DecodeStartTime - ReadStartTime) * 1000.0;
+	OutStats.DecodeMs = (FPlatformTime::Seconds() - DecodeStartTime) * 1000.0;
+	return true;
+}
+
+void UShooterSaveSubsystem::DeleteSnapshotsBefore(const FString& Slot, uint32 Sequence)
+{
+	for (const uint32 FileSequence : FShooterSnapshot::FindSnapshotSequences(Slot))
+	{
+		if (FileSequence < Sequence) { IFileManager::Get().Delete(*FShooterSnapshot::GetSnapshotPath(Slot, FileSequence)); }
+	}
+}
+
+void UShooterSaveSubsystem::RunLoadBenchmark(int32 NumItems)
+{
+	if (IsBusy() || NumItems <= 0) return;
+
+	UClass* ItemClass = BenchmarkItemClass.LoadSynchronous();
+	if (!ItemClass)
+	{
+		UE_LOG(LogUltimateShooter, Warning, TEXT("Load benchmark needs a BenchmarkItemClass"));
+		return;
+	}
+
+	// A grid of pickups around the player
+	UWorld* World = GetWorld();
+	const APlayerController* PlayerController = World->GetFirstPlayerController();
+	const APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+	const FVector Origin{ Pawn ? Pawn->GetActorLocation() : FVector::ZeroVector };
+	const int32 GridSize{ FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumItems))) };
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	TArray<AItem*> BenchmarkItems;
+	BenchmarkItems.Reserve(NumItems);
+	for (int32 Index = 0; Index < NumItems; ++Index)
+	{
+		const FVector Location{ Origin + FVector{ (Index % GridSize) * 100.f, (Index / GridSize) * 100.f, 0.f } };
+		if (AItem* Item = World->SpawnActor<AItem>(ItemClass, Location, FRotator::ZeroRotator, SpawnParameters)) { BenchmarkItems.Add(Item); }
+	}
+
+	const FString Slot{ TEXT("LoadBenchmark") };
+	Slots.Remove(Slot);
+	DeleteSnapshotsBefore(Slot, MAX_uint32);
+	if (!SaveSnapshot(Slot)) return;
+	PendingTask.Wait();
+
+	// Everything moved since the save, so the load has work to do
+	for (AItem* Item : BenchmarkItems) { Item->AddActorWorldOffset(FVector{ 0.f, 0.f, 50.f }); }
+
+	// Same steps as a load, the worker part run here so it can be timed end to end
+	FShooterSnapshot Snapshot;
+	FLoadStats Stats;
+	if (ReadSlot(Slot, Snapshot, Stats))
+	{
+		const double ApplyStartTime{ FPlatformTime::Seconds() };
+		ApplySnapshot(Snapshot);
+		UE_LOG(LogUltimateShooter, Log, TEXT("Load benchmark: %d items, %lld bytes, read %.2f ms, decode %.2f ms, apply %.2f ms"),
+			Snapshot.Items.Num(), Stats.NumBytes, Stats.ReadMs, Stats.DecodeMs, (FPlatformTime::Seconds() - ApplyStartTime) * 1000.0);
+	}
+
+	for (AItem* Item : BenchmarkItems)
+	{
+		if (IsValid(Item)) { Item->Destroy(); }
+	}
+	Slots.Remove(Slot);
+	DeleteSnapshotsBefore(Slot, MAX_uint32);
+}
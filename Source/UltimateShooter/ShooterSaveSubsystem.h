@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Async/Future.h"
+#include "ShooterSnapshot.h"
+#include "ShooterSaveSubsystem.generated.h"
+
+class AItem;
+
+/**
+ * Snapshot save and load of the match: every shooter character and every item in the world.
+ * The game thread only copies the actor state into a FShooterSnapshot, encoding and the file write run on the thread pool.
+ * Loads read and decode on the thread pool too and apply on the game thread. Autosaves write deltas against the previous
+ * snapshot of the slot, with a full snapshot every FullSnapshotInterval saves.
+ */
+UCLASS(Config = Game)
+class ULTIMATESHOOTER_API UShooterSaveSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	static UShooterSaveSubsystem* Get(const UObject* WorldContextObject);
+
+	// False while the previous save or load is still running on the thread pool
+	bool SaveSnapshot(const FString& Slot, bool bDelta = false);
+	bool LoadSnapshot(const FString& Slot);
+
+	bool IsBusy() const { return PendingTask.IsValid() && !PendingTask.IsReady(); }
+
+	// Spawns NumItems pickups, saves and loads them back, and logs the time of every load step
+	void RunLoadBenchmark(int32 NumItems);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	void CaptureSnapshot(FShooterSnapshot& OutSnapshot) const;
+	void ApplySnapshot(const FShooterSnapshot& Snapshot);
+
+	struct FLoadStats
+	{
+		int32 NumFiles{ 0 };
+		int64 NumBytes{ 0 };
+		double ReadMs{ 0.0 };
+		double DecodeMs{ 0.0 };
+	};
+	// Newest snapshot of the slot, delta files are walked back to their full snapshot. Any thread
+	static bool ReadSlot(const FString& Slot, FShooterSnapshot& OutSnapshot, FLoadStats& OutStats);
+	// Files before a full snapshot aren't needed by any delta anymore. Any thread
+	static void DeleteSnapshotsBefore(const FString& Slot, uint32 Sequence);
+
+private:
+	struct FSlotState
+	{
+		// Base of the next delta, immutable once written so the writing task can share it
+		TSharedPtr<const FShooterSnapshot> LastSnapshot;
+		int32 DeltasSinceFull{ 0 };
+	};
+	TMap<FString, FSlotState> Slots;
+
+	// Drops the slot state of a save that couldn't be written, the next save of the slot is a full one
+	void HandleSaveResult();
+
+	// False if the save couldn't be written
+	TFuture<bool> PendingTask;
+	// Slot written by PendingTask, empty for a load
+	FString PendingSaveSlot;
+
+	float TimeToAutosave{ 0.f };
+
+	// Seconds between autosaves, 0 (the default) turns them off
+	UPROPERTY(Config)
+	float AutosaveInterval{ 0.f };
+	UPROPERTY(Config)
+	FString AutosaveSlot{ TEXT("Autosave") };
+	// Delta autosaves before the next full one, bounds the files a load reads
+	UPROPERTY(Config)
+	int32 FullSnapshotInterval{ 10 };
+	// Pickup spawned by the load benchmark
+	UPROPERTY(Config)
+	TSoftClassPtr<AItem> BenchmarkItemClass;
+};
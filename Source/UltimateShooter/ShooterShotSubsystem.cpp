@@ -0,0 +1,188 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterShotSubsystem.h"
+#include "Engine/World.h"
+#include "Weapon.h"
+#include "ShooterSpread.h"
+#include "ShooterHitboxSubsystem.h"
+#include "ShooterEffectsSubsystem.h"
+#include "ShooterProjectileSubsystem.h"
+
+#include "UltimateShooter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Shot Rays Process"), STAT_ShotRaysProcess, STATGROUP_UltimateShooter);
+DECLARE_CYCLE_STAT(TEXT("Shot Rays Submit"), STAT_ShotRaysSubmit, STATGROUP_UltimateShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Shot Rays Submitted"), STAT_ShotRaysSubmitted, STATGROUP_UltimateShooter);
+
+namespace
+{
+	const FHitResult* GetBlockingHit(const FTraceDatum& Datum)
+	{
+		return Datum.OutHits.Num() > 0 && Datum.OutHits[0].bBlockingHit ? &Datum.OutHits[0] : nullptr;
+	}
+}
+
+const FCollisionResponseParams& UShooterShotSubsystem::GetShotResponseParams()
+{
+	static const FCollisionResponseParams Params = []()
+	{
+		FCollisionResponseParams Response;
+		Response.CollisionResponse.SetResponse(ECollisionChannel::ECC_Pawn, ECollisionResponse::ECR_Ignore);
+		return Response;
+	}();
+	return Params;
+}
+
+bool UShooterShotSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+UShooterShotSubsystem* UShooterShotSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UShooterShotSubsystem>() : nullptr;
+}
+
+TStatId UShooterShotSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterShotSubsystem, STATGROUP_Tickables);
+}
+
+void UShooterShotSubsystem::Deinitialize()
+{
+	Rays.Empty();
+
+	Super::Deinitialize();
+}
+
+void UShooterShotSubsystem::FireShot(AActor* Instigator, const FVector& MuzzleLocation, const FVector& AimDirection, const FShotShape& Shape,
+	uint32 ShotIndex, float SpreadHalfAngle, UParticleSystem* ImpactParticles, UParticleSystem* BeamParticles)
+{
+	const float HalfAngle{ Shape.ConeHalfAngle + FMath::Max(SpreadHalfAngle, 0.f) };
+	const int32 NumPellets{ FMath::Max(Shape.NumPellets, 1) };
+
+	if (Shape.ProjectileSpeed > 0.f)
+	{
+		// Travel time and drop, penetration does not apply
+		if (UShooterProjectileSubsystem* Projectiles = UShooterProjectileSubsystem::Get(this))
+		{
+			for (int32 Pellet = 0; Pellet < NumPellets; ++Pellet)
+			{
+				const FVector Dir{ ShooterSpread::GetSpreadDirection(AimDirection, HalfAngle, ShotIndex * NumPellets + Pellet) };
+				Projectiles->LaunchProjectile(Instigator, MuzzleLocation, Dir * Shape.ProjectileSpeed, Shape.ProjectileGravityScale, Shape.ProjectileLifetime,
+					Shape.Damage, ImpactParticles);
+			}
+		}
+		return;
+	}
+
+	for (int32 Pellet = 0; Pellet < NumPellets; ++Pellet)
+	{
+		FShotRay& Ray = Rays.AddDefaulted_GetRef();
+		Ray.Instigator = Instigator;
+		Ray.ImpactParticles = ImpactParticles;
+		Ray.BeamParticles = BeamParticles;
+		Ray.Dir = ShooterSpread::GetSpreadDirection(AimDirection, HalfAngle, ShotIndex * NumPellets + Pellet);
+		Ray.Start = MuzzleLocation;
+		Ray.End = MuzzleLocation + Ray.Dir * Shape.Range;
+		Ray.Damage = Shape.Damage;
+		Ray.PenetrationsLeft = Shape.MaxPenetrations;
+		Ray.MaxPenetrationDepth = Shape.MaxPenetrationDepth;
+	}
+}
+
+void UShooterShotSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_ShotRaysProcess);
+		for (int32 Index = Rays.Num() - 1; Index >= 0; --Index)
+		{
+			if (Rays[Index].bSubmitted && !ProcessRay(Rays[Index])) { Rays.RemoveAtSwap(Index, 1, false); }
+		}
+	}
+
+	SubmitRays();
+}
+
+void UShooterShotSubsystem::SubmitRays()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ShotRaysSubmit);
+
+	UWorld* World = GetWorld();
+	int32 NumSubmitted{ 0 };
+	int32 NumTraces{ 0 };
+	for (FShotRay& Ray : Rays)
+	{
+		if (Ray.bSubmitted) continue;
+
+		const FCollisionQueryParams Params{ SCENE_QUERY_STAT(ShooterShot), false, Ray.Instigator.Get() };
+		Ray.SegmentTrace = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Ray.Start, Ray.End, ECollisionChannel::ECC_Visibility, Params, GetShotResponseParams());
+		++NumTraces;
+		if (Ray.bPenetrating)
+		{
+			Ray.ExitTrace = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Ray.Start, Ray.SurfaceLocation, ECollisionChannel::ECC_Visibility, Params, GetShotResponseParams());
+			++NumTraces;
+		}
+
+		Ray.bSubmitted = true;
+		++NumSubmitted;
+	}
+
+	INC_DWORD_STAT_BY(STAT_ShotRaysSubmitted, NumSubmitted);
+	CSV_CUSTOM_STAT(ShooterGameplay, Traces, NumTraces, ECsvCustomStatOp::Accumulate);
+}
+
+bool UShooterShotSubsystem::ProcessRay(FShotRay& Ray)
+{
+	UWorld* World = GetWorld();
+
+	FTraceDatum Segment;
+	if (!World->QueryTraceData(Ray.SegmentTrace, Segment))
+	{
+		// Not done yet, or lost (world paused for more than a frame)
+		return World->IsTraceHandleValid(Ray.SegmentTrace, false);
+	}
+
+	FVector SegmentStart{ Ray.Start };
+	if (Ray.bPenetrating)
+	{
+		// No exit point, the surface is thicker than MaxPenetrationDepth
+		FTraceDatum Exit;
+		if (!World->QueryTraceData(Ray.ExitTrace, Exit)) return false;
+		const FHitResult* ExitHit = GetBlockingHit(Exit);
+		if (!ExitHit || ExitHit->bStartPenetrating) return false;
+
+		SegmentStart = ExitHit->Location;
+	}
+
+	const FHitResult* Hit = GetBlockingHit(Segment);
+	const FVector SegmentEnd{ Hit ? Hit->Location : Ray.End };
+
+	if (UShooterHitboxSubsystem* Hitboxes = UShooterHitboxSubsystem::Get(this))
+	{
+		Hitboxes->QueueShot(SegmentStart, SegmentEnd, Ray.Instigator.Get(), Ray.Damage);
+	}
+
+	if (UShooterEffectsSubsystem* ShotEffects = UShooterEffectsSubsystem::Get(this))
+	{
+		ShotEffects->SpawnTracer(Ray.BeamParticles.Get(), FTransform(Ray.Dir.Rotation(), SegmentStart), SegmentEnd);
+		if (Hit) { ShotEffects->SpawnImpact(Ray.ImpactParticles.Get(), Hit->Location, Hit->ImpactNormal); }
+	}
+
+	if (!Hit || Ray.PenetrationsLeft <= 0) return false;
+
+	// Go through: trace on from past the surface, and back to it to find where the ray leaves it
+	const FVector ContinueStart{ Hit->Location + Ray.Dir * Ray.MaxPenetrationDepth };
+	if (FVector::DotProduct(Ray.End - ContinueStart, Ray.Dir) <= 0.0) return false;
+
+	Ray.SurfaceLocation = Hit->Location;
+	Ray.Start = ContinueStart;
+	Ray.bPenetrating = true;
+	Ray.bSubmitted = false;
+	--Ray.PenetrationsLeft;
+	return true;
+}
@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "WorldCollision.h"
+#include "ShooterShotSubsystem.generated.h"
+
+struct FShotShape;
+
+/**
+ * Turns shots into rays (pellets, penetration) and traces them against the world.
+ * Shots with a projectile speed are handed to UShooterProjectileSubsystem instead.
+ * Rays of every shot fired during the frame are submitted together as async traces, which the engine runs
+ * in parallel at the end of the frame. Results are read on the next tick, where each ray segment goes to the
+ * hitbox batch and the effects, and penetrating rays submit their next segment.
+ */
+UCLASS()
+class ULTIMATESHOOTER_API UShooterShotSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	static UShooterShotSubsystem* Get(const UObject* WorldContextObject);
+
+	/**
+	 * Queues the rays of one shot leaving MuzzleLocation towards AimDirection.
+	 * Pellet directions come from the spread table at ShotIndex * NumPellets, inside ConeHalfAngle + SpreadHalfAngle.
+	 */
+	void FireShot(AActor* Instigator, const FVector& MuzzleLocation, const FVector& AimDirection, const FShotShape& Shape,
+		uint32 ShotIndex, float SpreadHalfAngle, class UParticleSystem* ImpactParticles, class UParticleSystem* BeamParticles);
+
+	int32 GetNumRaysInFlight() const { return Rays.Num(); }
+
+	// Characters are hit through their hitboxes, world traces of shots skip pawns
+	static const FCollisionResponseParams& GetShotResponseParams();
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FShotRay
+	{
+		TWeakObjectPtr<AActor> Instigator;
+		TWeakObjectPtr<class UParticleSystem> ImpactParticles;
+		TWeakObjectPtr<class UParticleSystem> BeamParticles;
+
+		FVector Start{ ForceInit };
+		FVector End{ ForceInit };
+		FVector Dir{ ForceInit };
+		float Damage{ 0.f };
+		int32 PenetrationsLeft{ 0 };
+		float MaxPenetrationDepth{ 0.f };
+
+		// Forward trace of the current segment
+		FTraceHandle SegmentTrace;
+		// Backward trace from Start to the surface the ray went through, finds the exit point
+		FTraceHandle ExitTrace;
+		FVector SurfaceLocation{ ForceInit };
+		bool bPenetrating{ false };
+		// Traces are in flight, results come next frame
+		bool bSubmitted{ false };
+	};
+
+	// Sends every ray waiting for a trace in one go
+	void SubmitRays();
+	// Reads finished traces, returns false when the ray is done
+	bool ProcessRay(FShotRay& Ray);
+
+	TArray<FShotRay> Rays;
+};
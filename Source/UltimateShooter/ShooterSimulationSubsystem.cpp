@@ -0,0 +1,189 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterSimulationSubsystem.h"
+#include "Engine/World.h"
+#include "Engine/Engine.h"
+#include "Engine/GameViewportClient.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "ShooterCharacter.h"
+
+#include "UltimateShooter.h"
+
+static FAutoConsoleCommandWithWorldAndArgs GSimFastForwardCommand(
+	TEXT("Shooter.Sim.FastForward"),
+	TEXT("Shooter.Sim.FastForward [SimSeconds=0] - ticks the world on a fixed step as fast as possible, 0 runs until Shooter.Sim.Stop"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UShooterSimulationSubsystem* Simulation = UShooterSimulationSubsystem::Get(World))
+		{
+			Simulation->StartFastForward(Args.Num() > 0 ? FCString::Atof(*Args[0]) : 0.f);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld GSimStopCommand(
+	TEXT("Shooter.Sim.Stop"),
+	TEXT("Stops the fast forward"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UShooterSimulationSubsystem* Simulation = UShooterSimulationSubsystem::Get(World)) { Simulation->StopFastForward(); }
+	}));
+
+bool UShooterSimulationSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+UShooterSimulationSubsystem* UShooterSimulationSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UShooterSimulationSubsystem>() : nullptr;
+}
+
+FRandomStream& UShooterSimulationSubsystem::GetRandomStream(const UObject* WorldContextObject)
+{
+	if (UShooterSimulationSubsystem* Simulation = Get(WorldContextObject)) return Simulation->RandomStream;
+
+	static FRandomStream FallbackStream{ 0 };
+	return FallbackStream;
+}
+
+bool UShooterSimulationSubsystem::IsFastForwarding(const UObject* WorldContextObject)
+{
+	const UShooterSimulationSubsystem* Simulation = Get(WorldContextObject);
+	return Simulation && Simulation->bFastForward;
+}
+
+TStatId UShooterSimulationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterSimulationSubsystem, STATGROUP_Tickables);
+}
+
+void UShooterSimulationSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	int32 Seed{ DefaultSeed };
+	FParse::Value(FCommandLine::Get(), TEXT("ShooterSeed="), Seed);
+	if (Seed == 0) { Seed = static_cast<int32>(FPlatformTime::Cycles()); }
+	RandomStream.Initialize(Seed);
+}
+
+void UShooterSimulationSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (FParse::Param(FCommandLine::Get(), TEXT("ShooterFastForward")))
+	{
+		float RunSeconds{ 0.f };
+		FParse::Value(FCommandLine::Get(), TEXT("ShooterSimSeconds="), RunSeconds);
+		StartFastForward(RunSeconds);
+	}
+}
+
+void UShooterSimulationSubsystem::Deinitialize()
+{
+	StopFastForward();
+
+	Super::Deinitialize();
+}
+
+void UShooterSimulationSubsystem::StartFastForward(float InSimSeconds)
+{
+	if (bFastForward) return;
+	bFastForward = true;
+
+	TargetSimSeconds = InSimSeconds;
+	SimSeconds = 0.0;
+	StartWallTime = FPlatformTime::Seconds();
+	NextReportWallTime = StartWallTime + ReportInterval;
+
+	// Fixed step, no frame rate cap or smoothing, the engine doesn't wait for the wall clock
+	bWasFixedTimeStep = FApp::UseFixedTimeStep();
+	PreviousFixedDeltaTime = FApp::GetFixedDeltaTime();
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(FixedStep);
+	if (GEngine)
+	{
+		bWasSmoothFrameRate = GEngine->bSmoothFrameRate;
+		bWasFixedFrameRate = GEngine->bUseFixedFrameRate;
+		GEngine->bSmoothFrameRate = false;
+		GEngine->bUseFixedFrameRate = false;
+	}
+	if (IConsoleVariable* MaxFPS = IConsoleManager::Get().FindConsoleVariable(TEXT("t.MaxFPS")))
+	{
+		PreviousMaxFPS = MaxFPS->GetFloat();
+		MaxFPS->Set(0.f);
+	}
+
+	if (UGameViewportClient* GameViewport = GetWorld()->GetGameViewport()) { GameViewport->bDisableWorldRendering = true; }
+
+	for (TActorIterator<AShooterCharacter> It(GetWorld()); It; ++It) { PrepareActor(*It); }
+	ActorSpawnedHandle = GetWorld()->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UShooterSimulationSubsystem::OnActorSpawned));
+
+	// Tells the CSVs of nightly runs apart
+	CSV_METADATA(TEXT("ShooterSeed"), *FString::FromInt(GetSeed()));
+	UE_LOG(LogUltimateShooter, Log, TEXT("Fast forward: %.4f s steps, seed %d"), FixedStep, GetSeed());
+}
+
+void UShooterSimulationSubsystem::StopFastForward()
+{
+	if (!bFastForward) return;
+	bFastForward = false;
+
+	FApp::SetUseFixedTimeStep(bWasFixedTimeStep);
+	FApp::SetFixedDeltaTime(PreviousFixedDeltaTime);
+	if (GEngine)
+	{
+		GEngine->bSmoothFrameRate = bWasSmoothFrameRate;
+		GEngine->bUseFixedFrameRate = bWasFixedFrameRate;
+	}
+	if (IConsoleVariable* MaxFPS = IConsoleManager::Get().FindConsoleVariable(TEXT("t.MaxFPS"))) { MaxFPS->Set(PreviousMaxFPS); }
+	if (UGameViewportClient* GameViewport = GetWorld()->GetGameViewport()) { GameViewport->bDisableWorldRendering = false; }
+	GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+
+	ReportSpeed();
+}
+
+void UShooterSimulationSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!bFastForward) return;
+
+	SimSeconds += DeltaTime;
+	if (FPlatformTime::Seconds() >= NextReportWallTime)
+	{
+		NextReportWallTime += ReportInterval;
+		ReportSpeed();
+	}
+
+	if (TargetSimSeconds > 0.f && SimSeconds >= TargetSimSeconds)
+	{
+		StopFastForward();
+		FPlatformMisc::RequestExit(false);
+	}
+}
+
+void UShooterSimulationSubsystem::OnActorSpawned(AActor* Actor)
+{
+	PrepareActor(Actor);
+}
+
+void UShooterSimulationSubsystem::PrepareActor(AActor* Actor)
+{
+	if (AShooterCharacter* Character = Cast<AShooterCharacter>(Actor))
+	{
+		Character->GetMesh()->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPose;
+	}
+}
+
+void UShooterSimulationSubsystem::ReportSpeed() const
+{
+	const double WallSeconds{ FPlatformTime::Seconds() - StartWallTime };
+	UE_LOG(LogUltimateShooter, Log, TEXT("Fast forward: %.1f s simulated in %.1f s, %.1fx real time, seed %d"),
+		SimSeconds, WallSeconds, WallSeconds > 0.0 ? SimSeconds / WallSeconds : 0.0, GetSeed());
+}
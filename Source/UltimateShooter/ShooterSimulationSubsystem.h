@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterSimulationSubsystem.generated.h"
+
+/**
+ * Seeded random stream of the world, and the fast forward mode for balancing and bot training runs.
+ * Fast forward ticks the world on a fixed timestep as fast as the CPU allows, with world rendering, combat audio and VFX off.
+ * Gameplay randomness comes from the seeded stream, so two runs with the same seed and input simulate the same match.
+ * Start with -ShooterFastForward [-ShooterSeed=<Seed>] [-ShooterSimSeconds=<Seconds>] -nullrhi -nosound -onethread.
+ */
+UCLASS(Config = Game)
+class ULTIMATESHOOTER_API UShooterSimulationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	static UShooterSimulationSubsystem* Get(const UObject* WorldContextObject);
+
+	// Gameplay randomness, a shared fallback stream outside game worlds
+	static FRandomStream& GetRandomStream(const UObject* WorldContextObject);
+	// Presentation is skipped while true
+	static bool IsFastForwarding(const UObject* WorldContextObject);
+
+	// Runs until stopped, or for SimSeconds of game time and then exits the game
+	void StartFastForward(float SimSeconds = 0.f);
+	void StopFastForward();
+
+	int32 GetSeed() const { return RandomStream.GetInitialSeed(); }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	void OnActorSpawned(AActor* Actor);
+	// Montage notifies drive reloads, characters need their pose ticked with nothing rendered
+	static void PrepareActor(AActor* Actor);
+
+	void ReportSpeed() const;
+
+private:
+	FRandomStream RandomStream;
+
+	bool bFastForward{ false };
+	float TargetSimSeconds{ 0.f };
+	double SimSeconds{ 0.0 };
+	double StartWallTime{ 0.0 };
+	double NextReportWallTime{ 0.0 };
+
+	// Engine state before the fast forward
+	bool bWasFixedTimeStep{ false };
+	double PreviousFixedDeltaTime{ 0.0 };
+	bool bWasSmoothFrameRate{ false };
+	bool bWasFixedFrameRate{ false };
+	float PreviousMaxFPS{ 0.f };
+
+	FDelegateHandle ActorSpawnedHandle;
+
+	// Game time of a fast forward frame
+	UPROPERTY(Config)
+	float FixedStep{ 1.f / 30.f };
+	// Seed used without -ShooterSeed, 0 seeds from the clock
+	UPROPERTY(Config)
+	int32 DefaultSeed{ 0 };
+	// Wall seconds between speed reports
+	UPROPERTY(Config)
+	float ReportInterval{ 10.f };
+};
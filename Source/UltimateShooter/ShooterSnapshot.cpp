@@ -0,0 +1,267 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterSnapshot.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+
+static constexpr uint32 SnapshotMagic{ 0x50534853 };   // "SHSP"
+static constexpr uint16 SnapshotVersion{ 1 };
+
+// Items closer than this to their base position count as unchanged
+static constexpr double DeltaLocationTolerance{ 0.1 };
+static constexpr double DeltaRotationTolerance{ 1.e-4 };
+
+// Counts and ammo are never negative, most fit a byte once packed
+static void SerializePacked(FArchive& Ar, int32& Value)
+{
+	uint32 Packed{ static_cast<uint32>(Value) };
+	Ar.SerializeIntPacked(Packed);
+	Value = static_cast<int32>(Packed);
+}
+
+// Location and rotation only, actor scale never changes at runtime
+static void SerializeTransform(FArchive& Ar, FTransform& Transform)
+{
+	FVector3f Location{ Transform.GetLocation() };
+	FQuat4f Rotation{ Transform.GetRotation() };
+	Ar << Location << Rotation;
+	if (Ar.IsLoading()) { Transform = FTransform{ FQuat{ Rotation }, FVector{ Location } }; }
+}
+
+// Guards the allocation of a count read from a damaged file, every element takes at least a byte
+static bool IsValidCount(const FArchive& Ar, int32 Num)
+{
+	return !Ar.IsError() && Num >= 0 && Num <= Ar.TotalSize() - Ar.Tell();
+}
+
+static void SerializeRecord(FArchive& Ar, FShooterCharacterRecord& Record)
+{
+	Ar << Record.Name;
+	SerializeTransform(Ar, Record.Transform);
+
+	int32 NumAmmo{ Record.Ammo.Num() };
+	Ar << NumAmmo;
+	if (Ar.IsLoading())
+	{
+		if (!IsValidCount(Ar, NumAmmo))
+		{
+			Ar.SetError();
+			return;
+		}
+		Record.Ammo.SetNum(NumAmmo);
+	}
+	for (TPair<EAmmoType, int32>& Ammo : Record.Ammo)
+	{
+		Ar << Ammo.Key;
+		SerializePacked(Ar, Ammo.Value);
+	}
+
+	uint8 bCrouching{ Record.bCrouching };
+	Ar << Record.CombatState << bCrouching << Record.WeaponName;
+	Record.bCrouching = bCrouching != 0;
+
+	if (Ar.IsLoading() && Record.CombatState >= ECombatState::ECS_MAX) { Ar.SetError(); }
+}
+
+static void SerializeRecord(FArchive& Ar, FShooterItemRecord& Record)
+{
+	Ar << Record.Name << Record.ClassIndex;
+	SerializeTransform(Ar, Record.Transform);
+	Ar << Record.State << Record.Rarity;
+	SerializePacked(Ar, Record.Count);
+
+	// INDEX_NONE packs to 0
+	int32 StoredAmmo{ Record.Ammo + 1 };
+	SerializePacked(Ar, StoredAmmo);
+	Record.Ammo = StoredAmmo - 1;
+
+	if (Ar.IsLoading() && (Record.State >= EItemState::EIS_MAX || Record.Rarity >= EItemRarity::EIR_MAX)) { Ar.SetError(); }
+}
+
+static bool HasChanged(const FShooterItemRecord& Record, const FString& Class, const FShooterItemRecord& BaseRecord, const FString& BaseClass)
+{
+	return Record.State != BaseRecord.State || Record.Rarity != BaseRecord.Rarity || Record.Count != BaseRecord.Count || Record.Ammo != BaseRecord.Ammo
+		|| Class != BaseClass
+		|| !Record.Transform.GetLocation().Equals(BaseRecord.Transform.GetLocation(), DeltaLocationTolerance)
+		|| !Record.Transform.GetRotation().Equals(BaseRecord.Transform.GetRotation(), DeltaRotationTolerance);
+}
+
+void FShooterSnapshot::Write(TArray<uint8>& OutBytes, const FShooterSnapshot* Base) const
+{
+	FMemoryWriter Writer{ OutBytes };
+	// Writing only reads the fields
+	FShooterSnapshot& This = const_cast<FShooterSnapshot&>(*this);
+
+	uint32 Magic{ SnapshotMagic };
+	uint16 Version{ SnapshotVersion };
+	uint32 BaseSequence{ Base ? Base->Sequence : 0 };
+	Writer << Magic << Version << This.Sequence << BaseSequence;
+
+	Writer << This.ItemClasses;
+
+	int32 NumCharacters{ Characters.Num() };
+	Writer << NumCharacters;
+	for (FShooterCharacterRecord& Record : This.Characters) { SerializeRecord(Writer, Record); }
+
+	if (!Base)
+	{
+		int32 NumItems{ Items.Num() };
+		Writer << NumItems;
+		for (FShooterItemRecord& Record : This.Items) { SerializeRecord(Writer, Record); }
+		return;
+	}
+
+	// Items that changed or appeared since the base, then the ones gone since
+	TMap<FName, const FShooterItemRecord*> BaseItems;
+	BaseItems.Reserve(Base->Items.Num());
+	for (const FShooterItemRecord& BaseRecord : Base->Items) { BaseItems.Add(BaseRecord.Name, &BaseRecord); }
+
+	TArray<FShooterItemRecord*> Changed;
+	for (FShooterItemRecord& Record : This.Items)
+	{
+		const FShooterItemRecord* BaseRecord{ nullptr };
+		if (BaseItems.RemoveAndCopyValue(Record.Name, BaseRecord)
+			&& !HasChanged(Record, ItemClasses[Record.ClassIndex], *BaseRecord, Base->ItemClasses[BaseRecord->ClassIndex])) continue;
+
+		Changed.Add(&Record);
+	}
+
+	int32 NumChanged{ Changed.Num() };
+	Writer << NumChanged;
+	for (FShooterItemRecord* Record : Changed) { SerializeRecord(Writer, *Record); }
+
+	// Whatever is left of the base was destroyed since
+	int32 NumRemoved{ BaseItems.Num() };
+	Writer << NumRemoved;
+	for (const TPair<FName, const FShooterItemRecord*>& Pair : BaseItems)
+	{
+		FName Name{ Pair.Key };
+		Writer << Name;
+	}
+}
+
+bool FShooterSnapshot::Read(const TArray<uint8>& Bytes)
+{
+	FMemoryReader Reader{ Bytes };
+
+	uint32 Magic{ 0 };
+	uint16 Version{ 0 };
+	uint32 FileSequence{ 0 };
+	uint32 BaseSequence{ 0 };
+	Reader << Magic << Version << FileSequence << BaseSequence;
+	if (Reader.IsError() || Magic != SnapshotMagic || Version != SnapshotVersion) return false;
+	// A delta only applies on top of the snapshot it was written against
+	if (BaseSequence != 0 && BaseSequence != Sequence) return false;
+
+	TArray<FString> FileClasses;
+	Reader << FileClasses;
+	if (Reader.IsError()) return false;
+
+	if (BaseSequence == 0)
+	{
+		ItemClasses.Reset();
+		Items.Reset();
+	}
+	// Class indices of the file into the merged table
+	TArray<uint16> ClassRemap;
+	ClassRemap.Reserve(FileClasses.Num());
+	for (const FString& Class : FileClasses) { ClassRemap.Add(static_cast<uint16>(ItemClasses.AddUnique(Class))); }
+
+	int32 NumCharacters{ 0 };
+	Reader << NumCharacters;
+	if (!IsValidCount(Reader, NumCharacters)) return false;
+	Characters.SetNum(NumCharacters);
+	for (FShooterCharacterRecord& Record : Characters)
+	{
+		SerializeRecord(Reader, Record);
+		if (Reader.IsError()) return false;
+	}
+
+	auto ReadItem = [&Reader, &ClassRemap](FShooterItemRecord& Record)
+	{
+		SerializeRecord(Reader, Record);
+		if (Reader.IsError() || !ClassRemap.IsValidIndex(Record.ClassIndex)) return false;
+		Record.ClassIndex = ClassRemap[Record.ClassIndex];
+		return true;
+	};
+
+	int32 NumItems{ 0 };
+	Reader << NumItems;
+	if (!IsValidCount(Reader, NumItems)) return false;
+
+	if (BaseSequence == 0)
+	{
+		Items.SetNum(NumItems);
+		for (FShooterItemRecord& Record : Items)
+		{
+			if (!ReadItem(Record)) return false;
+		}
+	}
+	else
+	{
+		TMap<FName, int32> ItemIndices;
+		ItemIndices.Reserve(Items.Num());
+		for (int32 Index = 0; Index < Items.Num(); ++Index) { ItemIndices.Add(Items[Index].Name, Index); }
+
+		for (int32 Changed = 0; Changed < NumItems; ++Changed)
+		{
+			FShooterItemRecord Record;
+			if (!ReadItem(Record)) return false;
+
+			if (const int32* Index = ItemIndices.Find(Record.Name)) { Items[*Index] = Record; }
+			else { ItemIndices.Add(Record.Name, Items.Add(Record)); }
+		}
+
+		int32 NumRemoved{ 0 };
+		Reader << NumRemoved;
+		if (!IsValidCount(Reader, NumRemoved)) return false;
+
+		TSet<FName> Removed;
+		Removed.Reserve(NumRemoved);
+		for (int32 Index = 0; Index < NumRemoved; ++Index)
+		{
+			FName Name;
+			Reader << Name;
+			Removed.Add(Name);
+		}
+		if (Reader.IsError()) return false;
+
+		if (Removed.Num() > 0) { Items.RemoveAll([&Removed](const FShooterItemRecord& Record) { return Removed.Contains(Record.Name); }); }
+	}
+
+	Sequence = FileSequence;
+	return !Reader.IsError();
+}
+
+bool FShooterSnapshot::ReadHeader(const TArray<uint8>& Bytes, uint32& OutSequence, uint32& OutBaseSequence)
+{
+	FMemoryReader Reader{ Bytes };
+
+	uint32 Magic{ 0 };
+	uint16 Version{ 0 };
+	Reader << Magic << Version << OutSequence << OutBaseSequence;
+	return !Reader.IsError() && Magic == SnapshotMagic && Version == SnapshotVersion;
+}
+
+FString FShooterSnapshot::GetSnapshotPath(const FString& Slot, uint32 Sequence)
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Snapshots"), FString::Printf(TEXT("%s_%u.snap"), *Slot, Sequence));
+}
+
+TArray<uint32> FShooterSnapshot::FindSnapshotSequences(const FString& Slot)
+{
+	TArray<FString> Filenames;
+	IFileManager::Get().FindFiles(Filenames, *FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Snapshots"), Slot + TEXT("_*.snap")), true, false);
+
+	TArray<uint32> Sequences;
+	for (const FString& Filename : Filenames)
+	{
+		// Other slots sharing the prefix don't end in a number
+		const FString SequenceString{ FPaths::GetBaseFilename(Filename).RightChop(Slot.Len() + 1) };
+		if (!SequenceString.IsEmpty() && SequenceString.IsNumeric()) { Sequences.Add(static_cast<uint32>(FCString::Strtoui64(*SequenceString, nullptr, 10))); }
+	}
+	return Sequences;
+}
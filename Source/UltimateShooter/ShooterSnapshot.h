@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Item.h"
+#include "ShooterCharacter.h"
+
+// One AShooterCharacter, matched by actor name on load
+struct FShooterCharacterRecord
+{
+	FName Name;
+	FTransform Transform;
+	TArray<TPair<EAmmoType, int32>> Ammo;
+	ECombatState CombatState{ ECombatState::ECS_Unoccupied };
+	bool bCrouching{ false };
+	// Actor name of the equipped weapon, its ammo is on its item record
+	FName WeaponName;
+};
+
+// One AItem, matched by actor name on load and respawned from its class when missing
+struct FShooterItemRecord
+{
+	FName Name;
+	// Index into FShooterSnapshot::ItemClasses
+	uint16 ClassIndex{ 0 };
+	FTransform Transform;
+	EItemState State{ EItemState::EIS_Pickup };
+	EItemRarity Rarity{ EItemRarity::EIR_Common };
+	int32 Count{ 0 };
+	// Magazine of a weapon, INDEX_NONE for other items
+	int32 Ammo{ INDEX_NONE };
+};
+
+/**
+ * Match state captured on the game thread as plain data, so it can be encoded and written on a worker.
+ * Stored as a versioned binary file: header, item class table, characters, then items. A delta file stores only the items
+ * that changed since its base snapshot and the names of the removed ones, characters are always stored whole.
+ */
+struct FShooterSnapshot
+{
+	uint32 Sequence{ 0 };
+	TArray<FString> ItemClasses;
+	TArray<FShooterCharacterRecord> Characters;
+	TArray<FShooterItemRecord> Items;
+
+	// Full snapshot, or a delta against Base when given
+	void Write(TArray<uint8>& OutBytes, const FShooterSnapshot* Base = nullptr) const;
+	// A delta file is applied on top of this snapshot, which has to be its base
+	bool Read(const TArray<uint8>& Bytes);
+
+	// Sequence of the file and of its base, 0 for a full snapshot
+	static bool ReadHeader(const TArray<uint8>& Bytes, uint32& OutSequence, uint32& OutBaseSequence);
+
+	// Saved/Snapshots/<Slot>_<Sequence>.snap
+	static FString GetSnapshotPath(const FString& Slot, uint32 Sequence);
+	// Sequences of the snapshot files of the slot on disk, unsorted
+	static TArray<uint32> FindSnapshotSequences(const FString& Slot);
+};
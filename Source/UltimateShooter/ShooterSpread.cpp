@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterSpread.h"
+
+namespace
+{
+	float RadicalInverse(uint32 Index, uint32 Base)
+	{
+		const float InvBase{ 1.f / Base };
+		float Fraction{ InvBase };
+		float Result{ 0.f };
+		while (Index > 0)
+		{
+			Result += Fraction * (Index % Base);
+			Index /= Base;
+			Fraction *= InvBase;
+		}
+		return Result;
+	}
+
+	struct FSpreadTable
+	{
+		FVector2f Samples[ShooterSpread::TableSize];
+
+		FSpreadTable()
+		{
+			// sqrt on the radius keeps the points evenly spread over the disk area
+			for (uint32 Index = 0; Index < ShooterSpread::TableSize; ++Index)
+			{
+				const float Radius{ FMath::Sqrt(RadicalInverse(Index, 2)) };
+				const float Angle{ UE_TWO_PI * RadicalInverse(Index, 3) };
+				Samples[Index] = FVector2f(Radius * FMath::Cos(Angle), Radius * FMath::Sin(Angle));
+			}
+		}
+	};
+
+	const FSpreadTable& GetSpreadTable()
+	{
+		static const FSpreadTable Table;
+		return Table;
+	}
+}
+
+const FVector2f& ShooterSpread::GetDiskSample(uint32 Index)
+{
+	return GetSpreadTable().Samples[Index & (TableSize - 1)];
+}
+
+FVector ShooterSpread::GetSpreadDirection(const FVector& AimDirection, float HalfAngleDegrees, uint32 Index)
+{
+	if (HalfAngleDegrees <= 0.f) return AimDirection;
+
+	FVector Right, Up;
+	AimDirection.FindBestAxisVectors(Right, Up);
+
+	const FVector2f& Sample = GetDiskSample(Index);
+	const double Tangent{ FMath::Tan(FMath::DegreesToRadians(FMath::Min(HalfAngleDegrees, 89.f))) };
+	return (AimDirection + (Right * Sample.X + Up * Sample.Y) * Tangent).GetSafeNormal();
+}
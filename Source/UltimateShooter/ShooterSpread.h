@@ -0,0 +1,22 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Shot spread from a fixed table of Halton (2, 3) points on the unit disk.
+ * A ray direction only depends on the aim, the spread angle and the sample index, so anyone knowing
+ * the weapon shot counter can rebuild every pellet without random numbers.
+ */
+namespace ShooterSpread
+{
+	// Power of two, sample indices wrap around
+	constexpr uint32 TableSize{ 256 };
+
+	// Point of the unit disk, index 0 is the center
+	ULTIMATESHOOTER_API const FVector2f& GetDiskSample(uint32 Index);
+
+	// AimDirection pushed inside the cone of the given half angle by the disk sample
+	ULTIMATESHOOTER_API FVector GetSpreadDirection(const FVector& AimDirection, float HalfAngleDegrees, uint32 Index);
+}
@@ -0,0 +1,326 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterStatsEndpointSubsystem.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "NiagaraComponent.h"
+#include "ShooterCharacter.h"
+#include "ShooterHealthComponent.h"
+#include "ShooterCrowdSubsystem.h"
+#include "Weapon.h"
+#include "UltimateShooterGameModeBase.h"
+
+#if WITH_SHOOTER_STATS_ENDPOINT
+#include "Common/TcpListener.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+#endif
+
+#include "UltimateShooter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Stats Endpoint Publish"), STAT_StatsEndpointPublish, STATGROUP_UltimateShooter);
+
+bool UShooterStatsEndpointSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	return WITH_SHOOTER_STATS_ENDPOINT && Super::ShouldCreateSubsystem(Outer);
+}
+
+bool UShooterStatsEndpointSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+UShooterStatsEndpointSubsystem* UShooterStatsEndpointSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UShooterStatsEndpointSubsystem>() : nullptr;
+}
+
+TStatId UShooterStatsEndpointSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterStatsEndpointSubsystem, STATGROUP_Tickables);
+}
+
+void UShooterStatsEndpointSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	int32 ListenPort{ Port };
+	FParse::Value(FCommandLine::Get(), TEXT("ShooterStatsPort="), ListenPort);
+	if (ListenPort > 0) { StartListening(ListenPort); }
+}
+
+void UShooterStatsEndpointSubsystem::Deinitialize()
+{
+	StopListening();
+
+	Super::Deinitialize();
+}
+
+bool UShooterStatsEndpointSubsystem::StartListening(int32 InPort)
+{
+#if WITH_SHOOTER_STATS_ENDPOINT
+	if (Listener) return false;
+
+	FrameTimesMs.Reset(FrameWindow);
+	NextFrameTime = 0;
+	TimeToPublish = 0.f;
+	TimeToGatherMemory = 0.f;
+
+	// Loopback only, nothing outside the machine can reach it
+	const FIPv4Endpoint Endpoint{ FIPv4Address{ 127, 0, 0, 1 }, static_cast<uint16>(InPort) };
+	Listener = new FTcpListener{ Endpoint, FTimespan::FromMilliseconds(100), false };
+	Listener->OnConnectionAccepted().BindUObject(this, &UShooterStatsEndpointSubsystem::OnConnectionAccepted);
+	if (!Listener->IsActive())
+	{
+		UE_LOG(LogUltimateShooter, Warning, TEXT("Stats endpoint could not listen on %s"), *Endpoint.ToString());
+		StopListening();
+		return false;
+	}
+
+	UE_LOG(LogUltimateShooter, Log, TEXT("Stats endpoint on http://%s/"), *Endpoint.ToString());
+	return true;
+#else
+	return false;
+#endif
+}
+
+void UShooterStatsEndpointSubsystem::StopListening()
+{
+#if WITH_SHOOTER_STATS_ENDPOINT
+	// Joins the listener thread, no request is answered after this
+	delete Listener;
+	Listener = nullptr;
+#endif
+}
+
+void UShooterStatsEndpointSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!Listener) return;
+
+	const float FrameMs{ static_cast<float>(FApp::GetDeltaTime() * 1000.0) };
+	if (FrameTimesMs.Num() < FrameWindow) { FrameTimesMs.Add(FrameMs); }
+	else
+	{
+		FrameTimesMs[NextFrameTime] = FrameMs;
+		NextFrameTime = (NextFrameTime + 1) % FrameWindow;
+	}
+
+	TimeToPublish -= DeltaTime;
+	if (TimeToPublish > 0.f) return;
+	TimeToPublish = PublishInterval;
+
+	PublishSnapshot();
+}
+
+void UShooterStatsEndpointSubsystem::PublishSnapshot()
+{
+	SCOPE_CYCLE_COUNTER(STAT_StatsEndpointPublish);
+
+	UWorld* World = GetWorld();
+	// Only the listener thread reads the front buffer, the back one is ours
+	FStatsSnapshot& Snapshot = Buffers[1 - FrontBuffer];
+	Snapshot = FStatsSnapshot{};
+
+	Snapshot.FrameNumber = GFrameCounter;
+	Snapshot.WorldTime = World->GetTimeSeconds();
+	Snapshot.FrameTimesMs = FrameTimesMs;
+
+	// Pawns
+	for (TActorIterator<APawn> It(World); It; ++It)
+	{
+		++Snapshot.NumPawns;
+
+		const AShooterCharacter* Character = Cast<AShooterCharacter>(*It);
+		if (!Character) continue;
+
+		++Snapshot.NumCharacters;
+		if (Character->GetHealthComponent() && Character->GetHealthComponent()->IsDead()) { ++Snapshot.NumDeadCharacters; }
+		if (Character->GetCombatState() == ECombatState::ECS_FireTimerInProgress) { ++Snapshot.NumAutoFireTimers; }
+	}
+
+	// Items
+	for (TActorIterator<AItem> It(World); It; ++It)
+	{
+		const EItemState State{ It->GetItemState() };
+		++Snapshot.ItemsByState[static_cast<int32>(State)];
+
+		if (State == EItemState::EIS_EquipInterping) { ++Snapshot.NumItemInterpTimers; }
+		else if (State == EItemState::EIS_Falling && Cast<AWeapon>(*It)) { ++Snapshot.NumWeaponThrowTimers; }
+	}
+	if (const UItemBudgetSubsystem* ItemBudget = World->GetSubsystem<UItemBudgetSubsystem>())
+	{
+		Snapshot.NumBudgetItems = ItemBudget->GetNumTrackedItems();
+		Snapshot.BudgetItemBytes = ItemBudget->GetTrackedBytes();
+	}
+
+	// Effects, spawned emitters are owned by the world settings so the world's actors cover them all
+	for (TActorIterator<AActor> It(World); It; ++It)
+	{
+		It->ForEachComponent<UFXSystemComponent>(false, [&Snapshot](const UFXSystemComponent* Component)
+		{
+			if (!Component->IsActive()) return;
+			if (Component->IsA<UParticleSystemComponent>()) { ++Snapshot.NumActiveCascade; }
+			else if (Component->IsA<UNiagaraComponent>()) { ++Snapshot.NumActiveNiagara; }
+		});
+	}
+
+	// Pools
+	if (const AUltimateShooterGameModeBase* GameMode = World->GetAuthGameMode<AUltimateShooterGameModeBase>())
+	{
+		Snapshot.NumFreeEnemies = GameMode->GetNumFreeEnemies();
+		Snapshot.NumActiveEnemies = GameMode->GetNumActiveEnemies();
+		Snapshot.NumDeadEnemies = GameMode->GetNumDeadEnemies();
+	}
+	if (const UShooterCrowdSubsystem* Crowd = UShooterCrowdSubsystem::Get(World))
+	{
+		Snapshot.NumCrowdPromoted = Crowd->GetNumPromoted();
+		Snapshot.NumCrowdFreeActors = Crowd->GetNumFreeActors();
+	}
+
+	// Item memory
+	TimeToGatherMemory -= PublishInterval;
+	if (TimeToGatherMemory <= 0.f)
+	{
+		TimeToGatherMemory = MemoryInterval;
+
+		TMap<UClass*, FItemClassMemoryStats> MemoryStats;
+		UItemBudgetSubsystem::GatherItemMemoryStats(World, MemoryStats);
+		ItemMemory.Reset(MemoryStats.Num());
+		for (const TPair<UClass*, FItemClassMemoryStats>& Pair : MemoryStats)
+		{
+			FItemClassStats& ClassStats = ItemMemory.AddDefaulted_GetRef();
+			ClassStats.ClassName = Pair.Key->GetName();
+			ClassStats.Memory = Pair.Value;
+		}
+	}
+	Snapshot.ItemMemory = ItemMemory;
+
+	FScopeLock Lock{ &FrontBufferLock };
+	FrontBuffer = 1 - FrontBuffer;
+}
+
+#if WITH_SHOOTER_STATS_ENDPOINT
+
+static void SendAll(FSocket* Socket, const uint8* Data, int32 Count)
+{
+	while (Count > 0)
+	{
+		int32 BytesSent{ 0 };
+		if (!Socket->Send(Data, Count, BytesSent) || BytesSent <= 0) return;
+		Data += BytesSent;
+		Count -= BytesSent;
+	}
+}
+
+bool UShooterStatsEndpointSubsystem::OnConnectionAccepted(FSocket* Socket, const FIPv4Endpoint& Endpoint)
+{
+	// Every path gets the snapshot, the request is only drained
+	if (Socket->Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromMilliseconds(250)))
+	{
+		uint8 Request[1024];
+		int32 BytesRead{ 0 };
+		Socket->Recv(Request, sizeof(Request), BytesRead);
+	}
+
+	FStatsSnapshot Snapshot;
+	{
+		FScopeLock Lock{ &FrontBufferLock };
+		Snapshot = Buffers[FrontBuffer];
+	}
+
+	const FTCHARToUTF8 Body{ *BuildJson(Snapshot) };
+	const FTCHARToUTF8 Header{ *FString::Printf(TEXT("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: %d\r\nConnection: close\r\n\r\n"), Body.Length()) };
+	SendAll(Socket, reinterpret_cast<const uint8*>(Header.Get()), Header.Length());
+	SendAll(Socket, reinterpret_cast<const uint8*>(Body.Get()), Body.Length());
+
+	Socket->Close();
+	ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+	return true;
+}
+
+FString UShooterStatsEndpointSubsystem::BuildJson(const FStatsSnapshot& Snapshot)
+{
+	static const TCHAR* ItemStateNames[]{ TEXT("Pickup"), TEXT("EquipInterping"), TEXT("PickedUp"), TEXT("Equipped"), TEXT("Falling") };
+	static_assert(UE_ARRAY_COUNT(ItemStateNames) == static_cast<int32>(EItemState::EIS_MAX), "One name per item state");
+
+	TSharedRef<FJsonObject> Root{ MakeShared<FJsonObject>() };
+	Root->SetNumberField(TEXT("frame"), static_cast<double>(Snapshot.FrameNumber));
+	Root->SetNumberField(TEXT("worldTime"), Snapshot.WorldTime);
+
+	TArray<float> Sorted{ Snapshot.FrameTimesMs };
+	Sorted.Sort();
+	TSharedRef<FJsonObject> FrameTime{ MakeShared<FJsonObject>() };
+	FrameTime->SetNumberField(TEXT("samples"), Sorted.Num());
+	if (Sorted.Num() > 0)
+	{
+		double TotalMs{ 0.0 };
+		for (const float FrameMs : Sorted) { TotalMs += FrameMs; }
+		FrameTime->SetNumberField(TEXT("avg"), TotalMs / Sorted.Num());
+		FrameTime->SetNumberField(TEXT("p50"), Sorted[Sorted.Num() / 2]);
+		FrameTime->SetNumberField(TEXT("p90"), Sorted[FMath::Min(Sorted.Num() * 90 / 100, Sorted.Num() - 1)]);
+		FrameTime->SetNumberField(TEXT("p99"), Sorted[FMath::Min(Sorted.Num() * 99 / 100, Sorted.Num() - 1)]);
+		FrameTime->SetNumberField(TEXT("max"), Sorted.Last());
+	}
+	Root->SetObjectField(TEXT("frameTimeMs"), FrameTime);
+
+	TSharedRef<FJsonObject> Pawns{ MakeShared<FJsonObject>() };
+	Pawns->SetNumberField(TEXT("total"), Snapshot.NumPawns);
+	Pawns->SetNumberField(TEXT("shooterCharacters"), Snapshot.NumCharacters);
+	Pawns->SetNumberField(TEXT("dead"), Snapshot.NumDeadCharacters);
+	Root->SetObjectField(TEXT("pawns"), Pawns);
+
+	TSharedRef<FJsonObject> Items{ MakeShared<FJsonObject>() };
+	for (int32 State = 0; State < static_cast<int32>(EItemState::EIS_MAX); ++State) { Items->SetNumberField(ItemStateNames[State], Snapshot.ItemsByState[State]); }
+	Items->SetNumberField(TEXT("budgetTracked"), Snapshot.NumBudgetItems);
+	Items->SetNumberField(TEXT("budgetBytes"), static_cast<double>(Snapshot.BudgetItemBytes));
+	Root->SetObjectField(TEXT("items"), Items);
+
+	TSharedRef<FJsonObject> Effects{ MakeShared<FJsonObject>() };
+	Effects->SetNumberField(TEXT("activeCascade"), Snapshot.NumActiveCascade);
+	Effects->SetNumberField(TEXT("activeNiagara"), Snapshot.NumActiveNiagara);
+	Root->SetObjectField(TEXT("effects"), Effects);
+
+	TSharedRef<FJsonObject> Pools{ MakeShared<FJsonObject>() };
+	Pools->SetNumberField(TEXT("enemiesFree"), Snapshot.NumFreeEnemies);
+	Pools->SetNumberField(TEXT("enemiesActive"), Snapshot.NumActiveEnemies);
+	Pools->SetNumberField(TEXT("enemiesDead"), Snapshot.NumDeadEnemies);
+	Pools->SetNumberField(TEXT("crowdPromoted"), Snapshot.NumCrowdPromoted);
+	Pools->SetNumberField(TEXT("crowdFreeActors"), Snapshot.NumCrowdFreeActors);
+	Root->SetObjectField(TEXT("pools"), Pools);
+
+	TSharedRef<FJsonObject> Timers{ MakeShared<FJsonObject>() };
+	Timers->SetNumberField(TEXT("itemInterp"), Snapshot.NumItemInterpTimers);
+	Timers->SetNumberField(TEXT("weaponThrow"), Snapshot.NumWeaponThrowTimers);
+	Timers->SetNumberField(TEXT("autoFire"), Snapshot.NumAutoFireTimers);
+	Root->SetObjectField(TEXT("timers"), Timers);
+
+	TArray<TSharedPtr<FJsonValue>> ItemMemory;
+	for (const FItemClassStats& ClassStats : Snapshot.ItemMemory)
+	{
+		TSharedRef<FJsonObject> Class{ MakeShared<FJsonObject>() };
+		Class->SetStringField(TEXT("class"), ClassStats.ClassName);
+		Class->SetNumberField(TEXT("instances"), ClassStats.Memory.NumInstances);
+		Class->SetNumberField(TEXT("components"), ClassStats.Memory.NumComponents);
+		Class->SetNumberField(TEXT("bytes"), static_cast<double>(ClassStats.Memory.Bytes));
+		ItemMemory.Add(MakeShared<FJsonValueObject>(Class));
+	}
+	Root->SetArrayField(TEXT("itemMemory"), ItemMemory);
+
+	FString Json;
+	const TSharedRef<TJsonWriter<>> Writer{ TJsonWriterFactory<>::Create(&Json) };
+	FJsonSerializer::Serialize(Root, Writer);
+	return Json;
+}
+
+#endif
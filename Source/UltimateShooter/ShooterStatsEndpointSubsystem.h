@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HAL/CriticalSection.h"
+#include "Item.h"
+#include "ItemBudgetSubsystem.h"
+#include "ShooterStatsEndpointSubsystem.generated.h"
+
+class FSocket;
+class FTcpListener;
+struct FIPv4Endpoint;
+
+/**
+ * Localhost only HTTP endpoint with a JSON snapshot of the gameplay load, for soak tests of headless instances.
+ * Start with -ShooterStatsPort=<Port> and poll http://127.0.0.1:<Port>/. The game thread only fills the back buffer of a
+ * double buffered snapshot every PublishInterval, requests are answered on the listener thread from the front buffer.
+ * Not built in Shipping.
+ */
+UCLASS(Config = Game)
+class ULTIMATESHOOTER_API UShooterStatsEndpointSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	static UShooterStatsEndpointSubsystem* Get(const UObject* WorldContextObject);
+
+	bool StartListening(int32 InPort);
+	void StopListening();
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	// Game thread, fills the back buffer and swaps it in
+	void PublishSnapshot();
+
+	struct FItemClassStats
+	{
+		FString ClassName;
+		FItemClassMemoryStats Memory;
+	};
+
+	struct FStatsSnapshot
+	{
+		uint64 FrameNumber{ 0 };
+		double WorldTime{ 0.0 };
+		// Unsorted, percentiles are computed by the listener thread
+		TArray<float> FrameTimesMs;
+
+		int32 NumPawns{ 0 };
+		int32 NumCharacters{ 0 };
+		int32 NumDeadCharacters{ 0 };
+
+		int32 ItemsByState[static_cast<int32>(EItemState::EIS_MAX)]{};
+		int32 NumBudgetItems{ 0 };
+		int64 BudgetItemBytes{ 0 };
+
+		int32 NumActiveCascade{ 0 };
+		int32 NumActiveNiagara{ 0 };
+
+		int32 NumFreeEnemies{ 0 };
+		int32 NumActiveEnemies{ 0 };
+		int32 NumDeadEnemies{ 0 };
+		int32 NumCrowdPromoted{ 0 };
+		int32 NumCrowdFreeActors{ 0 };
+
+		// FTimerManager has no public count, these are the gameplay timers the state tells about
+		int32 NumItemInterpTimers{ 0 };
+		int32 NumWeaponThrowTimers{ 0 };
+		int32 NumAutoFireTimers{ 0 };
+
+		TArray<FItemClassStats> ItemMemory;
+	};
+
+	// Listener thread
+	bool OnConnectionAccepted(FSocket* Socket, const FIPv4Endpoint& Endpoint);
+	static FString BuildJson(const FStatsSnapshot& Snapshot);
+
+private:
+	FStatsSnapshot Buffers[2];
+	int32 FrontBuffer{ 0 };
+	// Held for the swap on the game thread and the copy on the listener thread, nothing else
+	FCriticalSection FrontBufferLock;
+
+	// Ring of the last FrameWindow frame times
+	TArray<float> FrameTimesMs;
+	int32 NextFrameTime{ 0 };
+
+	float TimeToPublish{ 0.f };
+	float TimeToGatherMemory{ 0.f };
+	// Walks every item component, gathered less often than the rest
+	TArray<FItemClassStats> ItemMemory;
+
+	FTcpListener* Listener{ nullptr };
+
+	// 0 keeps the endpoint off, -ShooterStatsPort=<Port> overrides
+	UPROPERTY(Config)
+	int32 Port{ 0 };
+	// Seconds between snapshots
+	UPROPERTY(Config)
+	float PublishInterval{ 1.f };
+	// Seconds between item memory gathers
+	UPROPERTY(Config)
+	float MemoryInterval{ 10.f };
+	// Frames in the frame time percentiles
+	UPROPERTY(Config)
+	int32 FrameWindow{ 600 };
+};
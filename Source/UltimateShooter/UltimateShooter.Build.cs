@@ -10,10 +10,27 @@ public class UltimateShooter : ModuleRules
 	
 		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "EnhancedInput", "UMG" });
 
-		PrivateDependencyModuleNames.AddRange(new string[] {  });
+		PrivateDependencyModuleNames.AddRange(new string[] { "Niagara" });
 
-		// Uncomment if you are using Slate UI
-		// PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore" });
+		// Game thread time of the frame governor
+		PrivateDependencyModuleNames.AddRange(new string[] { "RenderCore" });
+
+		// Slate UI, used by the native HUD widgets
+		PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore" });
+
+		// Mass Entity, used by the crowd combatants
+		PublicDependencyModuleNames.AddRange(new string[] { "MassEntity", "MassCommon", "MassSpawner" });
+
+		// AI controller of the promoted crowd combatants
+		PublicDependencyModuleNames.AddRange(new string[] { "AIModule", "GameplayTasks" });
+
+		// Localhost stats endpoint of soak tests, left out of Shipping
+		bool bWithStatsEndpoint = Target.Configuration != UnrealTargetConfiguration.Shipping;
+		PublicDefinitions.Add("WITH_SHOOTER_STATS_ENDPOINT=" + (bWithStatsEndpoint ? "1" : "0"));
+		if (bWithStatsEndpoint)
+		{
+			PrivateDependencyModuleNames.AddRange(new string[] { "Sockets", "Networking", "Json" });
+		}
 		
 		// Uncomment if you are using online features
 		// PrivateDependencyModuleNames.Add("OnlineSubsystem");
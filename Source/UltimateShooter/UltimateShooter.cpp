@@ -3,4 +3,8 @@
 #include "UltimateShooter.h"
 #include "Modules/ModuleManager.h"
 
+DEFINE_LOG_CATEGORY(LogUltimateShooter);
+
+CSV_DEFINE_CATEGORY_MODULE(ULTIMATESHOOTER_API, ShooterGameplay, true);
+
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, UltimateShooter, "UltimateShooter" );
@@ -3,4 +3,12 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CsvProfiler.h"
 
+DECLARE_LOG_CATEGORY_EXTERN(LogUltimateShooter, Log, All);
+
+DECLARE_STATS_GROUP(TEXT("UltimateShooter"), STATGROUP_UltimateShooter, STATCAT_Advanced);
+
+// Per frame gameplay counters of csvprofile captures
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(ULTIMATESHOOTER_API, ShooterGameplay);
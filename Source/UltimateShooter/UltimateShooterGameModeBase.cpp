@@ -2,4 +2,226 @@
 
 
 #include "UltimateShooterGameModeBase.h"
+#include "GameFramework/PlayerStart.h"
+#include "Kismet/GameplayStatics.h"
+#include "ShooterCharacter.h"
+#include "ShooterDamageSubsystem.h"
+#include "ShooterPawnPoolSubsystem.h"
 
+#include "UltimateShooter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Wave Prewarm"), STAT_WavePrewarm, STATGROUP_UltimateShooter);
+DECLARE_CYCLE_STAT(TEXT("Wave Activate"), STAT_WaveActivate, STATGROUP_UltimateShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Wave Enemies Active"), STAT_WaveEnemiesActive, STATGROUP_UltimateShooter);
+
+AUltimateShooterGameModeBase::AUltimateShooterGameModeBase() :
+	bWavesEnabled(false), PoolSize(64), PrewarmPerTick(4), FirstWaveSize(50), WaveSizeGrowth(10), TimeBetweenWaves(5.f), ActivationsPerTick(4),
+	DeathLingerTime(3.f), NextSpawnPoint(0), CurrentWave(0), PendingActivations(0),
+	PrewarmRemaining(0), NextWaveTime(0.f), bWaveInProgress(false), TotalReused(0), TotalColdSpawns(0)
+{
+	PrimaryActorTick.bCanEverTick = true;
+}
+
+void AUltimateShooterGameModeBase::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (!AreWavesEnabled())
+	{
+		SetActorTickEnabled(false);
+		return;
+	}
+
+	UGameplayStatics::GetAllActorsOfClass(this, APlayerStart::StaticClass(), SpawnPoints);
+
+	if (UShooterDamageSubsystem* Damage = UShooterDamageSubsystem::Get(this))
+	{
+		KilledHandle = Damage->OnKilled().AddUObject(this, &AUltimateShooterGameModeBase::OnEnemyKilled);
+	}
+
+	PrewarmRemaining = FMath::Max(PoolSize - GetNumFreeEnemies(), 0);
+	ActiveEnemies.Reserve(PoolSize);
+	NextWaveTime = GetWorld()->GetTimeSeconds() + TimeBetweenWaves;
+}
+
+void AUltimateShooterGameModeBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UShooterDamageSubsystem* Damage = UShooterDamageSubsystem::Get(this))
+	{
+		Damage->OnKilled().Remove(KilledHandle);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AUltimateShooterGameModeBase::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	ReleaseDeadEnemies();
+
+	// No waves until the pool is ready
+	if (PrewarmRemaining > 0)
+	{
+		PrewarmPool(FMath::Min(PrewarmPerTick, PrewarmRemaining));
+	}
+	else if (PendingActivations > 0)
+	{
+		ActivatePendingEnemies();
+	}
+	else if (bWaveInProgress && ActiveEnemies.Num() == 0)
+	{
+		bWaveInProgress = false;
+		NextWaveTime = GetWorld()->GetTimeSeconds() + TimeBetweenWaves;
+	}
+	else if (!bWaveInProgress && GetWorld()->GetTimeSeconds() >= NextWaveTime)
+	{
+		StartWave();
+	}
+
+	SET_DWORD_STAT(STAT_WaveEnemiesActive, ActiveEnemies.Num());
+}
+
+void AUltimateShooterGameModeBase::PrewarmPool(int32 Count)
+{
+	SCOPE_CYCLE_COUNTER(STAT_WavePrewarm);
+
+	PrewarmRemaining -= Count;
+	if (UShooterPawnPoolSubsystem* Pool = UShooterPawnPoolSubsystem::Get(this)) { Pool->Prewarm(EnemyClass, Count); }
+
+	if (PrewarmRemaining == 0)
+	{
+		UE_LOG(LogUltimateShooter, Log, TEXT("Wave pool ready: %d enemies"), GetNumFreeEnemies());
+	}
+}
+
+int32 AUltimateShooterGameModeBase::GetNumFreeEnemies() const
+{
+	const UShooterPawnPoolSubsystem* Pool = UShooterPawnPoolSubsystem::Get(this);
+	return Pool && EnemyClass ? Pool->GetNumFree(EnemyClass) : 0;
+}
+
+void AUltimateShooterGameModeBase::StartWave()
+{
+	++CurrentWave;
+	bWaveInProgress = true;
+	PendingActivations = FirstWaveSize + (CurrentWave - 1) * WaveSizeGrowth;
+
+	WaveStats = FWaveStats{};
+	WaveStats.StartTime = FPlatformTime::Seconds();
+
+	UE_LOG(LogUltimateShooter, Log, TEXT("Wave %d: %d enemies, %d pooled"), CurrentWave, PendingActivations, GetNumFreeEnemies());
+}
+
+void AUltimateShooterGameModeBase::ActivatePendingEnemies()
+{
+	SCOPE_CYCLE_COUNTER(STAT_WaveActivate);
+
+	UShooterPawnPoolSubsystem* Pool = UShooterPawnPoolSubsystem::Get(this);
+	if (!Pool) return;
+
+	const int32 Count{ FMath::Min(ActivationsPerTick, PendingActivations) };
+	for (int32 i = 0; i < Count; ++i)
+	{
+		const double StartTime{ FPlatformTime::Seconds() };
+		const FTransform SpawnTransform{ GetNextSpawnTransform() };
+
+		bool bReused{ false };
+		AShooterCharacter* Enemy{ Pool->Acquire(EnemyClass, nullptr, &bReused) };
+		--PendingActivations;
+
+		if (!Enemy) continue;
+		if (bReused) { ++WaveStats.Reused; }
+		else
+		{
+			// Pool ran dry, the wave outgrew it
+			++WaveStats.ColdSpawns;
+			WaveStats.ColdSpawnMs += (FPlatformTime::Seconds() - StartTime) * 1000.0;
+		}
+		ActivateEnemy(Enemy, SpawnTransform);
+
+		const double ElapsedMs{ (FPlatformTime::Seconds() - StartTime) * 1000.0 };
+		WaveStats.ActivateMs += ElapsedMs;
+		WaveStats.MaxActivateMs = FMath::Max(WaveStats.MaxActivateMs, ElapsedMs);
+	}
+
+	if (PendingActivations == 0)
+	{
+		WaveStats.RampMs = (FPlatformTime::Seconds() - WaveStats.StartTime) * 1000.0;
+		TotalReused += WaveStats.Reused;
+		TotalColdSpawns += WaveStats.ColdSpawns;
+		LogWaveStats();
+	}
+}
+
+void AUltimateShooterGameModeBase::ActivateEnemy(AShooterCharacter* Enemy, const FTransform& SpawnTransform)
+{
+	Enemy->ResetForReuse();
+	Enemy->SetActorLocationAndRotation(SpawnTransform.GetLocation(), SpawnTransform.GetRotation(), false, nullptr, ETeleportType::ResetPhysics);
+	Enemy->SetPooled(false);
+	ActiveEnemies.Add(Enemy);
+}
+
+void AUltimateShooterGameModeBase::ReleaseEnemy(AShooterCharacter* Enemy)
+{
+	if (UShooterPawnPoolSubsystem* Pool = UShooterPawnPoolSubsystem::Get(this)) { Pool->Release(Enemy); }
+}
+
+void AUltimateShooterGameModeBase::ReleaseDeadEnemies()
+{
+	const float Now{ GetWorld()->GetTimeSeconds() };
+	for (int32 i = DeadEnemies.Num() - 1; i >= 0; --i)
+	{
+		if (DeadReleaseTimes[i] > Now) continue;
+
+		if (DeadEnemies[i]) { ReleaseEnemy(DeadEnemies[i]); }
+		DeadEnemies.RemoveAtSwap(i, 1, false);
+		DeadReleaseTimes.RemoveAtSwap(i, 1, false);
+	}
+}
+
+FTransform AUltimateShooterGameModeBase::GetNextSpawnTransform()
+{
+	const int32 SpawnIndex{ NextSpawnPoint++ };
+
+	FVector Location{ FVector::ZeroVector };
+	FRotator Rotation{ FRotator::ZeroRotator };
+	if (SpawnPoints.Num() > 0)
+	{
+		const AActor* SpawnPoint{ SpawnPoints[SpawnIndex % SpawnPoints.Num()] };
+		Location = SpawnPoint->GetActorLocation();
+		Rotation = SpawnPoint->GetActorRotation();
+	}
+
+	// Spiral around the spawn point so enemies sharing it don't stack
+	const int32 Slot{ (SpawnIndex / FMath::Max(SpawnPoints.Num(), 1)) % 32 };
+	const float Angle{ Slot * 2.39996f };   // Golden angle
+	const float Radius{ 120.f * FMath::Sqrt(static_cast<float>(Slot)) };
+	Location += FVector{ FMath::Cos(Angle) * Radius, FMath::Sin(Angle) * Radius, 0.f };
+
+	return FTransform{ Rotation, Location };
+}
+
+void AUltimateShooterGameModeBase::OnEnemyKilled(AActor* Victim, AActor* Killer)
+{
+	AShooterCharacter* Enemy{ Cast<AShooterCharacter>(Victim) };
+	if (!Enemy || ActiveEnemies.RemoveSwap(Enemy, false) == 0) return;
+
+	if (AController* EnemyController = Enemy->GetController()) { EnemyController->StopMovement(); }
+
+	DeadEnemies.Add(Enemy);
+	DeadReleaseTimes.Add(GetWorld()->GetTimeSeconds() + DeathLingerTime);
+}
+
+void AUltimateShooterGameModeBase::LogWaveStats() const
+{
+	const int32 Activated{ WaveStats.Reused + WaveStats.ColdSpawns };
+	const int32 TotalActivated{ TotalReused + TotalColdSpawns };
+
+	UE_LOG(LogUltimateShooter, Log,
+		TEXT("Wave %d in: %d enemies over %.1f ms, activation avg %.3f ms max %.3f ms, %d reused, %d cold spawns (avg %.3f ms), pool reuse %.1f%% over the match"),
+		CurrentWave, Activated, WaveStats.RampMs,
+		Activated > 0 ? WaveStats.ActivateMs / Activated : 0.0, WaveStats.MaxActivateMs,
+		WaveStats.Reused, WaveStats.ColdSpawns, WaveStats.ColdSpawns > 0 ? WaveStats.ColdSpawnMs / WaveStats.ColdSpawns : 0.0,
+		TotalActivated > 0 ? 100.0 * TotalReused / TotalActivated : 0.0);
+}
@@ -6,12 +6,115 @@
 #include "GameFramework/GameModeBase.h"
 #include "UltimateShooterGameModeBase.generated.h"
 
+class AShooterCharacter;
+
 /**
- * 
+ * Wave based match. Enemies come from the pawn pool (UShooterPawnPoolSubsystem), prewarmed before the first wave,
+ * dead enemies are reset and parked back in the pool instead of being destroyed.
+ * Off unless bWavesEnabled is set and EnemyClass is a full enemy (mesh, anim BP, weapon and AI).
  */
 UCLASS()
 class ULTIMATESHOOTER_API AUltimateShooterGameModeBase : public AGameModeBase
 {
 	GENERATED_BODY()
-	
+
+public:
+	AUltimateShooterGameModeBase();
+
+	virtual void Tick(float DeltaTime) override;
+
+	FORCEINLINE int32 GetCurrentWave() const { return CurrentWave; }
+	FORCEINLINE int32 GetNumActiveEnemies() const { return ActiveEnemies.Num(); }
+	int32 GetNumFreeEnemies() const;
+	FORCEINLINE int32 GetNumDeadEnemies() const { return DeadEnemies.Num(); }
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Spawns up to Count pooled enemies, parked and frozen
+	void PrewarmPool(int32 Count);
+
+	void StartWave();
+	// Brings the next enemies of the wave in, a few per tick
+	void ActivatePendingEnemies();
+	void ActivateEnemy(AShooterCharacter* Enemy, const FTransform& SpawnTransform);
+	void ReleaseEnemy(AShooterCharacter* Enemy);
+	void ReleaseDeadEnemies();
+
+	FTransform GetNextSpawnTransform();
+
+	void OnEnemyKilled(AActor* Victim, AActor* Killer);
+
+	void LogWaveStats() const;
+
+	bool AreWavesEnabled() const { return bWavesEnabled && EnemyClass; }
+
+private:
+	// The game mode is the default of every map, only wave maps turn this on
+	UPROPERTY(Config, EditDefaultsOnly, Category = Waves, meta = (AllowPrivateAccess = "true"))
+	bool bWavesEnabled;
+
+	UPROPERTY(EditDefaultsOnly, Category = Waves, meta = (AllowPrivateAccess = "true"))
+	TSubclassOf<AShooterCharacter> EnemyClass;
+
+	// Enemies spawned ahead of the first wave
+	UPROPERTY(EditDefaultsOnly, Category = Waves, meta = (AllowPrivateAccess = "true"))
+	int32 PoolSize;
+
+	// Pool spawns per tick while prewarming, keeps the load spread over a few frames
+	UPROPERTY(EditDefaultsOnly, Category = Waves, meta = (AllowPrivateAccess = "true"))
+	int32 PrewarmPerTick;
+
+	UPROPERTY(EditDefaultsOnly, Category = Waves, meta = (AllowPrivateAccess = "true"))
+	int32 FirstWaveSize;
+
+	UPROPERTY(EditDefaultsOnly, Category = Waves, meta = (AllowPrivateAccess = "true"))
+	int32 WaveSizeGrowth;
+
+	UPROPERTY(EditDefaultsOnly, Category = Waves, meta = (AllowPrivateAccess = "true"))
+	float TimeBetweenWaves;
+
+	// Enemies brought in per tick during a wave
+	UPROPERTY(EditDefaultsOnly, Category = Waves, meta = (AllowPrivateAccess = "true"))
+	int32 ActivationsPerTick;
+
+	// Time a dead enemy stays in the level before going back to the pool
+	UPROPERTY(EditDefaultsOnly, Category = Waves, meta = (AllowPrivateAccess = "true"))
+	float DeathLingerTime;
+
+	UPROPERTY(Transient)
+	TArray<AShooterCharacter*> ActiveEnemies;
+
+	UPROPERTY(Transient)
+	TArray<AShooterCharacter*> DeadEnemies;
+	// World time each dead enemy goes back to the pool, parallel to DeadEnemies
+	TArray<float> DeadReleaseTimes;
+
+	UPROPERTY(Transient)
+	TArray<AActor*> SpawnPoints;
+	int32 NextSpawnPoint;
+
+	int32 CurrentWave;
+	int32 PendingActivations;
+	int32 PrewarmRemaining;
+	float NextWaveTime;
+	bool bWaveInProgress;
+
+	FDelegateHandle KilledHandle;
+
+	struct FWaveStats
+	{
+		int32 Reused{ 0 };
+		int32 ColdSpawns{ 0 };
+		double ActivateMs{ 0.0 };
+		double MaxActivateMs{ 0.0 };
+		double ColdSpawnMs{ 0.0 };
+		// Wave start to last enemy in
+		double StartTime{ 0.0 };
+		double RampMs{ 0.0 };
+	};
+	FWaveStats WaveStats;
+	int32 TotalReused;
+	int32 TotalColdSpawns;
 };
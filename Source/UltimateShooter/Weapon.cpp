@@ -2,34 +2,56 @@
 
 
 #include "Weapon.h"
+#include "PhysicsEngine/BodyInstance.h"
+#include "HAL/IConsoleManager.h"
+#include "ShooterSimulationSubsystem.h"
+#include "ItemBudgetSubsystem.h"
 
-AWeapon::AWeapon()
-	: ThrowWeaponTime(0.7f), bFalling(false), Ammo(30), MagazineCapacity(30), WeaponType(EWeaponType::EWT_SubmachineGun), 
-	AmmoType(EAmmoType::EAT_9mm), ReloadMontageSection(FName(TEXT("ReloadSMG"))), ClipBoneName(FName(TEXT("smg_clip")))
+#include "UltimateShooter.h"
+
+AWeapon::AWeapon(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer), MaxFallingTime(5.f), bFalling(false), Ammo(30), MagazineCapacity(30), WeaponType(EWeaponType::EWT_SubmachineGun), 
+	AmmoType(EAmmoType::EAT_9mm), SpreadAngle(1.5f), ShotCounter(0), ReloadMontageSection(FName(TEXT("ReloadSMG"))), ClipBoneName(FName(TEXT("smg_clip")))
 {
 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
 }
 
+void AWeapon::BeginPlay()
+{
+	Super::BeginPlay();
+
+	GetItemMesh()->OnComponentSleep.AddDynamic(this, &AWeapon::OnItemMeshSleep);
+}
+
 void AWeapon::ThrowWeapon()
 {
 	FRotator MeshRotation{ 0.f, GetItemMesh()->GetComponentRotation().Yaw, 0.f};
 	GetItemMesh()->SetWorldRotation(MeshRotation, false, nullptr, ETeleportType::TeleportPhysics);
 
+	// Let the solver keep the weapon upright instead of teleporting it every tick
+	SetUprightLock(true);
+
 	const FVector MeshForward{ GetItemMesh()->GetForwardVector() };
 	const FVector MeshRight{ GetItemMesh()->GetRightVector() };
 	// Direction in which we throw the Weapon
 	FVector ImpulseDirection = MeshRight.RotateAngleAxis(-20.f, MeshForward);
 
-	float RandomRotation{ FMath::FRandRange(0.f, 30.f) };
+	// Seeded, the same throw on every run of a seed
+	float RandomRotation{ UShooterSimulationSubsystem::GetRandomStream(this).FRandRange(0.f, 30.f) };
 	ImpulseDirection = ImpulseDirection.RotateAngleAxis(RandomRotation, FVector(0.f, 0.f, 1.f));
 	ImpulseDirection *= 8'000.f;
 
 	GetItemMesh()->AddImpulse(ImpulseDirection);
 
 	bFalling = true;
+	CSV_CUSTOM_STAT(ShooterGameplay, WeaponsThrown, 1, ECsvCustomStatOp::Accumulate);
+
+	// Settles in OnItemMeshSleep, the timer is only a fallback
+	GetWorldTimerManager().SetTimer(ThrowWeaponTimer, this, &AWeapon::StopFalling, MaxFallingTime);
 
-	GetWorldTimerManager().SetTimer(ThrowWeaponTimer, this, &AWeapon::StopFalling, ThrowWeaponTime);
+	// Cap the number of weapons simulating at once, freeze the oldest ones
+	if (UItemBudgetSubsystem* ItemBudget = GetWorld()->GetSubsystem<UItemBudgetSubsystem>()) { ItemBudget->AddSimulatingWeapon(this); }
 }
 
 void AWeapon::DecrementAmmo()
@@ -53,18 +75,37 @@ void AWeapon::ReloadAmmo(int32 Amount)
 
 void AWeapon::StopFalling()
 {
+	GetWorldTimerManager().ClearTimer(ThrowWeaponTimer);
+	if (UItemBudgetSubsystem* ItemBudget = GetWorld()->GetSubsystem<UItemBudgetSubsystem>()) { ItemBudget->RemoveSimulatingWeapon(this); }
+
 	bFalling = false;
+	SetUprightLock(false);
 	SetItemState(EItemState::EIS_Pickup);
 }
 
-void AWeapon::Tick(float DeltaTime)
+void AWeapon::SetUprightLock(bool bLock)
 {
-	Super::Tick(DeltaTime);
+	FBodyInstance* Body = GetItemMesh()->GetBodyInstance();
+	if (!Body) return;
 
-	// Keep the Weapon upright
+	Body->bLockXRotation = bLock;
+	Body->bLockYRotation = bLock;
+	Body->SetDOFLock(bLock ? EDOFMode::SixDOF : EDOFMode::None);
+	// Needed for OnComponentSleep
+	Body->bGenerateWakeEvents = true;
+}
+
+void AWeapon::OnItemMeshSleep(UPrimitiveComponent* SleepingComponent, FName BoneName)
+{
 	if (GetItemState() == EItemState::EIS_Falling && bFalling)
 	{
-		FRotator MeshRotation{ 0.f, GetItemMesh()->GetComponentRotation().Yaw, 0.f };
-		GetItemMesh()->SetWorldRotation(MeshRotation, false, nullptr, ETeleportType::TeleportPhysics);
+		StopFalling();
 	}
 }
+
+void AWeapon::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (bFalling) { CSV_CUSTOM_STAT(ShooterGameplay, ItemsSimulatingPhysics, 1, ECsvCustomStatOp::Accumulate); }
+}
@@ -13,11 +13,55 @@ enum class EWeaponType : uint8
 {
 	EWT_SubmachineGun UMETA(DisplayName = "SubmachineGun"),
 	EWT_AssaultRifle UMETA(DisplayName = "AssaultRifle"),
+	EWT_Shotgun UMETA(DisplayName = "Shotgun"),
 
 	EWT_MAX UMETA(DisplayName = "DefaultMAX")
 };
 
 
+// Rays emitted by one trigger pull
+USTRUCT(BlueprintType)
+struct FShotShape
+{
+	GENERATED_BODY()
+
+	// Damage of each pellet
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.0"))
+	float Damage{ 20.f };
+
+	// Rays per shot, spread inside the cone
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "1"))
+	int32 NumPellets{ 1 };
+
+	// Half angle of the pellet cone in degrees
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.0", ClampMax = "45.0"))
+	float ConeHalfAngle{ 0.f };
+
+	// Surfaces a ray can go through before stopping
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0"))
+	int32 MaxPenetrations{ 0 };
+
+	// Thickest surface a ray can go through
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.0"))
+	float MaxPenetrationDepth{ 10.f };
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.0"))
+	float Range{ 50'000.f };
+
+	// Simulated projectile speed, 0 for hitscan
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.0"))
+	float ProjectileSpeed{ 0.f };
+
+	// Scale of the world gravity applied to projectiles
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float ProjectileGravityScale{ 1.f };
+
+	// Seconds before a projectile that hit nothing is removed
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.0"))
+	float ProjectileLifetime{ 3.f };
+};
+
+
 /**
  * 
  */
@@ -27,18 +71,32 @@ class ULTIMATESHOOTER_API AWeapon : public AItem
 	GENERATED_BODY()
 	
 public:
-	AWeapon();
+	AWeapon(const FObjectInitializer& ObjectInitializer);
 
 protected:
-	void StopFalling();
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	// Locks pitch and roll of the physics body so the weapon lands upright
+	void SetUprightLock(bool bLock);
+
+	// Called by physics when the thrown weapon body goes to sleep
+	UFUNCTION()
+	void OnItemMeshSleep(UPrimitiveComponent* SleepingComponent, FName BoneName);
 
 public:
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
+	// Settles the weapon back to pickup state
+	void StopFalling();
+
 private:
+	// Safety timer in case the body never goes to sleep
 	FTimerHandle ThrowWeaponTimer;
-	float ThrowWeaponTime;
+	// Maximum time a thrown weapon simulates before it is frozen in place
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true"))
+	float MaxFallingTime;
 	bool bFalling;
 
 	/** Ammo count for this weapon */
@@ -55,6 +113,16 @@ private:
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true"))
 	EAmmoType AmmoType;
+
+	// Pellets and penetration of every shot
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true"))
+	FShotShape ShotShape;
+	// Spread half angle in degrees for a crosshair spread multiplier of 1
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true", ClampMin = "0.0"))
+	float SpreadAngle;
+	// Shots fired with this weapon, picks the spread samples
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true"))
+	int32 ShotCounter;
  
 	// FName for the reload MontageSection
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true"))
@@ -72,13 +140,19 @@ public:
 	void ThrowWeapon();
 
 	FORCEINLINE int32 GetAmmo() const { return Ammo; }
+	FORCEINLINE bool IsFalling() const { return bFalling; }
 	FORCEINLINE int32 GetMagazineCapacity() const { return MagazineCapacity; }
+	FORCEINLINE void SetAmmo(int32 NewAmmo) { Ammo = FMath::Clamp(NewAmmo, 0, MagazineCapacity); }
 
 	// Called From character class when firing weapon
 	void DecrementAmmo();
 
 	FORCEINLINE EWeaponType GetWeaponType() const { return WeaponType; }
 	FORCEINLINE EAmmoType GetAmmoType() const { return AmmoType; }
+	FORCEINLINE const FShotShape& GetShotShape() const { return ShotShape; }
+	FORCEINLINE float GetSpreadAngle() const { return SpreadAngle; }
+	// Index of the shot being fired, advances the counter
+	FORCEINLINE uint32 ConsumeShotIndex() { return static_cast<uint32>(ShotCounter++); }
 	FORCEINLINE FName GetReloadMontageSection() const { return ReloadMontageSection; }
 	FORCEINLINE FName GetClipBoneName() const { return ClipBoneName; }
 